@@ -0,0 +1,553 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include "simulation.h"
+#include "cloth.h"
+#include "clothgeometry.h"
+#include "spherecollider.h"
+#include "floorcollider.h"
+#include "integrator.h"
+#include "threadpool.h"
+
+/*
+ * Benchmark
+ *  Times the phases of a simulation step for a range of grid sizes and integrators, in the
+ *  scene the windowed simulation runs. Every phase is reported in ns per knot per substep,
+ *  mean and standard deviation over a number of repetitions, so grids of different sizes can
+ *  be compared directly. Every grid is the same 16 by 16 cloth, and --dt is the step of the
+ *  33 grid, the finer grids take shorter steps.
+ *
+ *  The cloth collides with itself in every row. Afterwards one large grid is timed with the
+ *  explicit integrator with and without self collision, to show what it costs.
+ *
+ *  clothsim-bench [--grids 33,65,...] [--integrators 0,1,...] [--reps n] [--threads n] [--dt s]
+ *                 [--self-collision-grid n] [--csv file]
+ *
+ *  With --scaling the same step is instead timed at a range of thread counts. Strong scaling
+ *  keeps the grid fixed, weak scaling grows the grid with the threads so every thread has
+ *  the same number of knots. Both report the speedup in knots per second over one thread
+ *  and the efficiency, the speedup divided by the threads, for the step and its phases.
+ *
+ *  clothsim-bench --scaling strong|weak|both [--thread-counts 1,2,4,...] [--grid n]
+ *                 [--integrators 0,1,...] [--reps n] [--dt s] [--csv file]
+ */
+
+// Wall time of one repetition, fast grids take more steps to get a measurable time
+#define BENCH_REPETITION_TIME 0.2
+#define BENCH_MAX_STEPS 200
+#define BENCH_REPETITIONS 10
+
+// Projective dynamics factors a banded matrix, beyond this grid it needs gigabytes
+#define BENCH_MAX_PROJECTIVE_GRID 129
+
+// Grid timed with and without self collision, over 100k knots
+#define BENCH_SELF_COLLISION_GRID 513
+
+// Grid of the strong scaling sweep, and the grid of one thread in the weak scaling sweep
+#define SCALING_STRONG_GRID 257
+#define SCALING_WEAK_GRID 129
+
+// Below this efficiency an extra thread is not worth it
+#define SCALING_MIN_EFFICIENCY 0.5
+
+// Default substep, the windowed simulation runs about 15 of these per 60 Hz frame
+#define BENCH_DT ((1.0f / 60.0f) / 15.0f)
+
+// Every grid is the same cloth as the 33 knots 0.5 apart of the windowed simulation, so larger
+// grids time the same scene at a finer resolution. The knots are lighter so the cloth weighs
+// the same, and the step is shorter in proportion to the spacing so it stays as stable
+#define BENCH_CLOTH_SIZE 16.0f
+#define BENCH_KNOT_SPACING 0.5f
+
+// The phases we time, step is the three simulation phases together
+#define PHASE_STEP 0
+#define PHASE_COLLISIONS 1
+#define PHASE_SPRING_FORCE 2
+#define PHASE_INTEGRATE 3
+#define PHASE_GEOMETRY 4
+#define NUM_PHASES 5
+
+const char * phaseNames[NUM_PHASES] = { "step", "collisions", "springForce", "integrate", "geometry" };
+
+typedef std::chrono::steady_clock Clock;
+
+
+/*
+ * Mean and standard deviation of a set of samples
+ */
+struct Statistics {
+
+    Statistics(const std::vector<double> &samples) : mean(0.0), deviation(0.0) {
+
+        if(samples.empty())
+            return;
+
+        for(unsigned int i = 0; i < samples.size(); i++)
+            mean += samples[i];
+        mean /= samples.size();
+
+        if(samples.size() < 2)
+            return;
+
+        for(unsigned int i = 0; i < samples.size(); i++)
+            deviation += (samples[i] - mean) * (samples[i] - mean);
+        deviation = sqrt(deviation / (samples.size() - 1));
+    }
+
+    double mean;
+    double deviation;
+};
+
+
+void printUsage(const char *name) {
+
+    std::cout << "Usage: " << name << " [--grids 33,65,...] [--integrators 0-" << NUM_INTEGRATORS - 1
+              << ",...] [--reps n] [--threads n] [--dt s] [--self-collision-grid n] [--csv file]" << std::endl
+              << "       " << name << " --scaling strong|weak|both [--thread-counts 1,2,4,...] [--grid n] [--integrators 0-"
+              << NUM_INTEGRATORS - 1 << ",...] [--reps n] [--dt s] [--csv file]" << std::endl;
+}
+
+
+std::vector<unsigned int> parseList(const char *s) {
+
+    std::vector<unsigned int> list;
+    std::stringstream ss(s);
+    std::string item;
+
+    while(std::getline(ss, item, ','))
+        list.push_back(atoi(item.c_str()));
+
+    return list;
+}
+
+
+double nanoseconds(Clock::time_point start, Clock::time_point stop) {
+    return std::chrono::duration<double, std::nano>(stop - start).count();
+}
+
+
+/*
+ * Step of a grid, dt is the step of the 33 grid
+ */
+float getStep(unsigned int grid, float dt) {
+    return dt * (BENCH_CLOTH_SIZE / (grid - 1)) / BENCH_KNOT_SPACING;
+}
+
+
+/*
+ * Run one grid with one integrator. Returns the samples of every phase in ns/knot/substep,
+ * one per repetition
+ */
+std::vector<std::vector<double> > benchmark(unsigned int grid, unsigned int integrator, unsigned int reps, float dt,
+                                            bool selfCollision = true) {
+
+    const float spacing = BENCH_CLOTH_SIZE / (grid - 1);
+    const float scale = spacing / BENCH_KNOT_SPACING;
+
+    dt = getStep(grid, dt);
+
+    Simulation simulation;
+    simulation.setAcceleration(glm::vec3(0.0f, -1.0f, 0.0f) * 9.82f);
+    simulation.setIntegrator(integrator);
+    simulation.setDt(dt);
+
+    Cloth cloth(grid, spacing, glm::vec3(0.0f, 7.0f, 0.0f));
+    cloth.setSelfCollision(selfCollision);
+
+    for(unsigned int i = 0; i < cloth.getState()->size(); i++)
+        cloth.getState()->setMass(i, scale * scale);
+
+    // Pin five evenly spaced knots along the top row
+    for(unsigned int k = 0; k <= 4; k++)
+        cloth.setBodyStatic(grid * (grid - 1) + k * (grid - 1) / 4);
+
+    SphereCollider sphere(3.0f, glm::vec3(0.0f, 0.0f, 5.0f));
+    FloorCollider floor(glm::vec3(0.0f, -3.0f, 0.0f));
+
+    simulation.addCloth(&cloth);
+    simulation.addCollider(&sphere);
+    simulation.addCollider(&floor);
+
+    ClothGeometry geometry(grid);
+    geometry.create(*cloth.getState());
+
+    // Warm up, the first step builds the integrators buffers and factorizations. The second
+    // one tells how many steps fit in a repetition
+    simulation.step();
+    geometry.update(*cloth.getState());
+
+    Clock::time_point start = Clock::now();
+    simulation.step();
+    geometry.update(*cloth.getState());
+    double stepTime = nanoseconds(start, Clock::now()) * 1e-9;
+
+    double knots = static_cast<double>(grid) * grid;
+    unsigned int steps = static_cast<unsigned int>(std::max(1.0, std::min(static_cast<double>(BENCH_MAX_STEPS),
+                                                                          BENCH_REPETITION_TIME / stepTime)));
+
+    std::vector<std::vector<double> > samples(NUM_PHASES);
+
+    for(unsigned int rep = 0; rep < reps; rep++) {
+
+        double time[NUM_PHASES] = { 0.0, 0.0, 0.0, 0.0, 0.0 };
+
+        for(unsigned int i = 0; i < steps; i++) {
+
+            simulation.setTime((rep * steps + i + 2) * dt);
+
+            // The same phases in the same order as Simulation::step
+            Clock::time_point t0 = Clock::now();
+            simulation.checkCollisions();
+            Clock::time_point t1 = Clock::now();
+            simulation.applySpringForce();
+            Clock::time_point t2 = Clock::now();
+            simulation.integrateVelocities();
+            Clock::time_point t3 = Clock::now();
+
+            // What Mesh does every frame before it uploads the triangles
+            geometry.update(*cloth.getState());
+            Clock::time_point t4 = Clock::now();
+
+            time[PHASE_STEP] += nanoseconds(t0, t3);
+            time[PHASE_COLLISIONS] += nanoseconds(t0, t1);
+            time[PHASE_SPRING_FORCE] += nanoseconds(t1, t2);
+            time[PHASE_INTEGRATE] += nanoseconds(t2, t3);
+            time[PHASE_GEOMETRY] += nanoseconds(t3, t4);
+        }
+
+        for(unsigned int p = 0; p < NUM_PHASES; p++)
+            samples[p].push_back(time[p] / (knots * steps));
+    }
+
+    return samples;
+}
+
+
+/*
+ * Thread counts to sweep by default, the powers of two up to the cores of this machine and
+ * the number of cores itself
+ */
+std::vector<unsigned int> getDefaultThreadCounts() {
+
+    unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned int> counts;
+
+    for(unsigned int t = 1; t < cores; t *= 2)
+        counts.push_back(t);
+    counts.push_back(cores);
+
+    return counts;
+}
+
+
+/*
+ * Times every integrator at every thread count, with a fixed grid or one that grows with the
+ * threads. The times are per knot, so the speedup over the first thread count is the gain in
+ * knots per second both when the grid is fixed and when it grows, and the efficiency is the
+ * speedup over the ideal one
+ */
+void runScaling(bool weak, unsigned int grid, const std::vector<unsigned int> &integrators,
+                const std::vector<unsigned int> &threadCounts, unsigned int reps, float dt, std::ofstream &csv) {
+
+    const char *mode = weak ? "weak" : "strong";
+    std::ios::fmtflags flags = std::cout.flags();
+    std::streamsize precision = std::cout.precision();
+
+    std::cout << std::endl << (weak ? "Weak" : "Strong") << " scaling, "
+              << (weak ? "grid grows from " : "grid ") << grid << "x" << grid << ", dt " << dt << " s at 33x33, "
+              << reps << " repetitions" << std::endl;
+
+    for(unsigned int i = 0; i < integrators.size(); i++) {
+
+        std::cout << std::endl << getIntegratorName(integrators[i]) << " integrator" << std::endl
+                  << std::setw(8) << "threads" << std::setw(8) << "grid" << std::setw(22) << "step ms"
+                  << std::setw(10) << "speedup";
+        for(unsigned int p = 0; p < PHASE_GEOMETRY; p++)
+            std::cout << std::setw(18) << (std::string(phaseNames[p]) + " eff");
+        std::cout << std::endl;
+
+        double base[NUM_PHASES];
+        double baseThreads = 0.0;
+        unsigned int lastWorthIt = 0;
+
+        for(unsigned int t = 0; t < threadCounts.size(); t++) {
+
+            unsigned int threads = threadCounts[t];
+
+            // The same number of knots for every thread, the cloth needs an odd number of knots
+            // per side
+            unsigned int g = grid;
+            if(weak) {
+                double side = grid * sqrt(threads / static_cast<double>(threadCounts[0]));
+                g = std::max(5u, 2 * static_cast<unsigned int>(floor((side - 1.0) / 2.0 + 0.5)) + 1);
+            }
+
+            if(integrators[i] == INTEGRATOR_PROJECTIVE && g > BENCH_MAX_PROJECTIVE_GRID) {
+                std::cout << std::setw(8) << threads << std::setw(8) << g << "  skipped, the factorization is too large" << std::endl;
+                continue;
+            }
+
+            ThreadPool::instance()->setNumThreads(threads);
+
+            std::vector<std::vector<double> > samples = benchmark(g, integrators[i], reps, dt);
+            double knots = static_cast<double>(g) * g;
+
+            double mean[NUM_PHASES];
+            for(unsigned int p = 0; p < NUM_PHASES; p++)
+                mean[p] = Statistics(samples[p]).mean;
+
+            if(baseThreads == 0.0) {
+                for(unsigned int p = 0; p < NUM_PHASES; p++)
+                    base[p] = mean[p];
+                baseThreads = threads;
+            }
+
+            Statistics step(samples[PHASE_STEP]);
+
+            std::stringstream cell;
+            cell << std::fixed << std::setprecision(3) << step.mean * knots * 1e-6 << " +- " << step.deviation * knots * 1e-6;
+
+            double stepSpeedup = base[PHASE_STEP] / mean[PHASE_STEP];
+            double stepEfficiency = stepSpeedup * baseThreads / threads;
+
+            if(stepEfficiency >= SCALING_MIN_EFFICIENCY)
+                lastWorthIt = threads;
+
+            std::cout << std::setw(8) << threads << std::setw(8) << g << std::setw(22) << cell.str()
+                      << std::fixed << std::setprecision(2) << std::setw(10) << stepSpeedup;
+
+            for(unsigned int p = 0; p < NUM_PHASES; p++) {
+
+                Statistics s(samples[p]);
+                double speedup = base[p] / mean[p];
+                double efficiency = speedup * baseThreads / threads;
+
+                if(p < PHASE_GEOMETRY)
+                    std::cout << std::setw(18) << efficiency;
+
+                if(csv.is_open())
+                    csv << mode << "," << getIntegratorName(integrators[i]) << "," << threads << "," << g << ","
+                        << static_cast<unsigned int>(knots) << "," << phaseNames[p] << ","
+                        << s.mean * knots << "," << s.deviation * knots << "," << speedup << "," << efficiency << std::endl;
+            }
+
+            std::cout << std::endl;
+        }
+
+        if(lastWorthIt > 0)
+            std::cout << "Efficiency of the step stays above " << static_cast<int>(SCALING_MIN_EFFICIENCY * 100.0)
+                      << "% up to " << lastWorthIt << " threads" << std::endl;
+    }
+
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+}
+
+
+/*
+ * Times the step of a grid with the explicit integrator without and with self collision
+ */
+void runSelfCollision(unsigned int grid, unsigned int reps, float dt, std::ofstream &csv) {
+
+    std::ios::fmtflags flags = std::cout.flags();
+    std::streamsize precision = std::cout.precision();
+
+    const double knots = static_cast<double>(grid) * grid;
+    double step[2];
+
+    std::cout << std::endl << "Self collision at " << grid << "x" << grid << ", " << static_cast<unsigned int>(knots)
+              << " knots, " << getIntegratorName(INTEGRATOR_EXPLICIT) << " integrator, ms/substep (mean +- stddev)" << std::endl
+              << std::setw(16) << "self collision" << std::setw(22) << "step" << std::setw(22) << "collisions" << std::endl;
+
+    for(unsigned int on = 0; on < 2; on++) {
+
+        std::vector<std::vector<double> > samples = benchmark(grid, INTEGRATOR_EXPLICIT, reps, dt, on == 1);
+
+        std::cout << std::setw(16) << (on ? "on" : "off");
+
+        for(unsigned int p = 0; p < NUM_PHASES; p++) {
+
+            Statistics s(samples[p]);
+
+            if(p == PHASE_STEP)
+                step[on] = s.mean;
+
+            if(p == PHASE_STEP || p == PHASE_COLLISIONS) {
+                std::stringstream cell;
+                cell << std::fixed << std::setprecision(3) << s.mean * knots * 1e-6 << " +- " << s.deviation * knots * 1e-6;
+                std::cout << std::setw(22) << cell.str();
+            }
+
+            if(csv.is_open())
+                csv << grid << "," << getIntegratorName(INTEGRATOR_EXPLICIT) << ","
+                    << ThreadPool::instance()->getNumThreads() << "," << getStep(grid, dt) << ","
+                    << phaseNames[p] << "," << s.mean << "," << s.deviation << "," << reps << "," << on << std::endl;
+        }
+
+        std::cout << std::endl;
+    }
+
+    std::cout << std::fixed << std::setprecision(1) << "Self collision takes "
+              << 100.0 * (step[1] - step[0]) / step[1] << "% of the step, "
+              << 1e9 / (step[1] * knots) << " substeps/s with it" << std::endl;
+
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+}
+
+
+int main(int argc, char* argv[]) {
+
+    std::vector<unsigned int> grids;
+    grids.push_back(33);
+    grids.push_back(65);
+    grids.push_back(129);
+    grids.push_back(257);
+    grids.push_back(513);
+    grids.push_back(1025);
+
+    std::vector<unsigned int> integrators;
+    for(unsigned int i = 0; i < NUM_INTEGRATORS; i++)
+        integrators.push_back(i);
+
+    unsigned int reps = BENCH_REPETITIONS;
+    unsigned int threads = 0;
+    float dt = BENCH_DT;
+    std::string csvName;
+    std::string scaling;
+    std::vector<unsigned int> threadCounts = getDefaultThreadCounts();
+    unsigned int scalingGrid = 0;
+    unsigned int selfCollisionGrid = BENCH_SELF_COLLISION_GRID;
+
+    for(int i = 1; i < argc; i++) {
+
+        if(i + 1 < argc && strcmp(argv[i], "--grids") == 0)
+            grids = parseList(argv[++i]);
+        else if(i + 1 < argc && strcmp(argv[i], "--integrators") == 0)
+            integrators = parseList(argv[++i]);
+        else if(i + 1 < argc && strcmp(argv[i], "--reps") == 0)
+            reps = atoi(argv[++i]);
+        else if(i + 1 < argc && strcmp(argv[i], "--threads") == 0)
+            threads = atoi(argv[++i]);
+        else if(i + 1 < argc && strcmp(argv[i], "--dt") == 0)
+            dt = static_cast<float>(atof(argv[++i]));
+        else if(i + 1 < argc && strcmp(argv[i], "--csv") == 0)
+            csvName = argv[++i];
+        else if(i + 1 < argc && strcmp(argv[i], "--scaling") == 0)
+            scaling = argv[++i];
+        else if(i + 1 < argc && strcmp(argv[i], "--thread-counts") == 0)
+            threadCounts = parseList(argv[++i]);
+        else if(i + 1 < argc && strcmp(argv[i], "--grid") == 0)
+            scalingGrid = atoi(argv[++i]);
+        else if(i + 1 < argc && strcmp(argv[i], "--self-collision-grid") == 0)
+            selfCollisionGrid = atoi(argv[++i]);
+        else {
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    bool valid = reps > 0 && dt > 0.0f && !grids.empty() && !integrators.empty();
+    for(unsigned int i = 0; i < grids.size(); i++)
+        valid = valid && grids[i] >= 5;
+    for(unsigned int i = 0; i < integrators.size(); i++)
+        valid = valid && integrators[i] < NUM_INTEGRATORS;
+    for(unsigned int i = 0; i < threadCounts.size(); i++)
+        valid = valid && threadCounts[i] > 0;
+    valid = valid && !threadCounts.empty() && (scalingGrid == 0 || (scalingGrid >= 5 && scalingGrid % 2 == 1));
+    valid = valid && (selfCollisionGrid == 0 || selfCollisionGrid >= 5);
+    valid = valid && (scaling.empty() || scaling == "strong" || scaling == "weak" || scaling == "both");
+
+    if(!valid) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::ofstream csv;
+
+    if(!scaling.empty()) {
+
+        if(!csvName.empty()) {
+            csv.open(csvName.c_str());
+            if(!csv) {
+                std::cerr << "Could not open " << csvName << std::endl;
+                return EXIT_FAILURE;
+            }
+            csv << "mode,integrator,threads,grid,knots,phase,mean_ns_per_step,stddev_ns_per_step,speedup,efficiency" << std::endl;
+        }
+
+        std::cout << std::thread::hardware_concurrency() << " cores" << std::endl;
+
+        if(scaling != "weak")
+            runScaling(false, scalingGrid > 0 ? scalingGrid : SCALING_STRONG_GRID, integrators, threadCounts, reps, dt, csv);
+        if(scaling != "strong")
+            runScaling(true, scalingGrid > 0 ? scalingGrid : SCALING_WEAK_GRID, integrators, threadCounts, reps, dt, csv);
+
+        return EXIT_SUCCESS;
+    }
+
+    if(threads > 0)
+        ThreadPool::instance()->setNumThreads(threads);
+
+    if(!csvName.empty()) {
+        csv.open(csvName.c_str());
+        if(!csv) {
+            std::cerr << "Could not open " << csvName << std::endl;
+            return EXIT_FAILURE;
+        }
+        csv << "grid,integrator,threads,dt,phase,mean_ns,stddev_ns,reps,self_collision" << std::endl;
+    }
+
+    std::cout << ThreadPool::instance()->getNumThreads() << " threads, dt " << dt << " s at 33x33, "
+              << reps << " repetitions, ns/knot/substep (mean +- stddev)" << std::endl << std::endl;
+
+    std::cout << std::setw(6) << "grid" << std::setw(20) << "integrator";
+    for(unsigned int p = 0; p < NUM_PHASES; p++)
+        std::cout << std::setw(22) << phaseNames[p];
+    std::cout << std::endl;
+
+    for(unsigned int g = 0; g < grids.size(); g++) {
+        for(unsigned int i = 0; i < integrators.size(); i++) {
+
+            if(integrators[i] == INTEGRATOR_PROJECTIVE && grids[g] > BENCH_MAX_PROJECTIVE_GRID) {
+                std::cout << std::setw(6) << grids[g] << std::setw(20) << getIntegratorName(integrators[i])
+                          << "  skipped, the factorization is too large" << std::endl;
+                continue;
+            }
+
+            std::vector<std::vector<double> > samples = benchmark(grids[g], integrators[i], reps, dt);
+
+            std::cout << std::setw(6) << grids[g] << std::setw(20) << getIntegratorName(integrators[i]);
+
+            for(unsigned int p = 0; p < NUM_PHASES; p++) {
+
+                Statistics s(samples[p]);
+
+                std::stringstream cell;
+                cell << std::fixed << std::setprecision(2) << s.mean << " +- " << s.deviation;
+                std::cout << std::setw(22) << cell.str();
+
+                if(csv.is_open())
+                    csv << grids[g] << "," << getIntegratorName(integrators[i]) << ","
+                        << ThreadPool::instance()->getNumThreads() << "," << getStep(grids[g], dt) << ","
+                        << phaseNames[p] << "," << s.mean << "," << s.deviation << "," << reps << ",1" << std::endl;
+            }
+
+            std::cout << std::endl;
+        }
+    }
+
+    if(selfCollisionGrid > 0)
+        runSelfCollision(selfCollisionGrid, reps, dt, csv);
+
+    return EXIT_SUCCESS;
+}
@@ -1,7 +1,7 @@
 #include "floor.h"
 
 Floor::Floor(glm::vec3 p, float s, const std::string& t, bool is) 
-    : position(p), size(s), textureName(t), _isStatic(is) {
+    : position(p), size(s), textureName(t), _isStatic(is), collider(p) {
 
     velocity = glm::vec3(0.0f);
 
@@ -139,22 +139,6 @@ void Floor::init(glm::vec3 lightPos) {
 }
 
 
-void Floor::resolveCollision(Knot *k) {
-
-    if(k->getPosition().y < this->position.y) {
-
-        float dist = abs(k->getPosition().y - this->position.y);
-
-        glm::vec3 p = k->getPosition();
-
-        k->setPosition(glm::vec3(p.x, this->position.y + dist*4.0f, p.z));
-
-        k->setVelocity(glm::vec3(0.0f, 0.0f, 0.0f));
-        //k->setForce(glm::vec3(0.0f, 0.0f, 0.0f));
-    }
-}
-
-
 void Floor::createVertices() {
     mVertices.push_back(glm::vec3(-1.0f * size + position.x, -0.2f + position.y, -1.0f * size + position.z));
     mVertices.push_back(glm::vec3(-1.0f * size + position.x, -0.2f + position.y,  1.0f * size + position.z));
@@ -196,3 +180,16 @@ void Floor::createUVs() {
     mUvs.push_back(glm::vec2(1.0f, 1.0f));
     mUvs.push_back(glm::vec2(1.0f, 0.0f));
 }
+
+
+void Floor::reportMemory(MemoryReport &report) {
+
+    report.add("shapes", "Floor", sizeof(Floor));
+    report.add("floor", "mVertices", mVertices);
+    report.add("floor", "mFaceNormals", mFaceNormals);
+    report.add("floor", "mVertexNormals", mVertexNormals);
+    report.add("floor", "mUvs", mUvs);
+
+    report.add("GL buffers", "floor", mVertices.size() * sizeof(glm::vec3) + mVertexNormals.size() * sizeof(glm::vec3)
+                                      + mUvs.size() * sizeof(glm::vec2));
+}
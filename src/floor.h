@@ -7,6 +7,7 @@
 #include <glm/glm.hpp>
 #include <string>
 #include "shape.h"
+#include "floorcollider.h"
 #include "sgct.h"
 
 
@@ -21,26 +22,27 @@ public:
     void draw(glm::mat4&, glm::mat4&, glm::mat4&, glm::mat3&, unsigned int);
     void init(glm::vec3);
 
-    void resolveCollision(Knot *);
-
     void createVertices();
     void createFaceNormals();
     void createVertexNormals();
     void createUVs();
+    void reportMemory(MemoryReport &);
 
     // Getters
     unsigned int getType() { return FLOOR_SHAPE; };
     glm::vec3 getPosition() { return this->position; };
+    Collider * getCollider() { return &collider; };
     
     // Setters
     void setBodyStatic(int index) { _isStatic = true; };
-    void setPosition(glm::vec3 p) { position = p; };
+    void setPosition(glm::vec3 p) { position = p; collider.setPosition(p); };
 
 private:
     glm::vec3 position;
     glm::vec3 velocity;
     float size;
     bool _isStatic;
+    FloorCollider collider;
 
     // Data for OpenGL
     std::vector<glm::vec3> mVertices;
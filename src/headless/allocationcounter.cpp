@@ -0,0 +1,77 @@
+#include "allocationcounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    std::atomic<uint64_t> allocations(0);
+    std::atomic<uint64_t> bytes(0);
+
+    void * allocate(std::size_t size) {
+
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        bytes.fetch_add(size, std::memory_order_relaxed);
+
+        return std::malloc(size == 0 ? 1 : size);
+    }
+}
+
+
+uint64_t AllocationCounter::getAllocations() {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+
+uint64_t AllocationCounter::getBytes() {
+    return bytes.load(std::memory_order_relaxed);
+}
+
+
+/*
+ * The replacements of the global operator new and delete
+ */
+
+void * operator new(std::size_t size) {
+
+    void *p = allocate(size);
+
+    if(p == NULL)
+        throw std::bad_alloc();
+
+    return p;
+}
+
+
+void * operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+
+void * operator new(std::size_t size, const std::nothrow_t &) throw() {
+    return allocate(size);
+}
+
+
+void * operator new[](std::size_t size, const std::nothrow_t &) throw() {
+    return allocate(size);
+}
+
+
+void operator delete(void *p) throw() {
+    std::free(p);
+}
+
+
+void operator delete[](void *p) throw() {
+    std::free(p);
+}
+
+
+void operator delete(void *p, const std::nothrow_t &) throw() {
+    std::free(p);
+}
+
+
+void operator delete[](void *p, const std::nothrow_t &) throw() {
+    std::free(p);
+}
@@ -0,0 +1,21 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <stdint.h>
+
+/*
+ * AllocationCounter class
+ *  Counts every heap allocation made through operator new in the program it is linked into,
+ *  from every thread. allocationcounter.cpp replaces the global operator new and delete, so
+ *  it is only linked into the headless driver and never into the simulation library.
+ */
+
+class AllocationCounter {
+
+public:
+    // Getters
+    static uint64_t getAllocations();
+    static uint64_t getBytes();
+};
+
+#endif // ALLOCATIONCOUNTER_H
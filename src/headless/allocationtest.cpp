@@ -0,0 +1,124 @@
+#include "allocationtest.h"
+#include <iostream>
+#include "allocationcounter.h"
+#include "simulation.h"
+#include "cloth.h"
+#include "clothgeometry.h"
+#include "spherecollider.h"
+#include "floorcollider.h"
+#include "integrator.h"
+#include "profiler.h"
+
+#define ALLOCATION_SETUPS 5
+#define ALLOCATION_DT ((1.0f / 60.0f) / 15.0f)
+
+
+/*
+ * Steps a setup with an integrator the way the windowed simulation does, and counts the
+ * allocations after the warm up
+ */
+AllocationTest::Result AllocationTest::runCase(unsigned int setup, unsigned int integrator, bool profiling) {
+
+    Simulation simulation;
+    simulation.setAcceleration(glm::vec3(0.0f, -1.0f, 0.0f) * 9.82f);
+    simulation.setIntegrator(integrator);
+    simulation.setDt(ALLOCATION_DT);
+
+    Cloth cloth(33, 0.5f, glm::vec3(0.0f, 7.0f, 0.0f));
+    SphereCollider sphere(3.0f, glm::vec3(0.0f, 0.0f, 5.0f));
+    FloorCollider floor(glm::vec3(0.0f, -3.0f, 0.0f));
+
+    simulation.addCloth(&cloth);
+    simulation.addCollider(&sphere);
+    simulation.addCollider(&floor);
+
+    // The setups print what they load, keep the report readable
+    std::streambuf *out = std::cout.rdbuf(NULL);
+
+    switch(setup) {
+        case 1: cloth.setup1(); break;
+        case 2: cloth.setup2(); break;
+        case 3: cloth.setup3(); break;
+        case 4: cloth.setup4(); break;
+        case 5: cloth.setup5(); break;
+    }
+
+    std::cout.rdbuf(out);
+
+    const ClothState &state = *cloth.getState();
+
+    ClothGeometry geometry(33);
+    geometry.create(state);
+    geometry.computeTangentBasis();
+
+    Profiler::instance()->setEnabled(profiling);
+    Tracer::instance()->setEnabled(profiling);
+
+    Result result;
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+
+    for(unsigned int i = 0; i < ALLOCATION_WARMUP_STEPS + ALLOCATION_STEPS; i++) {
+
+        if(i == ALLOCATION_WARMUP_STEPS) {
+            allocations = AllocationCounter::getAllocations();
+            bytes = AllocationCounter::getBytes();
+        }
+
+        simulation.setTime(i * ALLOCATION_DT);
+        simulation.step();
+
+        // What Mesh::draw does besides OpenGL
+        geometry.update(state);
+        geometry.flipNormals(state);
+        geometry.flipMesh(state);
+        geometry.flipUvs(state);
+        geometry.flipUvs(state);
+
+        Profiler::instance()->endFrame();
+    }
+
+    result.allocations = AllocationCounter::getAllocations() - allocations;
+    result.bytes = AllocationCounter::getBytes() - bytes;
+
+    Profiler::instance()->setEnabled(false);
+    Tracer::instance()->setEnabled(false);
+    Profiler::instance()->clear();
+    Tracer::instance()->clear();
+
+    return result;
+}
+
+
+/*
+ * Runs every case, returns true when none of them allocated
+ */
+bool AllocationTest::run() {
+
+    unsigned int failures = 0;
+    unsigned int cases = 0;
+
+    for(unsigned int profiling = 0; profiling < 2; profiling++) {
+        for(unsigned int setup = 1; setup <= ALLOCATION_SETUPS; setup++) {
+            for(unsigned int integrator = 0; integrator < NUM_INTEGRATORS; integrator++) {
+
+                Result result = runCase(setup, integrator, profiling != 0);
+                bool passed = result.allocations == 0;
+
+                std::cout << (passed ? "ok   " : "FAIL ") << "setup " << setup << ", " << getIntegratorName(integrator)
+                          << " integrator" << (profiling ? ", profiling and tracing" : "") << ": "
+                          << result.allocations << " allocations (" << result.bytes << " bytes) in "
+                          << ALLOCATION_STEPS << " steps" << std::endl;
+
+                if(!passed)
+                    failures++;
+
+                cases++;
+            }
+        }
+    }
+
+    std::cout << (failures == 0 ? "All " : "") << cases - failures << " of " << cases << " cases made no allocations" << std::endl;
+
+    return failures == 0;
+}
@@ -0,0 +1,35 @@
+#ifndef ALLOCATIONTEST_H
+#define ALLOCATIONTEST_H
+
+// Steps taken before counting, the integrators size their buffers in the first steps
+#define ALLOCATION_WARMUP_STEPS 30
+
+// Steps counted, every one of them followed by a geometry update as when it is drawn
+#define ALLOCATION_STEPS 200
+
+#include <stdint.h>
+
+/*
+ * AllocationTest class
+ *  Checks that stepping the simulation and rebuilding the triangles to draw do not allocate
+ *  once they have warmed up. Runs setup 1 to 5 of the 33x33 cloth with every integrator, with
+ *  the profiler and tracer off and on, and counts the heap allocations of the steps after the
+ *  warm up with AllocationCounter. Every case must make none.
+ */
+
+class AllocationTest {
+
+public:
+    // Member functions
+    bool run();
+
+private:
+    struct Result {
+        uint64_t allocations;
+        uint64_t bytes;
+    };
+
+    Result runCase(unsigned int, unsigned int, bool);
+};
+
+#endif // ALLOCATIONTEST_H
@@ -0,0 +1,211 @@
+#include "bvhtest.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+#include "simulation.h"
+#include "cloth.h"
+#include "spherecollider.h"
+#include "floorcollider.h"
+#include "integrator.h"
+
+#define BVH_TEST_SETUPS 5
+#define BVH_TEST_DT ((1.0f / 60.0f) / 15.0f)
+
+
+/*
+ * Distance along the ray to the triangle abc, or a negative one when it misses. The same
+ * arithmetic as TriangleBVH::intersectRay
+ */
+static float intersectTriangle(const glm::vec3 &origin, const glm::vec3 &direction,
+                               const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c) {
+
+    const glm::vec3 e1 = b - a;
+    const glm::vec3 e2 = c - a;
+
+    glm::vec3 p = glm::cross(direction, e2);
+    float determinant = glm::dot(e1, p);
+
+    if(determinant == 0.0f)
+        return -1.0f;
+
+    float inverseDeterminant = 1.0f / determinant;
+    glm::vec3 s = origin - a;
+    float u = glm::dot(s, p) * inverseDeterminant;
+
+    if(u < 0.0f || u > 1.0f)
+        return -1.0f;
+
+    glm::vec3 q = glm::cross(s, e1);
+    float v = glm::dot(direction, q) * inverseDeterminant;
+
+    if(v < 0.0f || u + v > 1.0f)
+        return -1.0f;
+
+    return glm::dot(e2, q) * inverseDeterminant;
+}
+
+
+BVHTest::BVHTest()
+    : seed(12345) {
+
+}
+
+
+/*
+ * Uniform in [0, 1)
+ */
+float BVHTest::random() {
+    seed = seed * 1664525u + 1013904223u;
+    return static_cast<float>(seed >> 8) / static_cast<float>(1 << 24);
+}
+
+
+/*
+ * Queries boxes and rays around random knots, through the tree and through every triangle
+ */
+void BVHTest::check(const ClothState &state, const TriangleBVH &bvh, float spacing, Result &result) {
+
+    const std::vector<unsigned int> &triangles = bvh.getTriangles();
+    const unsigned int numTriangles = static_cast<unsigned int>(triangles.size() / 3);
+
+    for(unsigned int n = 0; n < BVH_TEST_QUERIES; n++) {
+
+        const glm::vec3 &knot = state.position[static_cast<unsigned int>(random() * state.size()) % state.size()];
+
+        // A box of up to two knot spacings around the knot
+        glm::vec3 size = glm::vec3(random(), random(), random()) * (2.0f * spacing);
+        glm::vec3 lower = knot - size;
+        glm::vec3 upper = knot + size;
+
+        found.clear();
+        bvh.queryBox(state, lower, upper, found);
+        std::sort(found.begin(), found.end());
+
+        expected.clear();
+        for(unsigned int t = 0; t < numTriangles; t++) {
+
+            const glm::vec3 &a = state.position[triangles[3 * t]];
+            const glm::vec3 &b = state.position[triangles[3 * t + 1]];
+            const glm::vec3 &c = state.position[triangles[3 * t + 2]];
+
+            glm::vec3 triangleLower = glm::min(a, glm::min(b, c));
+            glm::vec3 triangleUpper = glm::max(a, glm::max(b, c));
+
+            if(triangleLower.x <= upper.x && lower.x <= triangleUpper.x &&
+               triangleLower.y <= upper.y && lower.y <= triangleUpper.y &&
+               triangleLower.z <= upper.z && lower.z <= triangleUpper.z)
+                expected.push_back(t);
+        }
+
+        if(found != expected)
+            result.boxMismatches++;
+
+        // A ray from up to ten spacings away at the knot, it may pass other parts of the cloth first
+        glm::vec3 origin = knot + (glm::vec3(random(), random(), random()) - glm::vec3(0.5f)) * (20.0f * spacing);
+        glm::vec3 direction = glm::normalize(knot - origin);
+
+        float distance = FLT_MAX;
+        unsigned int triangle = 0;
+        bool hit = bvh.intersectRay(state, origin, direction, distance, triangle);
+
+        float closest = FLT_MAX;
+        for(unsigned int t = 0; t < numTriangles; t++) {
+
+            float d = intersectTriangle(origin, direction, state.position[triangles[3 * t]],
+                                        state.position[triangles[3 * t + 1]], state.position[triangles[3 * t + 2]]);
+
+            if(d >= 0.0f && d <= closest)
+                closest = d;
+        }
+
+        // Several triangles meet at the knot, the tree may skip all but one of them
+        if(hit != (closest < FLT_MAX) || (hit && std::fabs(distance - closest) > BVH_TEST_TOLERANCE * closest))
+            result.rayMismatches++;
+
+        result.queries++;
+    }
+}
+
+
+/*
+ * Steps a setup with an integrator and checks the queries every BVH_TEST_INTERVAL steps
+ */
+BVHTest::Result BVHTest::runCase(unsigned int setup, unsigned int integrator) {
+
+    Simulation simulation;
+    simulation.setAcceleration(glm::vec3(0.0f, -1.0f, 0.0f) * 9.82f);
+    simulation.setIntegrator(integrator);
+    simulation.setDt(BVH_TEST_DT);
+
+    Cloth cloth(33, 0.5f, glm::vec3(0.0f, 7.0f, 0.0f));
+    SphereCollider sphere(3.0f, glm::vec3(0.0f, 0.0f, 5.0f));
+    FloorCollider floor(glm::vec3(0.0f, -3.0f, 0.0f));
+
+    simulation.addCloth(&cloth);
+    simulation.addCollider(&sphere);
+    simulation.addCollider(&floor);
+
+    // The setups print what they load, keep the report readable
+    std::streambuf *out = std::cout.rdbuf(NULL);
+
+    switch(setup) {
+        case 1: cloth.setup1(); break;
+        case 2: cloth.setup2(); break;
+        case 3: cloth.setup3(); break;
+        case 4: cloth.setup4(); break;
+        case 5: cloth.setup5(); break;
+    }
+
+    std::cout.rdbuf(out);
+
+    cloth.setTriangleBVH(true);
+
+    Result result;
+    result.queries = 0;
+    result.boxMismatches = 0;
+    result.rayMismatches = 0;
+
+    for(unsigned int i = 1; i <= BVH_TEST_STEPS; i++) {
+
+        simulation.setTime(i * BVH_TEST_DT);
+        simulation.step();
+
+        if(i % BVH_TEST_INTERVAL == 0)
+            check(*cloth.getState(), *cloth.getTriangleBVH(), cloth.getKnotSpacing(), result);
+    }
+
+    return result;
+}
+
+
+/*
+ * Runs every case, returns true when the tree agreed with brute force in all of them
+ */
+bool BVHTest::run() {
+
+    unsigned int failures = 0;
+    unsigned int cases = 0;
+
+    for(unsigned int setup = 1; setup <= BVH_TEST_SETUPS; setup++) {
+        for(unsigned int integrator = 0; integrator < NUM_INTEGRATORS; integrator++) {
+
+            Result result = runCase(setup, integrator);
+            bool passed = result.boxMismatches == 0 && result.rayMismatches == 0;
+
+            std::cout << (passed ? "ok   " : "FAIL ") << "setup " << setup << ", " << getIntegratorName(integrator)
+                      << " integrator: " << result.boxMismatches << " of " << result.queries << " boxes and "
+                      << result.rayMismatches << " of " << result.queries << " rays differ from brute force" << std::endl;
+
+            if(!passed)
+                failures++;
+
+            cases++;
+        }
+    }
+
+    std::cout << (failures == 0 ? "All " : "") << cases - failures << " of " << cases
+              << " cases matched brute force" << std::endl;
+
+    return failures == 0;
+}
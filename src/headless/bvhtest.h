@@ -0,0 +1,53 @@
+#ifndef BVHTEST_H
+#define BVHTEST_H
+
+// Steps every setup runs, and how often the queries are checked in between
+#define BVH_TEST_STEPS 300
+#define BVH_TEST_INTERVAL 30
+
+// Boxes and rays per check
+#define BVH_TEST_QUERIES 64
+
+// Largest difference in the distance of a ray to the closest triangle, relative to the distance
+#define BVH_TEST_TOLERANCE 1e-5f
+
+#include <glm/glm.hpp>
+#include <vector>
+#include "clothstate.h"
+#include "trianglebvh.h"
+
+/*
+ * BVHTest class
+ *  Checks the TriangleBVH of a cloth against testing every triangle. Runs setup 1 to 5 of
+ *  the 33x33 cloth with every integrator, and every few steps queries boxes around random
+ *  knots and casts rays at them, through the tree and by brute force. The box queries must
+ *  find the same triangles and the rays the same closest distance, so boxes that lag behind
+ *  the knots or a tree that lost a triangle when it was rebuilt both fail.
+ */
+
+class BVHTest {
+
+public:
+    // Constructors
+    BVHTest();
+
+    // Member functions
+    bool run();
+
+private:
+    struct Result {
+        unsigned int queries;
+        unsigned int boxMismatches;
+        unsigned int rayMismatches;
+    };
+
+    Result runCase(unsigned int, unsigned int);
+    void check(const ClothState &, const TriangleBVH &, float, Result &);
+    float random();
+
+    unsigned int seed;
+    std::vector<unsigned int> found;
+    std::vector<unsigned int> expected;
+};
+
+#endif // BVHTEST_H
@@ -0,0 +1,107 @@
+#include "ccdtest.h"
+#include <algorithm>
+#include <iostream>
+#include "simulation.h"
+#include "cloth.h"
+#include "spherecollider.h"
+#include "integrator.h"
+
+#define CCD_TEST_DT ((1.0f / 60.0f) / 15.0f)
+
+
+CCDTest::CCDTest() {
+
+}
+
+
+/*
+ * Pushes the sphere through the cloth with an integrator, with or without continuous
+ * collisions, and counts the knots it left behind right after it is through
+ */
+CCDTest::Result CCDTest::runCase(unsigned int integrator, bool continuous) {
+
+    Simulation simulation;
+    simulation.setAcceleration(glm::vec3(0.0f, -1.0f, 0.0f) * 9.82f);
+    simulation.setIntegrator(integrator);
+    simulation.setDt(CCD_TEST_DT);
+    simulation.setStabilityControl(false);
+
+    // The hanging cloth of the windowed simulation, the sphere goes through its middle
+    Cloth cloth(33, 0.5f, glm::vec3(0.0f, 7.0f, 0.0f));
+    SphereCollider sphere(CCD_TEST_RADIUS, glm::vec3(0.0f, 7.0f, CCD_TEST_START));
+    sphere.setContinuous(continuous);
+
+    for(unsigned int k = 0; k <= 4; k++)
+        cloth.setBodyStatic(33 * 32 + k * 8);
+
+    simulation.addCloth(&cloth);
+    simulation.addCollider(&sphere);
+
+    // The knots meet the path of a step at the start of the next one, so the sphere is only
+    // through once it has not moved for a step
+    unsigned int steps = 0;
+    glm::vec3 p;
+
+    do {
+        p = sphere.getPosition();
+        sphere.moveTo(glm::vec3(p.x, p.y, std::max(p.z - CCD_TEST_STEP_TRAVEL, -CCD_TEST_START)));
+
+        simulation.setTime(steps * CCD_TEST_DT);
+        simulation.step();
+        steps++;
+
+    } while(p.z > -CCD_TEST_START);
+
+    // Knots within half the radius of the line the sphere moved along, between its middle and
+    // where it started. Knots hit by the sphere move as fast as it did, without rollbacks a few
+    // of them may already have blown up and be anywhere
+    const ClothState *state = cloth.getState();
+
+    Result result;
+    result.tunnelled = 0;
+
+    for(unsigned int k = 0; k < state->size(); k++) {
+
+        glm::vec3 d = state->position[k] - p;
+
+        if(d.x * d.x + d.y * d.y < 0.25f * CCD_TEST_RADIUS * CCD_TEST_RADIUS && d.z > 0.0f &&
+           state->position[k].z < CCD_TEST_START)
+            result.tunnelled++;
+    }
+
+    return result;
+}
+
+
+/*
+ * Runs every integrator with and without continuous collisions, returns true when only the
+ * discrete test let the sphere through
+ */
+bool CCDTest::run() {
+
+    unsigned int failures = 0;
+    unsigned int cases = 0;
+
+    for(unsigned int integrator = 0; integrator < NUM_INTEGRATORS; integrator++) {
+        for(unsigned int c = 0; c < 2; c++) {
+
+            bool continuous = c == 0;
+            Result result = runCase(integrator, continuous);
+            bool passed = continuous ? result.tunnelled == 0 : result.tunnelled > 0;
+
+            std::cout << (passed ? "ok   " : "FAIL ") << getIntegratorName(integrator) << " integrator, "
+                      << (continuous ? "continuous" : "discrete") << " collisions: " << result.tunnelled
+                      << " knots behind the sphere" << std::endl;
+
+            if(!passed)
+                failures++;
+
+            cases++;
+        }
+    }
+
+    std::cout << (failures == 0 ? "All " : "") << cases - failures << " of " << cases
+              << " cases behaved as expected" << std::endl;
+
+    return failures == 0;
+}
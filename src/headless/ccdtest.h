@@ -0,0 +1,39 @@
+#ifndef CCDTEST_H
+#define CCDTEST_H
+
+// Where the sphere starts in front of the middle of the cloth and how far it moves in a step,
+// more than its radius, until it is as far behind the cloth
+#define CCD_TEST_START 5.0f
+#define CCD_TEST_STEP_TRAVEL 7.0f
+#define CCD_TEST_RADIUS 3.0f
+
+#include "clothstate.h"
+
+/*
+ * CCDTest class
+ *  Checks that the continuous collisions of the sphere keep it from passing through the
+ *  cloth. Pushes a sphere through the middle of the hanging cloth of the windowed simulation,
+ *  further in one step than its radius, with every integrator. Once the sphere is through, no
+ *  knot in front of its middle may be left on the side it came from. The same sphere with
+ *  only the discrete test must leave knots there, or the check could not tell the two apart.
+ *  The steps are not rolled back, shorter substeps would hide what the collisions miss.
+ */
+
+class CCDTest {
+
+public:
+    // Constructors
+    CCDTest();
+
+    // Member functions
+    bool run();
+
+private:
+    struct Result {
+        unsigned int tunnelled;     // Knots left behind the sphere
+    };
+
+    Result runCase(unsigned int, bool);
+};
+
+#endif // CCDTEST_H
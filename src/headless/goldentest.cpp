@@ -0,0 +1,331 @@
+#include "goldentest.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include "simulation.h"
+#include "cloth.h"
+#include "spherecollider.h"
+#include "floorcollider.h"
+#include "integrator.h"
+#include "springkernel.h"
+
+#define GOLDEN_SETUPS 5
+#define GOLDEN_FLOOR_HEIGHT -3.0f
+
+
+GoldenTest::GoldenTest(const std::string &d)
+    : directory(d), springKernel(NUM_SPRING_KERNELS) {
+
+}
+
+
+/*
+ * Runs a setup with an integrator from scratch, the same scene as the windowed simulation
+ */
+GoldenTest::Result GoldenTest::runCase(unsigned int setup, unsigned int integrator, unsigned int runs) {
+
+    Result result;
+    result.energyGain = 0.0;
+    result.stepsPerSecond = 0.0;
+
+    const glm::vec3 G = glm::vec3(0.0f, -1.0f, 0.0f) * 9.82f;
+
+    for(unsigned int run = 0; run < runs; run++) {
+
+        Simulation simulation;
+        simulation.setAcceleration(G);
+        simulation.setIntegrator(integrator);
+        simulation.setDt(GOLDEN_DT);
+
+        Cloth cloth(33, 0.5f, glm::vec3(0.0f, 7.0f, 0.0f));
+        SphereCollider sphere(3.0f, glm::vec3(0.0f, 0.0f, 5.0f));
+        FloorCollider floor(glm::vec3(0.0f, GOLDEN_FLOOR_HEIGHT, 0.0f));
+
+        simulation.addCloth(&cloth);
+        simulation.addCollider(&sphere);
+        simulation.addCollider(&floor);
+
+        // The setups print what they load, keep the report readable
+        std::streambuf *out = std::cout.rdbuf(NULL);
+
+        switch(setup) {
+            case 1: cloth.setup1(); break;
+            case 2: cloth.setup2(); break;
+            case 3: cloth.setup3(); break;
+            case 4: cloth.setup4(); break;
+            case 5: cloth.setup5(); break;
+        }
+
+        std::cout.rdbuf(out);
+
+        if(springKernel < NUM_SPRING_KERNELS)
+            cloth.setSpringKernel(springKernel);
+
+        // Energy the cloth can release by falling to the floor and coming to rest
+        const ClothState &state = *cloth.getState();
+        double startEnergy = cloth.getEnergy(G);
+        double floorEnergy = 0.0;
+
+        for(unsigned int i = 0; i < state.size(); i++) {
+            if(!state.isPinned(i))
+                floorEnergy -= state.getMass(i) * G.y * GOLDEN_FLOOR_HEIGHT;
+        }
+
+        double releasable = std::max(startEnergy - floorEnergy, 1e-6);
+        double maxEnergy = startEnergy;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        for(unsigned int i = 0; i < GOLDEN_STEPS; i++) {
+            simulation.setTime(i * GOLDEN_DT);
+            simulation.step();
+
+            // Only the first run is checked, the others are for timing
+            if(run == 0)
+                maxEnergy = std::max(maxEnergy, cloth.getEnergy(G));
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if(run == 0) {
+            result.positions = state.position;
+            result.energyGain = (maxEnergy - startEnergy) / releasable;
+        }
+
+        result.stepsPerSecond = std::max(result.stepsPerSecond, GOLDEN_STEPS / seconds);
+    }
+
+    return result;
+}
+
+
+std::string GoldenTest::getFileName(unsigned int setup, unsigned int integrator) {
+
+    std::stringstream name;
+    name << directory << "/setup" << setup << "-integrator" << integrator << ".txt";
+
+    return name.str();
+}
+
+
+std::string GoldenTest::getBaselineFileName() {
+    return directory + "/baseline.txt";
+}
+
+
+bool GoldenTest::writePositions(const std::string &fileName, const std::vector<glm::vec3> &positions) {
+
+    std::ofstream file(fileName.c_str());
+
+    if(!file) {
+        std::cerr << "Could not open " << fileName << std::endl;
+        return false;
+    }
+
+    file << std::setprecision(9);
+
+    for(unsigned int i = 0; i < positions.size(); i++)
+        file << positions[i].x << " " << positions[i].y << " " << positions[i].z << std::endl;
+
+    return true;
+}
+
+
+bool GoldenTest::readPositions(const std::string &fileName, std::vector<glm::vec3> &positions) {
+
+    std::ifstream file(fileName.c_str());
+
+    if(!file)
+        return false;
+
+    positions.clear();
+
+    glm::vec3 p;
+    while(file >> p.x >> p.y >> p.z)
+        positions.push_back(p);
+
+    return true;
+}
+
+
+/*
+ * Steps per second of every setup and integrator, 0 where there is no baseline
+ */
+bool GoldenTest::readBaselines(std::vector<double> &baselines) {
+
+    baselines.assign((GOLDEN_SETUPS + 1) * NUM_INTEGRATORS, 0.0);
+
+    std::ifstream file(getBaselineFileName().c_str());
+
+    if(!file)
+        return false;
+
+    unsigned int setup, integrator;
+    double stepsPerSecond;
+
+    std::string line;
+
+    while(std::getline(file, line)) {
+
+        std::stringstream ss(line);
+
+        // Comments start with #
+        if(line.empty() || line[0] == '#' || !(ss >> setup >> integrator >> stepsPerSecond))
+            continue;
+
+        if(setup <= GOLDEN_SETUPS && integrator < NUM_INTEGRATORS)
+            baselines[setup * NUM_INTEGRATORS + integrator] = stepsPerSecond;
+    }
+
+    return true;
+}
+
+
+/*
+ * Runs every case and writes its positions as the new golden snapshot
+ */
+bool GoldenTest::recordSnapshots() {
+
+    for(unsigned int setup = 1; setup <= GOLDEN_SETUPS; setup++) {
+        for(unsigned int integrator = 0; integrator < NUM_INTEGRATORS; integrator++) {
+
+            Result result = runCase(setup, integrator, 1);
+
+            if(!writePositions(getFileName(setup, integrator), result.positions))
+                return false;
+
+            std::cout << "Recorded setup " << setup << ", " << getIntegratorName(integrator) << " integrator" << std::endl;
+        }
+    }
+
+    return true;
+}
+
+
+/*
+ * Runs every case and writes its speed as the new baseline of this machine
+ */
+bool GoldenTest::recordBaseline() {
+
+    std::ofstream baseline(getBaselineFileName().c_str());
+
+    if(!baseline) {
+        std::cerr << "Could not open " << getBaselineFileName() << std::endl;
+        return false;
+    }
+
+    baseline << "# setup integrator steps/s" << std::endl;
+
+    for(unsigned int setup = 1; setup <= GOLDEN_SETUPS; setup++) {
+        for(unsigned int integrator = 0; integrator < NUM_INTEGRATORS; integrator++) {
+
+            Result result = runCase(setup, integrator, PERFORMANCE_RUNS);
+
+            baseline << setup << " " << integrator << " " << result.stepsPerSecond << std::endl;
+
+            std::cout << "Setup " << setup << ", " << getIntegratorName(integrator) << " integrator, "
+                      << std::fixed << std::setprecision(0) << result.stepsPerSecond << " steps/s" << std::endl;
+        }
+    }
+
+    return true;
+}
+
+
+/*
+ * Runs every case and checks it against its golden snapshot and baseline. Returns true when
+ * all of them pass
+ */
+bool GoldenTest::verify(bool checkPerformance) {
+
+    std::vector<double> baselines;
+
+    if(checkPerformance && !readBaselines(baselines)) {
+        std::cout << "No baseline in " << getBaselineFileName() << ", not checking the performance" << std::endl;
+        checkPerformance = false;
+    }
+
+    unsigned int failures = 0;
+
+    for(unsigned int setup = 1; setup <= GOLDEN_SETUPS; setup++) {
+        for(unsigned int integrator = 0; integrator < NUM_INTEGRATORS; integrator++) {
+
+            std::stringstream report;
+            bool passed = true;
+
+            std::vector<glm::vec3> golden;
+            if(!readPositions(getFileName(setup, integrator), golden)) {
+                std::cout << "FAIL setup " << setup << ", " << getIntegratorName(integrator)
+                          << " integrator: no golden snapshot " << getFileName(setup, integrator) << std::endl;
+                failures++;
+                continue;
+            }
+
+            Result result = runCase(setup, integrator, checkPerformance ? PERFORMANCE_RUNS : 1);
+
+            // Positions
+            float error = 0.0f;
+            bool finite = true;
+            if(golden.size() != result.positions.size()) {
+                report << ", " << golden.size() << " golden knots but " << result.positions.size() << " knots";
+                passed = false;
+            } else {
+                for(unsigned int i = 0; i < golden.size(); i++) {
+                    float d = glm::length(result.positions[i] - golden[i]);
+
+                    if(d != d)
+                        finite = false;
+                    else
+                        error = std::max(error, d);
+                }
+
+                if(!finite) {
+                    report << ", knots are NaN";
+                    passed = false;
+                } else {
+                    report << ", error " << std::scientific << std::setprecision(2) << error;
+
+                    if(error > GOLDEN_TOLERANCE) {
+                        report << " > " << GOLDEN_TOLERANCE;
+                        passed = false;
+                    }
+                }
+            }
+
+            // Energy. XPBD springs are constraints with their own compliance, the energy of the
+            // stiffness springs is not what it conserves
+            if(integrator != INTEGRATOR_XPBD) {
+                report << ", energy gain " << std::fixed << std::setprecision(4) << result.energyGain;
+                if(!(result.energyGain <= ENERGY_DRIFT_TOLERANCE)) {
+                    report << " > " << ENERGY_DRIFT_TOLERANCE;
+                    passed = false;
+                }
+            }
+
+            // Performance
+            report << ", " << std::fixed << std::setprecision(0) << result.stepsPerSecond << " steps/s";
+            double baseline = checkPerformance ? baselines[setup * NUM_INTEGRATORS + integrator] : 0.0;
+            if(baseline > 0.0) {
+                report << " (baseline " << baseline << ")";
+                if(result.stepsPerSecond < PERFORMANCE_TOLERANCE * baseline) {
+                    report << " < " << std::setprecision(0) << PERFORMANCE_TOLERANCE * 100.0 << "% of baseline";
+                    passed = false;
+                }
+            }
+
+            std::cout << (passed ? "ok   " : "FAIL ") << "setup " << setup << ", " << getIntegratorName(integrator)
+                      << " integrator" << report.str() << std::endl;
+
+            if(!passed)
+                failures++;
+        }
+    }
+
+    std::cout << (failures == 0 ? "All " : "") << GOLDEN_SETUPS * NUM_INTEGRATORS - failures << " of "
+              << GOLDEN_SETUPS * NUM_INTEGRATORS << " cases passed" << std::endl;
+
+    return failures == 0;
+}
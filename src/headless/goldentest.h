@@ -0,0 +1,70 @@
+#ifndef GOLDENTEST_H
+#define GOLDENTEST_H
+
+// Every setup runs this many steps of GOLDEN_DT
+#define GOLDEN_STEPS 600
+#define GOLDEN_DT ((1.0f / 60.0f) / 15.0f)
+
+// Farthest a knot may end up from its golden position
+#define GOLDEN_TOLERANCE 1e-3f
+
+// Most the energy may grow above where it started, as a fraction of the energy the cloth
+// can release by falling to the floor. The cloth is damped, so it should only lose energy
+#define ENERGY_DRIFT_TOLERANCE 0.01
+
+// Slowest a setup may step, as a fraction of its recorded baseline
+#define PERFORMANCE_TOLERANCE 0.8
+
+// Runs per setup when timing it, the fastest one counts
+#define PERFORMANCE_RUNS 3
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+/*
+ * GoldenTest class
+ *  Runs setup 1 to 5 of the 33x33 cloth with every integrator for a fixed number of steps
+ *  and compares the knot positions with golden snapshots recorded earlier. It also checks
+ *  that the energy of the cloth did not grow, and that the steps per second did not fall
+ *  below a recorded baseline.
+ *
+ *  recordSnapshots() writes one text file per setup and integrator. The speed depends on the
+ *  machine, so recordBaseline() writes it separately to baseline.txt. Verifying with each spring kernel
+ *  against the same snapshots shows that the kernels give the same cloth.
+ */
+
+class GoldenTest {
+
+public:
+    // Constructors
+    GoldenTest(const std::string &);
+
+    // Member functions
+    bool recordSnapshots();
+    bool recordBaseline();
+    bool verify(bool);
+
+    // Setters
+    void setSpringKernel(unsigned int k) { springKernel = k; };
+
+private:
+    struct Result {
+        std::vector<glm::vec3> positions;
+        double energyGain;      // Largest energy growth, relative to the energy it can release
+        double stepsPerSecond;
+    };
+
+    Result runCase(unsigned int, unsigned int, unsigned int);
+    std::string getFileName(unsigned int, unsigned int);
+    std::string getBaselineFileName();
+
+    bool writePositions(const std::string &, const std::vector<glm::vec3> &);
+    bool readPositions(const std::string &, std::vector<glm::vec3> &);
+    bool readBaselines(std::vector<double> &);
+
+    std::string directory;
+    unsigned int springKernel;      // NUM_SPRING_KERNELS to use the one the cloth picks
+};
+
+#endif // GOLDENTEST_H
@@ -0,0 +1,424 @@
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <chrono>
+#include "simulation.h"
+#include "cloth.h"
+#include "clothgeometry.h"
+#include "spherecollider.h"
+#include "floorcollider.h"
+#include "distancefieldcollider.h"
+#include "integrator.h"
+#include "threadpool.h"
+#include "profiler.h"
+#include "goldentest.h"
+#include "allocationtest.h"
+#include "bvhtest.h"
+#include "ccdtest.h"
+#include "sdftest.h"
+#include "springkernel.h"
+#include "memoryreport.h"
+#include "autotuner.h"
+
+/*
+ * Headless driver
+ *  Runs the same scene as the windowed simulation, a pinned cloth falling on a sphere and a
+ *  floor, without opening a window and reports how fast it steps.
+ *
+ *  clothsim-headless [--grid n] [--steps n] [--setup 1-5] [--integrator 0-4] [--threads n] [--dt s] [--profile name]
+ *                    [--trace file] [--kernel 0-2] [--no-rollback]
+ *                    [--memory file] [--counters file] [--autotune file] [--no-self-collision]
+ *                    [--obstacle file] [--sphere-speed v] [--no-ccd] [--bvh]
+ *
+ *  Every grid is the same 16 by 16 cloth at a finer resolution, and without --dt the finer
+ *  grids take shorter steps than HEADLESS_DT for the 33 grid.
+ *
+ *  With --profile every step is a profiled frame, written to name.csv and name.json. With
+ *  --trace the steps are written to a Chrome trace. --no-rollback keeps unstable steps
+ *  instead of taking them again with a shorter dt. --memory reports the memory of every
+ *  subsystem after the setup and after every step, prints the steady state and the peak and
+ *  writes them to a CSV file. --counters reads the hardware counters of the CPU around every
+ *  phase of the step and around a rebuild of the triangles after every step, as when the
+ *  cloth is drawn, and prints the cache and branch misses and IPC of every phase and writes
+ *  their totals to a CSV file. --autotune picks the threads, spring kernel and springs per
+ *  task with AutoTuner before the run and caches them in a file, --threads and --kernel
+ *  still win over what it picked. --no-self-collision lets the cloth pass through itself.
+ *  --obstacle puts the closed mesh of an OBJ file in place of the sphere, as a
+ *  DistanceFieldCollider baked with HEADLESS_OBSTACLE_CELL cells and cached in file.sdf.
+ *  --sphere-speed pushes the sphere through the cloth along -z at v units per second, for
+ *  HEADLESS_SPHERE_TRAVEL units, and --no-ccd only tests where the knots end up instead of
+ *  their paths, to see them pass through a fast sphere. --bvh keeps a TriangleBVH over the
+ *  triangles of the cloth, refitted after every step, and prints how often it was rebuilt.
+ *
+ *  clothsim-headless --verify dir [--no-perf] [--kernel 0-2]
+ *  clothsim-headless --record dir
+ *  clothsim-headless --record-baseline dir
+ *
+ *  Checks setup 1 to 5 with every integrator against the golden snapshots in dir, or
+ *  records new snapshots or steps/s baselines, see GoldenTest. --verify exits with 1 if any case fails. --kernel forces
+ *  the scalar, SSE or AVX2 spring kernel instead of the fastest one the CPU supports.
+ *
+ *  clothsim-headless --check-allocations [--threads n]
+ *
+ *  Counts the heap allocations of the steps and geometry updates after a warm up, see
+ *  AllocationTest. Exits with 1 if any of them allocated.
+ *
+ *  clothsim-headless --check-bvh [--threads n]
+ *
+ *  Compares the box and ray queries of the triangle BVH with testing every triangle while
+ *  the setups run, see BVHTest. Exits with 1 if any of them differ.
+ *
+ *  clothsim-headless --check-ccd [--threads n]
+ *
+ *  Pushes a fast sphere through the cloth with and without continuous collisions, see
+ *  CCDTest. Exits with 1 if it passed through with them or did not without them.
+ *
+ *  clothsim-headless --check-sdf
+ *
+ *  Bakes the cube of models/cube.obj and compares the distance field and its collider with
+ *  the exact distance, see SDFTest. Exits with 1 if they differ.
+ */
+
+// Default substep, the windowed simulation runs about 15 of these per 60 Hz frame
+#define HEADLESS_DT ((1.0f / 60.0f) / 15.0f)
+
+// Every grid is the same cloth as the 33 knots 0.5 apart of the windowed simulation, at a
+// finer resolution. The knots are lighter so the cloth weighs the same, and the default step
+// is shorter, in proportion to the spacing, so it stays as stable
+#define HEADLESS_CLOTH_SIZE 16.0f
+#define HEADLESS_KNOT_SPACING 0.5f
+
+// Cells of the distance field of an --obstacle, a fifth of the knot spacing of the 33 grid
+#define HEADLESS_OBSTACLE_CELL 0.1f
+
+// How far --sphere-speed moves the sphere, from in front of the cloth to behind it
+#define HEADLESS_SPHERE_TRAVEL 10.0f
+
+void printUsage(const char *name) {
+
+    std::cout << "Usage: " << name << " [--grid n] [--steps n] [--setup 1-5] [--integrator 0-"
+              << NUM_INTEGRATORS - 1 << "] [--threads n] [--dt s] [--profile name] [--trace file] [--kernel 0-" << NUM_SPRING_KERNELS - 1 << "] [--no-rollback] [--memory file] [--counters file] [--autotune file] [--no-self-collision] [--obstacle file] [--sphere-speed v] [--no-ccd] [--bvh]" << std::endl
+              << "       " << name << " --verify dir [--no-perf] [--threads n] [--kernel 0-" << NUM_SPRING_KERNELS - 1 << "]" << std::endl
+              << "       " << name << " --record dir" << std::endl
+              << "       " << name << " --record-baseline dir [--threads n]" << std::endl
+              << "       " << name << " --check-allocations [--threads n]" << std::endl
+              << "       " << name << " --check-bvh [--threads n]" << std::endl
+              << "       " << name << " --check-ccd [--threads n]" << std::endl
+              << "       " << name << " --check-sdf" << std::endl;
+}
+
+
+
+/*
+ * Memory of the cloth, the simulation and the profiling buffers, the peaks are kept
+ */
+void measureMemory(MemoryReport &memory, Cloth &cloth, Simulation &simulation) {
+
+    memory.begin();
+
+    cloth.reportMemory(memory);
+    simulation.reportMemory(memory);
+    Profiler::instance()->reportMemory(memory);
+    Tracer::instance()->reportMemory(memory);
+
+    memory.end();
+}
+
+
+int main(int argc, char* argv[]) {
+
+    unsigned int grid = 33;
+    unsigned int steps = 1000;
+    unsigned int setup = 0;
+    unsigned int integrator = INTEGRATOR_EXPLICIT;
+    unsigned int threads = 0;
+    float dt = 0.0f;
+    float sphereSpeed = 0.0f;
+    std::string profileName;
+    std::string traceName;
+    std::string memoryName;
+    std::string countersName;
+    std::string tuningName;
+    std::string obstacleName;
+    std::string verifyDirectory;
+    std::string recordDirectory;
+    std::string baselineDirectory;
+    bool checkPerformance = true;
+    bool rollback = true;
+    bool checkAllocations = false;
+    bool checkBVH = false;
+    bool checkCCD = false;
+    bool checkSDF = false;
+    bool selfCollision = true;
+    bool continuous = true;
+    bool triangleBVH = false;
+    unsigned int kernel = NUM_SPRING_KERNELS;
+
+    for(int i = 1; i < argc; i++) {
+
+        if(i + 1 < argc && strcmp(argv[i], "--grid") == 0)
+            grid = atoi(argv[++i]);
+        else if(i + 1 < argc && strcmp(argv[i], "--steps") == 0)
+            steps = atoi(argv[++i]);
+        else if(i + 1 < argc && strcmp(argv[i], "--setup") == 0)
+            setup = atoi(argv[++i]);
+        else if(i + 1 < argc && strcmp(argv[i], "--integrator") == 0)
+            integrator = atoi(argv[++i]);
+        else if(i + 1 < argc && strcmp(argv[i], "--threads") == 0)
+            threads = atoi(argv[++i]);
+        else if(i + 1 < argc && strcmp(argv[i], "--dt") == 0)
+            dt = static_cast<float>(atof(argv[++i]));
+        else if(i + 1 < argc && strcmp(argv[i], "--profile") == 0)
+            profileName = argv[++i];
+        else if(i + 1 < argc && strcmp(argv[i], "--trace") == 0)
+            traceName = argv[++i];
+        else if(i + 1 < argc && strcmp(argv[i], "--memory") == 0)
+            memoryName = argv[++i];
+        else if(i + 1 < argc && strcmp(argv[i], "--counters") == 0)
+            countersName = argv[++i];
+        else if(i + 1 < argc && strcmp(argv[i], "--autotune") == 0)
+            tuningName = argv[++i];
+        else if(i + 1 < argc && strcmp(argv[i], "--obstacle") == 0)
+            obstacleName = argv[++i];
+        else if(i + 1 < argc && strcmp(argv[i], "--sphere-speed") == 0)
+            sphereSpeed = static_cast<float>(atof(argv[++i]));
+        else if(i + 1 < argc && strcmp(argv[i], "--verify") == 0)
+            verifyDirectory = argv[++i];
+        else if(i + 1 < argc && strcmp(argv[i], "--record") == 0)
+            recordDirectory = argv[++i];
+        else if(i + 1 < argc && strcmp(argv[i], "--record-baseline") == 0)
+            baselineDirectory = argv[++i];
+        else if(i + 1 < argc && strcmp(argv[i], "--kernel") == 0)
+            kernel = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--no-perf") == 0)
+            checkPerformance = false;
+        else if(strcmp(argv[i], "--check-allocations") == 0)
+            checkAllocations = true;
+        else if(strcmp(argv[i], "--check-bvh") == 0)
+            checkBVH = true;
+        else if(strcmp(argv[i], "--check-ccd") == 0)
+            checkCCD = true;
+        else if(strcmp(argv[i], "--check-sdf") == 0)
+            checkSDF = true;
+        else if(strcmp(argv[i], "--no-rollback") == 0)
+            rollback = false;
+        else if(strcmp(argv[i], "--no-self-collision") == 0)
+            selfCollision = false;
+        else if(strcmp(argv[i], "--no-ccd") == 0)
+            continuous = false;
+        else if(strcmp(argv[i], "--bvh") == 0)
+            triangleBVH = true;
+        else {
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // The setups pin knots by index and are written for the 33x33 cloth
+    if(grid < 5 || integrator >= NUM_INTEGRATORS || setup > 5 || (setup != 0 && grid != 33) || dt < 0.0f) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if(kernel < NUM_SPRING_KERNELS && !isSpringKernelSupported(kernel)) {
+        std::cerr << "This CPU does not support the " << getSpringKernelName(kernel) << " spring kernel" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if(threads > 0)
+        ThreadPool::instance()->setNumThreads(threads);
+
+    if(!recordDirectory.empty())
+        return GoldenTest(recordDirectory).recordSnapshots() ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if(!baselineDirectory.empty())
+        return GoldenTest(baselineDirectory).recordBaseline() ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if(checkAllocations)
+        return AllocationTest().run() ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if(checkBVH)
+        return BVHTest().run() ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if(checkCCD)
+        return CCDTest().run() ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if(checkSDF)
+        return SDFTest().run() ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if(!verifyDirectory.empty()) {
+        GoldenTest test(verifyDirectory);
+        test.setSpringKernel(kernel);
+        return test.verify(checkPerformance) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    const float spacing = HEADLESS_CLOTH_SIZE / (grid - 1);
+    const float scale = spacing / HEADLESS_KNOT_SPACING;
+
+    if(dt == 0.0f)
+        dt = HEADLESS_DT * scale;
+
+    Simulation simulation;
+    simulation.setAcceleration(glm::vec3(0.0f, -1.0f, 0.0f) * 9.82f);
+    simulation.setIntegrator(integrator);
+    simulation.setDt(dt);
+    simulation.setStabilityControl(rollback);
+
+    // Same scene as the windowed simulation
+    Cloth cloth(grid, spacing, glm::vec3(0.0f, 7.0f, 0.0f));
+    cloth.setSelfCollision(selfCollision);
+    cloth.setTriangleBVH(triangleBVH);
+
+    for(unsigned int i = 0; i < cloth.getState()->size(); i++)
+        cloth.getState()->setMass(i, scale * scale);
+
+    // Pin five evenly spaced knots along the top row
+    for(unsigned int k = 0; k <= 4; k++)
+        cloth.setBodyStatic(grid * (grid - 1) + k * (grid - 1) / 4);
+
+    SphereCollider sphere(3.0f, glm::vec3(0.0f, 0.0f, 5.0f));
+    FloorCollider floor(glm::vec3(0.0f, -3.0f, 0.0f));
+    DistanceFieldCollider obstacle;
+    sphere.setContinuous(continuous);
+
+    simulation.addCloth(&cloth);
+
+    if(obstacleName.empty()) {
+        simulation.addCollider(&sphere);
+    } else {
+        if(!obstacle.load(obstacleName, HEADLESS_OBSTACLE_CELL))
+            return EXIT_FAILURE;
+
+        simulation.addCollider(&obstacle);
+    }
+
+    simulation.addCollider(&floor);
+
+    switch(setup) {
+        case 1: cloth.setup1(); break;
+        case 2: cloth.setup2(); break;
+        case 3: cloth.setup3(); break;
+        case 4: cloth.setup4(); break;
+        case 5: cloth.setup5(); break;
+        default: break;
+    }
+
+    if(!tuningName.empty()) {
+        AutoTuner().tune(simulation, tuningName);
+
+        if(threads > 0)
+            ThreadPool::instance()->setNumThreads(threads);
+    }
+
+    if(kernel < NUM_SPRING_KERNELS)
+        cloth.setSpringKernel(kernel);
+
+    std::cout << "Grid " << grid << "x" << grid << ", " << getIntegratorName(integrator)
+              << " integrator, " << getSpringKernelName(cloth.getSpringKernel()) << " spring kernel, "
+              << ThreadPool::instance()->getNumThreads() << " threads, dt "
+              << dt << " s" << std::endl;
+
+    if(!profileName.empty())
+        Profiler::instance()->setEnabled(true);
+
+    if(!traceName.empty())
+        Tracer::instance()->setEnabled(true);
+
+    MemoryReport memory;
+    if(!memoryName.empty())
+        measureMemory(memory, cloth, simulation);
+
+    // The triangles are only rebuilt to count the geometry phases
+    ClothGeometry geometry(grid);
+    if(!countersName.empty()) {
+        geometry.create(*cloth.getState());
+
+        if(!Profiler::instance()->setCounting(true))
+            return EXIT_FAILURE;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    const float sphereStart = sphere.getPosition().z;
+
+    for(unsigned int i = 0; i < steps; i++) {
+
+        if(sphereSpeed > 0.0f) {
+            float z = std::max(sphereStart - HEADLESS_SPHERE_TRAVEL, sphereStart - sphereSpeed * (i + 1) * dt);
+            sphere.moveTo(glm::vec3(sphere.getPosition().x, sphere.getPosition().y, z));
+        }
+
+        simulation.setTime(i * dt);
+        simulation.step();
+
+        if(!countersName.empty())
+            geometry.update(*cloth.getState());
+
+        Profiler::instance()->endFrame();
+
+        if(!memoryName.empty())
+            measureMemory(memory, cloth, simulation);
+    }
+
+    std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+
+    Tracer::instance()->setEnabled(false);
+    double seconds = std::chrono::duration<double>(stop - start).count();
+
+    // Sum of all positions, to see that two runs did the same thing
+    ClothState *state = cloth.getState();
+    glm::vec3 checksum(0.0f, 0.0f, 0.0f);
+    for(unsigned int i = 0; i < state->size(); i++)
+        checksum += state->position[i];
+
+    std::cout << std::fixed << std::setprecision(3)
+              << steps << " steps in " << seconds << " s" << std::endl
+              << "Steps/s: " << steps / seconds << std::endl
+              << "Knot steps/s: " << std::setprecision(0) << steps * static_cast<double>(state->size()) / seconds << std::endl
+              << "Checksum: " << std::setprecision(6) << checksum.x << " " << checksum.y << " " << checksum.z << std::endl;
+
+    // The telemetry of the last step is measured by the next one
+    cloth.getForces()->measure(*state);
+    const ClothTelemetry &telemetry = simulation.getTelemetry(0);
+
+    std::cout << std::setprecision(3)
+              << "Kinetic energy: " << telemetry.kineticEnergy << ", elastic energy: " << telemetry.elasticEnergy
+              << ", max strain: " << telemetry.maxStrain << std::endl
+              << "Rolled back steps: " << simulation.getRollbacks() << std::endl
+              << "Failed steps: " << simulation.getFailedSteps() << std::endl;
+
+    if(cloth.getTriangleBVH() != NULL) {
+
+        const TriangleBVH *bvh = cloth.getTriangleBVH();
+
+        std::cout << "Triangle BVH: " << bvh->getNumTriangles() << " triangles, " << bvh->getNumNodes() << " nodes, "
+                  << bvh->getNumRefits() << " refits, " << bvh->getNumBuilds() << " builds, boxes "
+                  << bvh->getQuality() << " times their area after the last build" << std::endl;
+    }
+
+    if(!profileName.empty() && !Profiler::instance()->dump(profileName))
+        return EXIT_FAILURE;
+
+    if(!traceName.empty() && !Tracer::instance()->write(traceName))
+        return EXIT_FAILURE;
+
+    if(!countersName.empty()) {
+        Profiler::instance()->writeCounters(std::cout);
+        Profiler::instance()->setCounting(false);
+
+        if(!Profiler::instance()->writeCountersCSV(countersName))
+            return EXIT_FAILURE;
+    }
+
+    if(!memoryName.empty()) {
+        memory.write(std::cout, state->size());
+
+        if(!memory.writeCSV(memoryName))
+            return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,194 @@
+#include "sdftest.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include "clothstate.h"
+#include "distancefieldcollider.h"
+
+
+/*
+ * Exact signed distance from p to the cube, and through which face it is closest. The
+ * margin is how much closer that face is than any other, less than zero on an edge or where
+ * two faces are equally far inside
+ */
+static float getCubeDistance(const glm::vec3 &p, glm::vec3 &normal, float &margin) {
+
+    const glm::vec3 q = glm::abs(p) - glm::vec3(SDF_TEST_HALF_WIDTH);
+
+    unsigned int axis = 0;
+    if(q.y > q[axis]) axis = 1;
+    if(q.z > q[axis]) axis = 2;
+
+    float second = -HUGE_VALF;
+    for(unsigned int a = 0; a < 3; a++)
+        if(a != axis)
+            second = std::max(second, q[a]);
+
+    normal = glm::vec3(0.0f, 0.0f, 0.0f);
+    normal[axis] = p[axis] < 0.0f ? -1.0f : 1.0f;
+
+    // Outside a face is closest while the point is over it
+    margin = std::min(q[axis], 0.0f) - second;
+
+    glm::vec3 outside = glm::max(q, glm::vec3(0.0f));
+    return q[axis] > 0.0f ? glm::length(outside) : q[axis];
+}
+
+
+SDFTest::SDFTest()
+    : seed(12345) {
+
+}
+
+
+/*
+ * Uniform in [0, 1)
+ */
+float SDFTest::random() {
+    seed = seed * 1664525u + 1013904223u;
+    return static_cast<float>(seed >> 8) / static_cast<float>(1 << 24);
+}
+
+
+/*
+ * Uniform in the cube grown by the border on every side
+ */
+glm::vec3 SDFTest::randomPoint(float border) {
+    const float w = SDF_TEST_HALF_WIDTH + border;
+    return glm::vec3(random(), random(), random()) * (2.0f * w) - glm::vec3(w);
+}
+
+
+/*
+ * Queries points within the cells padded around the cube, where one face is closest by more
+ * than two cells
+ */
+bool SDFTest::checkField(const DistanceField &field) {
+
+    std::vector<glm::vec3> points;
+    std::vector<glm::vec3> normals;
+    std::vector<float> expected;
+
+    while(points.size() < SDF_TEST_QUERIES) {
+
+        glm::vec3 p = randomPoint(DISTANCE_FIELD_PADDING * SDF_TEST_CELL);
+        glm::vec3 normal;
+        float margin;
+        float d = getCubeDistance(p, normal, margin);
+
+        if(margin <= 2.0f * SDF_TEST_CELL)
+            continue;
+
+        points.push_back(p);
+        normals.push_back(normal);
+        expected.push_back(d);
+    }
+
+    std::vector<float> distance(points.size());
+    std::vector<glm::vec3> gradient(points.size());
+    field.query(&points[0], static_cast<unsigned int>(points.size()), &distance[0], &gradient[0]);
+
+    float distanceError = 0.0f;
+    float gradientError = 0.0f;
+
+    for(unsigned int p = 0; p < points.size(); p++) {
+
+        // NaN fails every comparison, so the errors are written to keep it
+        float e = std::fabs(distance[p] - expected[p]);
+        if(!(e <= distanceError))
+            distanceError = e;
+
+        e = glm::length(gradient[p] - normals[p]);
+        if(!(e <= gradientError))
+            gradientError = e;
+    }
+
+    bool passed = distanceError <= SDF_TEST_TOLERANCE && gradientError <= SDF_TEST_TOLERANCE;
+
+    std::cout << (passed ? "ok   " : "FAIL ") << points.size() << " queries, distance off by up to "
+              << distanceError << ", gradient by up to " << gradientError << std::endl;
+
+    return passed;
+}
+
+
+/*
+ * Puts knots anywhere inside the cube, one resolveCollisions must push every one of them out
+ */
+bool SDFTest::checkCollider() {
+
+    DistanceFieldCollider collider;
+
+    // Loading prints what was baked or read, keep the report readable
+    std::streambuf *out = std::cout.rdbuf(NULL);
+    bool loaded = collider.load(SDF_TEST_MODEL, SDF_TEST_CELL);
+    std::cout.rdbuf(out);
+
+    if(!loaded) {
+        std::cout << "FAIL could not load " << SDF_TEST_MODEL << std::endl;
+        return false;
+    }
+
+    ClothState state;
+
+    while(state.size() < SDF_TEST_KNOTS) {
+
+        glm::vec3 p = randomPoint(0.0f);
+        glm::vec3 normal;
+        float margin;
+
+        // Where two faces are equally far the gradient vanishes, no direction is out
+        if(getCubeDistance(p, normal, margin) < 0.0f && margin > 2.0f * SDF_TEST_CELL)
+            state.addKnot(p);
+    }
+
+    state.setPreviousPosition();
+    collider.resolveCollisions(state, 0, state.size());
+
+    unsigned int inside = 0;
+    float closest = HUGE_VALF;
+
+    for(unsigned int i = 0; i < state.size(); i++) {
+
+        glm::vec3 normal;
+        float margin;
+        float d = getCubeDistance(state.position[i], normal, margin);
+
+        if(!(d >= collider.getThickness() - SDF_TEST_TOLERANCE))
+            inside++;
+
+        closest = std::min(closest, d);
+    }
+
+    bool passed = inside == 0;
+
+    std::cout << (passed ? "ok   " : "FAIL ") << inside << " of " << state.size()
+              << " knots still closer than the thickness, the closest " << closest << " from the cube" << std::endl;
+
+    return passed;
+}
+
+
+/*
+ * Returns true when the field and the collider agree with the cube
+ */
+bool SDFTest::run() {
+
+    std::vector<glm::vec3> vertices;
+    std::vector<unsigned int> triangles;
+    uint64_t hash = 0;
+
+    if(!DistanceFieldCollider::readOBJ(SDF_TEST_MODEL, vertices, triangles, hash))
+        return false;
+
+    DistanceField field;
+    field.bake(vertices, triangles, SDF_TEST_CELL);
+
+    bool passed = checkField(field);
+    passed = checkCollider() && passed;
+
+    std::cout << (passed ? "The distance field matched the cube" : "The distance field did not match the cube") << std::endl;
+
+    return passed;
+}
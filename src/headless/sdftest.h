@@ -0,0 +1,50 @@
+#ifndef SDFTEST_H
+#define SDFTEST_H
+
+// Closed cube baked by the check, and half its width
+#define SDF_TEST_MODEL "models/cube.obj"
+#define SDF_TEST_HALF_WIDTH 1.5f
+
+// Cells of the field, the same as of an --obstacle
+#define SDF_TEST_CELL 0.1f
+
+// Points queried and knots pushed out
+#define SDF_TEST_QUERIES 4096
+#define SDF_TEST_KNOTS 256
+
+// Largest difference from the exact distance and normal
+#define SDF_TEST_TOLERANCE 1e-4f
+
+#include <glm/glm.hpp>
+#include "distancefield.h"
+
+/*
+ * SDFTest class
+ *  Checks the DistanceField and DistanceFieldCollider against the exact distance to a cube.
+ *  Bakes the cube of SDF_TEST_MODEL and queries random points in and around it. Where one
+ *  face of the cube is closest by more than two cells the field is linear across the cells
+ *  around the point, so the interpolated distance and gradient must be the distance to that
+ *  face and its normal. Points closer to an edge or to the middle of the cube are skipped,
+ *  the field is only sampled there. Then the cube is loaded into a collider like an
+ *  --obstacle, and knots put anywhere inside must be out of it after one resolveCollisions.
+ */
+
+class SDFTest {
+
+public:
+    // Constructors
+    SDFTest();
+
+    // Member functions
+    bool run();
+
+private:
+    bool checkField(const DistanceField &);
+    bool checkCollider();
+    glm::vec3 randomPoint(float);
+    float random();
+
+    unsigned int seed;
+};
+
+#endif // SDFTEST_H
@@ -4,6 +4,23 @@
 #include "mesh.h"
 #include "floor.h"
 #include "sphere.h"
+#include "stepscheduler.h"
+#include "profiler.h"
+
+// Profiled frames are written to PROFILE_FILE.csv and PROFILE_FILE.json
+#define PROFILE_FILE "profile"
+
+// Chrome trace of the frames while tracing was on
+#define TRACE_FILE "trace.json"
+
+// Memory of every subsystem, steady and peak
+#define MEMORY_FILE "memory.csv"
+
+// Frames between memory reports while the profiler is off
+#define MEMORY_INTERVAL 60
+
+// Hardware counters of every phase while they were on
+#define COUNTERS_FILE "counters.csv"
 
 void init();
 void draw();
@@ -38,12 +55,18 @@ bool play_pause = false;
 // Wind or not?
 bool wind = false;
 
-// How many simulations per frame
-const unsigned int simulations_per_frame = 15;
+// Decides how many simulations to run per frame and how long they are
+StepScheduler scheduler;
 
 // Camera rotation
 sgct::SharedObject<glm::mat4> cameraRot;
 
+// Spring kernel the master tuned, the other nodes step the cloth with it too
+sgct::SharedObject<unsigned int> springKernel;
+
+// Frames since the memory was last measured
+unsigned int memoryFrames = 0;
+
 // How fast shall the camera rotation be?
 const float rotationSpeed = 0.2f;
 
@@ -111,14 +134,30 @@ void init() {
     floor_ = new Body(new Floor(glm::vec3(0.0f, -3.0f, 0.0f), 30.0f, "checker"));
     scene->addBody(floor_);
     
-    scene->init();
+    scene->init(gEngine->isMaster());
+
+    if(gEngine->isMaster())
+        springKernel.setVal(scene->getSpringKernel());
 }
 
 
 void draw() {
+
+    TraceScope trace("drawCallback");
+
+    // The cloth of every node moves the same only with the same spring kernel
+    if(!gEngine->isMaster())
+        scene->setSpringKernel(springKernel.getVal());
+
+    // Catch up with the time since the last frame, with steps short enough for the scene
+    if(play_pause)
+        scheduler.advance(curr_time.getVal(), scene->getMaxStep());
+    else
+        scheduler.skip(curr_time.getVal());
+
     // Set current time and step size for the simulation
     scene->setTime(static_cast<float>(curr_time.getVal()));
-    scene->setDt((1.0f / 60.0f) / static_cast<float>(simulations_per_frame));
+    scene->setDt(scheduler.getDt());
 
     if(wind)
         cloth->getShape()->setWindForce(glm::vec3(1.0 - sin(curr_time.getVal() * 1.0) * 0.1, 0.0f, (sin(curr_time.getVal())) / 200.0f ));
@@ -127,17 +166,28 @@ void draw() {
 
     // Step the simulation one time step forward if it is not paused
     if(play_pause) {
-        for(unsigned int i = 0; i < simulations_per_frame; i++) {
+        for(unsigned int i = 0; i < scheduler.getSubsteps(); i++) {
             scene->step();
         }
     }
 
     // Draw the scene with the current scene matrices
     scene->draw(gEngine->getActiveModelViewProjectionMatrix(), gEngine->getActiveModelViewMatrix(), cameraRot.getVal(), drawType);
+
+    // Measuring walks every subsystem, so it is done every frame only while profiling
+    if(Profiler::instance()->isEnabled() || ++memoryFrames >= MEMORY_INTERVAL) {
+        scene->measureMemory();
+        memoryFrames = 0;
+    }
+
+    Profiler::instance()->endFrame();
 }
 
 
 void preSync() {
+
+    TraceScope trace("preSync");
+
     if(gEngine->isMaster()) {
         curr_time.setVal(sgct::Engine::getTime());
 
@@ -173,12 +223,14 @@ void preSync() {
 void encode() {
     sgct::SharedData::instance()->writeDouble(&curr_time);
     sgct::SharedData::instance()->writeObj(&cameraRot);
+    sgct::SharedData::instance()->writeObj(&springKernel);
 }
 
 
 void decode() {
     sgct::SharedData::instance()->readDouble(&curr_time);
     sgct::SharedData::instance()->readObj(&cameraRot);
+    sgct::SharedData::instance()->readObj(&springKernel);
 }
 
 
@@ -288,6 +340,82 @@ void keyCallback(int key, int action)
             }
             break;
 
+        // Cycle through the integrators
+        case SGCT_KEY_I:
+            if (action == SGCT_PRESS) {
+                scene->setIntegrator((scene->getIntegrator() + 1) % NUM_INTEGRATORS);
+                std::cout << "Using " << getIntegratorName(scene->getIntegrator()) << " integrator" << std::endl;
+            }
+            break;
+
+        // Start or stop timing the phases of every frame
+        case SGCT_KEY_P:
+            if (action == SGCT_PRESS) {
+                Profiler::instance()->setEnabled(!Profiler::instance()->isEnabled());
+                std::cout << "Profiler " << (Profiler::instance()->isEnabled() ? "on" : "off") << std::endl;
+            }
+            break;
+
+        // Write the profiled frames to profile.csv and profile.json
+        case SGCT_KEY_O:
+            if (action == SGCT_PRESS)
+                Profiler::instance()->dump(PROFILE_FILE);
+            break;
+
+        // Start or stop tracing, the trace is written to trace.json when it stops
+        case SGCT_KEY_T:
+            if (action == SGCT_PRESS) {
+                if(Tracer::instance()->isEnabled()) {
+                    Tracer::instance()->setEnabled(false);
+                    Tracer::instance()->write(TRACE_FILE);
+                } else {
+                    Tracer::instance()->clear();
+                    Tracer::instance()->setEnabled(true);
+                    std::cout << "Tracing" << std::endl;
+                }
+            }
+            break;
+
+        // Print the energy and strain of the cloths and how often a step was rolled back
+        case SGCT_KEY_M:
+            if (action == SGCT_PRESS) {
+                Simulation *simulation = scene->getSimulation();
+
+                for(unsigned int c = 0; c < simulation->getCloths().size(); c++) {
+                    const ClothTelemetry &telemetry = simulation->getTelemetry(c);
+                    std::cout << "Cloth " << c << ": kinetic energy " << telemetry.kineticEnergy
+                              << ", elastic energy " << telemetry.elasticEnergy
+                              << ", max strain " << telemetry.maxStrain << std::endl;
+                }
+
+                std::cout << simulation->getRollbacks() << " steps rolled back, " << simulation->getFailedSteps()
+                          << " failed, step limit " << simulation->getStepLimit() << std::endl;
+            }
+            break;
+
+        // Print how much memory every subsystem takes and write it to memory.csv
+        case SGCT_KEY_B:
+            if (action == SGCT_PRESS) {
+                scene->measureMemory();
+                scene->getMemoryReport()->write(std::cout, scene->getNumKnots());
+                scene->getMemoryReport()->writeCSV(MEMORY_FILE);
+            }
+            break;
+
+        // Start or stop reading the hardware counters, when they stop the cache and branch
+        // misses of every phase are printed and written to counters.csv
+        case SGCT_KEY_H:
+            if (action == SGCT_PRESS) {
+                if(Profiler::instance()->isCounting()) {
+                    Profiler::instance()->writeCounters(std::cout);
+                    Profiler::instance()->writeCountersCSV(COUNTERS_FILE);
+                    Profiler::instance()->setCounting(false);
+                } else if(Profiler::instance()->setCounting(true)) {
+                    std::cout << "Counting" << std::endl;
+                }
+            }
+            break;
+
         case SGCT_KEY_N:
             if (action == SGCT_PRESS) {
                 cloth->getShape()->setAllBodiesNonStatic();
@@ -326,6 +454,19 @@ void mouseButtonCallback(int button, int action) {
 
 
 void cleanUp() {
+    if(Tracer::instance()->isEnabled()) {
+        Tracer::instance()->setEnabled(false);
+        Tracer::instance()->write(TRACE_FILE);
+    }
+
+    if(Profiler::instance()->getNumFrames() > 0)
+        Profiler::instance()->dump(PROFILE_FILE);
+
+    if(scene->getMemoryReport()->getNumReports() > 0) {
+        scene->measureMemory();
+        scene->getMemoryReport()->writeCSV(MEMORY_FILE);
+    }
+
     delete scene;
     delete cloth;
 }
\ No newline at end of file
@@ -6,23 +6,28 @@
 #define DRAW_POINTS 0
 #define DRAW_SURFACE 1
 
+// The spheres drawn on the knots
+#define KNOT_SPHERE_RADIUS 0.1f
+#define KNOT_SPHERE_SEGMENTS 5
+
 #include <iostream>
 #include <vector>
 #include "sgct.h"
 #include "shape.h"
-#include "knot.h"
+#include "cloth.h"
+#include "clothgeometry.h"
 
 /*
  * Mesh class for the cloth
- *  This class contains/handles all the knots(vertecies) needed to create a cloth-like mesh.
- *  A Mesh is a shape
+ *  This class draws a Cloth, the knots(vertecies) and the physics live in the Cloth and the
+ *  triangles in a ClothGeometry. A Mesh is a shape
  */
 
 class Mesh : public Shape {
 
 public:
     // Constructors
-    Mesh() { };
+    Mesh() : cloth(NULL) { };
     Mesh(unsigned int, float, glm::vec3);
     Mesh(unsigned int, float, glm::vec3, std::string, std::string);
 
@@ -30,38 +35,14 @@ public:
     ~Mesh();
 
     // Member functions
-    void addKnot(Knot *, unsigned int);
-    void createKnots();
-    void createKnotNeighbors();
     void createKnotPoints();
-    void createVertices();
-    void createColorVector(glm::vec3);
-    void createFaceNormals();
-    void createVertexNormals();
-    glm::vec3 computeVertexNormal(std::vector<unsigned int>);
-    void createVertexNormalsList();
-    void createUVs();
-    void computeTangentBasis(std::vector<glm::vec3>&,
-                             std::vector<glm::vec2>&,
-                             std::vector<glm::vec3>&,
-                             std::vector<glm::vec3>&,
-                             std::vector<glm::vec3>&);
-
-    // Functions that updates data for OpenGL every frame
-    void updateVertices();
-    void updateFaceNormals();
-    void updateVertexNormals();
-    void updateVertexNormalsList();
-    void flipNormals();
-    void flipUvs();
-    void flipMesh();
 
     // Some initial setups for the mesh
-    void setup1();
-    void setup2();
-    void setup3();
-    void setup4();
-    void setup5();
+    void setup1() { cloth->setup1(); };
+    void setup2() { cloth->setup2(); };
+    void setup3() { cloth->setup3(); };
+    void setup4() { cloth->setup4(); };
+    void setup5() { cloth->setup5(); };
 
     void draw(glm::mat4&, glm::mat4&, glm::mat4&, glm::mat3&, unsigned int);
     void drawSurface(glm::mat4&, glm::mat4&, glm::mat4&, glm::mat3&);
@@ -71,24 +52,21 @@ public:
     void initSurface(glm::vec3);
     void initKnotDrawing(glm::vec3);
 
-    void reset();
-
-    void applySpringForce(float, float, glm::vec3);
-    void integrateVelocity(const glm::vec3, float);
-    void applyG(const glm::vec3, float);
-    void resolveCollision(Knot *);
-    void enforceMaximumStretch();
+    void reset() { cloth->reset(); };
+    void reportMemory(MemoryReport &);
 
     // Getters
     unsigned int getType() { return MESH_SHAPE; };
     glm::vec3 getPosition() { return position; };
-    std::vector<Knot *> getKnots() { return this->knots; };
+    ClothState * getState() { return cloth->getState(); };
+    Cloth * getCloth() { return cloth; };
+    ClothGeometry * getGeometry() { return &geometry; };
     
     // Setters
-    void setBodyStatic(int index) { knots[index]->setStatic(); };
-    void setBodyNonStatic(int index) { knots[index]->setNonStatic(); }
-    void setAllBodiesNonStatic();
-    void setWindForce(glm::vec3);
+    void setBodyStatic(int index) { cloth->setBodyStatic(index); };
+    void setBodyNonStatic(int index) { cloth->setBodyNonStatic(index); }
+    void setAllBodiesNonStatic() { cloth->setAllBodiesNonStatic(); };
+    void setWindForce(glm::vec3 w) { cloth->setWindForce(w); };
     void setPosition(glm::vec3 p) { position = p; };
     void setTexture(unsigned int);
     void setBumpyness(float b) { bumpyness += b; };
@@ -98,8 +76,8 @@ public:
     void debugColor();
 
 private:
-
-    std::vector<Knot *> knots;
+    Cloth *cloth;
+    ClothGeometry geometry;
     unsigned int numKnots;
     float knotSpacing;
     glm::vec3 position;
@@ -108,14 +86,6 @@ private:
     std::string normalMapName;
 
     // Data for OpenGl
-    std::vector<glm::vec3> mVertices;
-    std::vector<glm::vec3> mFaceNormals;
-    std::vector<glm::vec3> mUniqueVertexNormals;
-    std::vector<glm::vec3> mVertexNormals;
-    std::vector<glm::vec2> mUvs;
-    std::vector<glm::vec3> mColors;
-    std::vector<glm::vec3> mTangents;
-    std::vector<glm::vec3> mBitangents;
     std::vector<sgct_utils::SGCTSphere *> points;
 
     // VAOs and VBOs
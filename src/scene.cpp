@@ -1,15 +1,31 @@
 #include "scene.h"
+#include "profiler.h"
+#include "autotuner.h"
+#include "springkernel.h"
 
 Scene::Scene() {
     lightPosition = glm::vec3(0.0f, 25.0f, 5.0f);
+    springKernel = SPRING_KERNEL_SCALAR;
 }
 
 void Scene::addBody(Body * b) {
+
     bodies.push_back(b);
+
+    if(b->getShape()->getCloth() != NULL)
+        simulation.addCloth(b->getShape()->getCloth());
+
+    if(b->getShape()->getCollider() != NULL)
+        simulation.addCollider(b->getShape()->getCollider());
 }
 
 
-void Scene::init() {
+/*
+ * Sets up the drawing and tunes the simulation to this node. The spring kernel moves the
+ * cloth in the last bits, so only the master picks it and writes the tuning file, the other
+ * nodes are sent its kernel
+ */
+void Scene::init(bool master) {
 
     lightSourceColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
 
@@ -23,6 +39,36 @@ void Scene::init() {
         (*it)->getShape()->init(this->lightPosition);
 
     initLightSource();
+
+    // The nodes of a cluster differ, pick what steps this grid the fastest here
+    AutoTuner tuner;
+    tuner.setTuningKernel(master);
+    tuner.setWritingCache(master);
+
+    springKernel = tuner.tune(simulation, AUTOTUNE_FILE).springKernel;
+}
+
+
+/*
+ * Steps the cloths with the spring kernel of the master. A node whose CPU does not have it
+ * keeps its own, and its cloth drifts apart from the master's
+ */
+void Scene::setSpringKernel(unsigned int kernel) {
+
+    if(kernel == springKernel)
+        return;
+
+    springKernel = kernel;
+
+    if(!isSpringKernelSupported(kernel)) {
+        std::cerr << "The " << getSpringKernelName(kernel) << " spring kernel of the master is not supported here" << std::endl;
+        return;
+    }
+
+    std::vector<Cloth *> &cloths = simulation.getCloths();
+
+    for(unsigned int c = 0; c < cloths.size(); c++)
+        cloths[c]->setSpringKernel(kernel);
 }
 
 
@@ -30,7 +76,7 @@ void Scene::initLightSource() {
 
     std::cout << "Initializing light source drawing" << std::endl;
 
-    lightSource = new sgct_utils::SGCTSphere(0.2f, 5);
+    lightSource = new sgct_utils::SGCTSphere(0.2f, LIGHT_SOURCE_SEGMENTS);
 
     sgct::ShaderManager::instance()->bindShaderProgram("knots");
 
@@ -99,58 +145,49 @@ void Scene::reset() {
 
     for(std::vector<Body *>::iterator it = bodies.begin(); it != bodies.end(); ++it)
         (*it)->getShape()->reset();
+
+    // Forget the step limit and the energy of the cloth before the reset
+    simulation.reset();
 }
 
 
 void Scene::checkCollisions() {
-
-    std::vector<Knot *>mesh_knots = bodies.front()->getShape()->getKnots();
-
-    for(std::vector<Body *>::iterator body_it = bodies.begin(); body_it != bodies.end(); ++body_it) {
-        for(std::vector<Knot *>::iterator knot_it = mesh_knots.begin(); knot_it != mesh_knots.end(); ++knot_it) {
-            (*body_it)->getShape()->resolveCollision((*knot_it));
-        }
-    }
+    simulation.checkCollisions();
 }
 
 
-void Scene::step() {
-    
-    checkCollisions();
-    //applyG();
-    applySpringForce();
-    integrateVelocities();
-    //enforceMaximumStretch();
-}
+/*
+ * Takes a new memory report of the bodies, the simulation, the light source and the profiling
+ * buffers. The peaks of the earlier reports are kept
+ */
+void Scene::measureMemory() {
 
+    memory.begin();
 
-void Scene::applySpringForce() {
+    memory.add("shapes", "bodies", bodies);
 
-    for(std::vector<Body *>::iterator it = bodies.begin(); it != bodies.end(); ++it) {
-        (*it)->getShape()->applySpringForce(t, dt, acceleration);
-    }
-}
+    for(std::vector<Body *>::iterator it = bodies.begin(); it != bodies.end(); ++it)
+        (*it)->getShape()->reportMemory(memory);
 
+    simulation.reportMemory(memory);
 
-void Scene::integrateVelocities() {
+    memory.add("shapes", "light source", sizeof(sgct_utils::SGCTSphere));
+    memory.add("GL buffers", "spheres", getSGCTSphereBytes(LIGHT_SOURCE_SEGMENTS));
 
-    for(std::vector<Body *>::iterator it = bodies.begin(); it != bodies.end(); ++it) {
-        (*it)->getShape()->integrateVelocity(acceleration, dt);
-    }
+    Profiler::instance()->reportMemory(memory);
+    Tracer::instance()->reportMemory(memory);
+
+    memory.end();
 }
 
 
-void Scene::enforceMaximumStretch() {
-    for(std::vector<Body *>::iterator it = bodies.begin(); it != bodies.end(); ++it) {
-        (*it)->getShape()->enforceMaximumStretch();
-    }
-}
+unsigned int Scene::getNumKnots() {
 
+    unsigned int knots = 0;
 
-void Scene::applyG() {
+    std::vector<Cloth *> &cloths = simulation.getCloths();
+    for(std::vector<Cloth *>::iterator it = cloths.begin(); it != cloths.end(); ++it)
+        knots += (*it)->getState()->size();
 
-    for(std::vector<Body *>::iterator it = bodies.begin(); it != bodies.end(); ++it) {
-        (*it)->getShape()->applyG(acceleration, dt);
-    }
+    return knots;
 }
-
@@ -3,15 +3,23 @@
 
 //#define GRAVITY -0.01
 
+#define LIGHT_SOURCE_SEGMENTS 5
+
+// Threads and spring kernel tuned for every CPU model and grid the scene ran on
+#define AUTOTUNE_FILE "tuning.txt"
+
 #include <vector>
 #include <iostream>
 #include "body.h"
+#include "simulation.h"
+#include "memoryreport.h"
 #include "sgct.h"
 #include "glm/gtc/matrix_inverse.hpp"
 
 /*
  * Scene class to handle the simulation.
- *  This class is the core of the simulation, it contains all objects
+ *  This class is the core of the simulation, it contains all objects. The physics of the
+ *  bodies runs in a Simulation, the scene draws them.
  */
 
 class Scene {
@@ -19,7 +27,7 @@ public:
     Scene();
     //~Scene();
 
-    void init();
+    void init(bool);
     void initLightSource();
     void draw(glm::mat4, glm::mat4, glm::mat4, unsigned int);
     void drawLightSource(glm::mat4);
@@ -28,22 +36,32 @@ public:
     
     void checkCollisions();
 
-    void step();
-    void applySpringForce();
-    void enforceMaximumStretch();
-    void integrateVelocities();
-    void applyG();
+    void step() { simulation.step(); };
+    void applySpringForce() { simulation.applySpringForce(); };
+    void enforceMaximumStretch() { simulation.enforceMaximumStretch(); };
+    void integrateVelocities() { simulation.integrateVelocities(); };
+    void applyG() { simulation.applyG(); };
 
     void addBody(Body *);
 
+    void measureMemory();
+    void setSpringKernel(unsigned int);
+
     // Getters
     glm::vec3 getLightPosition() { return this->lightPosition; };
-    glm::vec3 getAcceleration() { return this->acceleration; };
+    glm::vec3 getAcceleration() { return simulation.getAcceleration(); };
+    unsigned int getIntegrator() { return simulation.getIntegrator(); };
+    float getMaxStep() { return simulation.getMaxStep(); };
+    Simulation * getSimulation() { return &simulation; };
+    MemoryReport * getMemoryReport() { return &memory; };
+    unsigned int getNumKnots();
+    unsigned int getSpringKernel() { return springKernel; };
 
     // Setters
-    void setDt(float _dt) { this->dt = _dt; };
-    void setTime(float _t) { this->t = _t; };
-    void setAcceleration(glm::vec3 _a) { this->acceleration = _a; };
+    void setDt(float _dt) { simulation.setDt(_dt); };
+    void setTime(float _t) { simulation.setTime(_t); };
+    void setAcceleration(glm::vec3 _a) { simulation.setAcceleration(_a); };
+    void setIntegrator(unsigned int type) { simulation.setIntegrator(type); };
 
 
 private:
@@ -56,10 +74,12 @@ private:
     sgct_utils::SGCTSphere *lightSource;
     glm::vec4 lightSourceColor;
 
-    // Time, delta time and acceleration for our simulation
-    float t;
-    float dt;
-    glm::vec3 acceleration;
+    // Cloths and colliders of the bodies
+    Simulation simulation;
+    unsigned int springKernel;   // Of the master, every node steps the cloths with it
+
+    // Memory of everything in the scene, with the peak since the start
+    MemoryReport memory;
 };
 
 
@@ -2,14 +2,36 @@
 #define SHAPE_H
 
 #include <glm/glm.hpp>
-#include "knot.h"
+#include <vector>
+#include <string>
+#include "clothstate.h"
+#include "memoryreport.h"
+
+/*
+ * Bytes an sgct_utils::SGCTSphere keeps in its GL buffers. SGCT does not tell, so this
+ * follows how SGCT 2.1 builds the sphere: 2 * segments slices and segments stacks, 32 bytes
+ * per vertex and three unsigned int indices per triangle
+ */
+inline size_t getSGCTSphereBytes(unsigned int segments) {
+
+    unsigned int stacks = segments < 2 ? 2 : segments;
+    unsigned int slices = 2 * stacks;
+    size_t vertices = 2 + (stacks - 1) * (slices + 1);
+    size_t triangles = 2 * slices + 2 * (stacks - 2) * slices;
+
+    return vertices * 8 * sizeof(float) + triangles * 3 * sizeof(unsigned int);
+}
+
 
 /*
  * Abstract Shape class
- *  This is an abstract class for all shapes that are supported
+ *  This is an abstract class for all shapes that are supported. Shapes draw themselves, the
+ *  physics of a shape is in the Cloth or Collider it returns.
  */
 
 class Body;
+class Cloth;
+class Collider;
 
 class Shape {
 
@@ -21,15 +43,14 @@ public:
     virtual void init(glm::vec3) = 0;
     virtual void reset() {};
 
-    virtual void integrateVelocity(const glm::vec3, float) {};
-    virtual void applyG(const glm::vec3, float) {};
-    virtual void applySpringForce(float, float, glm::vec3) {};
-    virtual void resolveCollision(Knot *) {};
-    virtual void enforceMaximumStretch() {};
-    
+    // Adds everything the shape owns, in main memory and in GL buffers
+    virtual void reportMemory(MemoryReport &) {};
+
     virtual unsigned int getType() = 0;
     virtual glm::vec3 getPosition() = 0;
-    virtual std::vector<Knot *> getKnots() { std::vector<Knot *>temp; return temp; };
+    virtual ClothState * getState() { return NULL; };
+    virtual Cloth * getCloth() { return NULL; };
+    virtual Collider * getCollider() { return NULL; };
 
     virtual void setBodyStatic(int) = 0;
     virtual void setBodyNonStatic(int) {};
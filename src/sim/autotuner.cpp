@@ -0,0 +1,300 @@
+#include "autotuner.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include "springkernel.h"
+#include "threadpool.h"
+
+#ifdef __APPLE__
+#include <sys/sysctl.h>
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+
+AutoTuner::AutoTuner()
+    : tuningKernel(true), writingCache(true) {
+
+}
+
+
+/*
+ * Name of the processor, the same on every node of the same kind
+ */
+std::string AutoTuner::getCPUModel() {
+
+    std::string model;
+
+#ifdef __APPLE__
+    char brand[256];
+    size_t size = sizeof(brand);
+
+    if(sysctlbyname("machdep.cpu.brand_string", brand, &size, NULL, 0) == 0)
+        model = brand;
+#else
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+
+    // x86 has a model name, ARM only the implementer and part numbers
+    while(model.empty() && std::getline(cpuinfo, line)) {
+        if(line.compare(0, 10, "model name") == 0 || line.compare(0, 8, "CPU part") == 0)
+            model = line.substr(line.find(':') + 1);
+    }
+#endif
+
+    model.erase(0, model.find_first_not_of(" \t"));
+    std::replace(model.begin(), model.end(), '\t', ' ');
+
+    return model.empty() ? "unknown" : model;
+}
+
+
+/*
+ * Tunes the simulation and leaves it with the fastest settings. With a cache file the
+ * settings of this CPU and grid are read from it when they are there, and written to it
+ * when they were tuned and writing is on
+ */
+AutoTuner::Settings AutoTuner::tune(Simulation &simulation, const std::string &cacheFile) {
+
+    std::vector<Cloth *> &cloths = simulation.getCloths();
+
+    Settings best;
+    best.threads = ThreadPool::instance()->getNumThreads();
+    best.springKernel = cloths.empty() ? SPRING_KERNEL_SCALAR : cloths[0]->getSpringKernel();
+    best.springGrainSize = cloths.empty() ? 0 : cloths[0]->getSpringGrainSize();
+    best.stepTime = 0.0;
+
+    if(cloths.empty())
+        return best;
+
+    unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    unsigned int knots = 0;
+    for(unsigned int c = 0; c < cloths.size(); c++)
+        knots += cloths[c]->getState()->size();
+
+    std::stringstream key;
+    key << getCPUModel() << "\t" << cores << "\t" << knots << "\t" << getIntegratorName(simulation.getIntegrator());
+
+    unsigned int kernel = best.springKernel;
+
+    if(!cacheFile.empty() && readCache(cacheFile, key.str(), best)) {
+
+        if(!tuningKernel)
+            best.springKernel = kernel;
+
+        apply(simulation, best);
+        std::cout << "Tuning read from " << cacheFile << ": " << best.threads << " threads, "
+                  << getSpringKernelName(best.springKernel) << " spring kernel, "
+                  << best.springGrainSize << " springs per task" << std::endl;
+        return best;
+    }
+
+    // Every candidate starts from the same knots and time
+    saved.resize(cloths.size());
+    for(unsigned int c = 0; c < cloths.size(); c++)
+        saved[c].save(*cloths[c]->getState());
+
+    float t = simulation.getTime();
+    float dt = simulation.getDt();
+
+    if(dt <= 0.0f)
+        simulation.setDt(AUTOTUNE_DT);
+
+    best.stepTime = timeSteps(simulation, best);
+
+    // The kernels that agree with the scalar one on every cloth
+    for(unsigned int k = 0; tuningKernel && k < NUM_SPRING_KERNELS; k++) {
+
+        if(k == best.springKernel || !isSpringKernelSupported(k))
+            continue;
+
+        bool accurate = true;
+        for(unsigned int c = 0; c < cloths.size(); c++) {
+            ClothState *state = cloths[c]->getState();
+            accurate = accurate && compareSpringKernel(k, *cloths[c]->getSprings(), &state->position[0],
+                                                       &state->velocity[0], state->size()) <= SPRING_KERNEL_TOLERANCE;
+        }
+
+        if(!accurate)
+            continue;
+
+        Settings candidate = best;
+        candidate.springKernel = k;
+        candidate.stepTime = timeSteps(simulation, candidate);
+
+        if(candidate.stepTime < best.stepTime)
+            best = candidate;
+    }
+
+    std::vector<unsigned int> threadCounts;
+    for(unsigned int n = 1; n < cores; n *= 2)
+        threadCounts.push_back(n);
+    threadCounts.push_back(cores);
+
+    for(unsigned int i = 0; i < threadCounts.size(); i++) {
+
+        if(threadCounts[i] == best.threads)
+            continue;
+
+        Settings candidate = best;
+        candidate.threads = threadCounts[i];
+        candidate.stepTime = timeSteps(simulation, candidate);
+
+        if(candidate.stepTime < best.stepTime)
+            best = candidate;
+    }
+
+    // With one thread the springs are never split
+    for(unsigned int grain = AUTOTUNE_MIN_GRAIN; best.threads > 1 && grain <= AUTOTUNE_MAX_GRAIN; grain *= 2) {
+
+        if(grain == best.springGrainSize)
+            continue;
+
+        Settings candidate = best;
+        candidate.springGrainSize = grain;
+        candidate.stepTime = timeSteps(simulation, candidate);
+
+        if(candidate.stepTime < best.stepTime)
+            best = candidate;
+    }
+
+    apply(simulation, best);
+
+    simulation.setTime(t);
+    simulation.setDt(dt);
+
+    std::cout << "Tuned for " << knots << " knots: " << best.threads << " threads, "
+              << getSpringKernelName(best.springKernel) << " spring kernel, "
+              << best.springGrainSize << " springs per task, " << best.stepTime * 1e3 << " ms per step" << std::endl;
+
+    if(!cacheFile.empty() && writingCache)
+        writeCache(cacheFile, key.str(), best);
+
+    return best;
+}
+
+
+void AutoTuner::apply(Simulation &simulation, const Settings &settings) {
+
+    ThreadPool::instance()->setNumThreads(settings.threads);
+
+    std::vector<Cloth *> &cloths = simulation.getCloths();
+
+    for(unsigned int c = 0; c < cloths.size(); c++) {
+        cloths[c]->setSpringKernel(settings.springKernel);
+        cloths[c]->setSpringGrainSize(settings.springGrainSize);
+    }
+}
+
+
+/*
+ * Seconds of the fastest of AUTOTUNE_STEPS steps with the settings, after a warm up step.
+ * The knots are put back afterwards
+ */
+double AutoTuner::timeSteps(Simulation &simulation, const Settings &settings) {
+
+    apply(simulation, settings);
+
+    double fastest = 0.0;
+
+    for(unsigned int i = 0; i <= AUTOTUNE_STEPS; i++) {
+
+        Clock::time_point start = Clock::now();
+
+        // The phases of Simulation::step, without rolling back
+        simulation.checkCollisions();
+        simulation.applySpringForce();
+        simulation.integrateVelocities();
+
+        double time = std::chrono::duration<double>(Clock::now() - start).count();
+
+        if(i == 1 || (i > 1 && time < fastest))
+            fastest = time;
+    }
+
+    std::vector<Cloth *> &cloths = simulation.getCloths();
+
+    for(unsigned int c = 0; c < cloths.size(); c++)
+        saved[c].restore(*cloths[c]->getState());
+
+    return fastest;
+}
+
+
+/*
+ * Looks for the line of the key, the CPU model, cores, knots and integrator separated by
+ * tabs, followed by the threads, the kernel name and the springs per task
+ */
+bool AutoTuner::readCache(const std::string &fileName, const std::string &key, Settings &settings) {
+
+    std::ifstream file(fileName.c_str());
+    std::string line;
+
+    while(std::getline(file, line)) {
+
+        if(line.compare(0, key.size() + 1, key + "\t") != 0)
+            continue;
+
+        std::stringstream values(line.substr(key.size() + 1));
+        unsigned int threads = 0;
+        unsigned int grain = 0;
+        std::string kernelName;
+
+        if(!(values >> threads >> kernelName >> grain) || threads == 0 || grain == 0)
+            return false;
+
+        for(unsigned int k = 0; k < NUM_SPRING_KERNELS; k++) {
+            if(kernelName == getSpringKernelName(k) && isSpringKernelSupported(k)) {
+                settings.threads = threads;
+                settings.springKernel = k;
+                settings.springGrainSize = grain;
+                settings.stepTime = 0.0;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    return false;
+}
+
+
+/*
+ * Replaces the line of the key, or adds it, and keeps the lines of other machines and grids
+ */
+void AutoTuner::writeCache(const std::string &fileName, const std::string &key, const Settings &settings) {
+
+    std::vector<std::string> lines;
+
+    {
+        std::ifstream in(fileName.c_str());
+        std::string line;
+
+        while(std::getline(in, line)) {
+            if(!line.empty() && line.compare(0, key.size() + 1, key + "\t") != 0)
+                lines.push_back(line);
+        }
+    }
+
+    std::stringstream entry;
+    entry << key << "\t" << settings.threads << "\t" << getSpringKernelName(settings.springKernel)
+          << "\t" << settings.springGrainSize;
+    lines.push_back(entry.str());
+
+    std::ofstream out(fileName.c_str());
+
+    if(!out) {
+        std::cerr << "Could not open " << fileName << std::endl;
+        return;
+    }
+
+    for(unsigned int i = 0; i < lines.size(); i++)
+        out << lines[i] << std::endl;
+
+    std::cout << "Tuning written to " << fileName << std::endl;
+}
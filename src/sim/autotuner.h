@@ -0,0 +1,70 @@
+#ifndef AUTOTUNER_H
+#define AUTOTUNER_H
+
+// Steps timed per candidate after one warm up step, the fastest of them counts
+#define AUTOTUNE_STEPS 5
+
+// Springs per task that are tried when a colour of springs is split between threads
+#define AUTOTUNE_MIN_GRAIN 256
+#define AUTOTUNE_MAX_GRAIN 16384
+
+// Substep used when the simulation has none yet, as at startup
+#define AUTOTUNE_DT ((1.0f / 60.0f) / 15.0f)
+
+#include <string>
+#include <vector>
+#include "simulation.h"
+
+/*
+ * AutoTuner class
+ *  Finds the number of threads, the spring kernel and the springs per task that step a
+ *  simulation the fastest on this machine. It steps the cloths of the simulation itself, so
+ *  it tunes for the grid and integrator they have, and puts the knots back afterwards.
+ *
+ *  The candidates are tried one setting at a time: the kernels that agree with the scalar
+ *  kernel, then the thread counts, the powers of two up to the number of cores and the
+ *  number of cores, then the springs per task. The results can be cached in a file, one
+ *  line per CPU model, number of cores and number of knots, so the next start on the same
+ *  kind of node reads them instead of tuning again.
+ *
+ *  The threads and springs per task only change how fast the cloth steps, but the kernels
+ *  differ from each other in the last bits. The nodes of a cluster must step the same cloth,
+ *  so there only one node tunes the kernel and the others keep the one they are given. Only
+ *  one node should write the cache too, it is not locked.
+ */
+
+class AutoTuner {
+
+public:
+    struct Settings {
+        unsigned int threads;
+        unsigned int springKernel;
+        unsigned int springGrainSize;
+        double stepTime;                // Seconds per step, 0 when read from the cache
+    };
+
+    // Constructors
+    AutoTuner();
+
+    // Member functions
+    Settings tune(Simulation &, const std::string &cacheFile = "");
+    void apply(Simulation &, const Settings &);
+
+    static std::string getCPUModel();
+
+    // Setters
+    void setTuningKernel(bool t) { tuningKernel = t; };
+    void setWritingCache(bool w) { writingCache = w; };
+
+private:
+    double timeSteps(Simulation &, const Settings &);
+
+    bool readCache(const std::string &, const std::string &, Settings &);
+    void writeCache(const std::string &, const std::string &, const Settings &);
+
+    std::vector<StabilityMonitor> saved;    // Knots of every cloth before tuning
+    bool tuningKernel;                      // Off keeps the spring kernel the cloths have
+    bool writingCache;                      // Off only reads the cache file
+};
+
+#endif // AUTOTUNER_H
@@ -0,0 +1,471 @@
+#include "cloth.h"
+#include "clothgeometry.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+Cloth::Cloth(unsigned int n, float k, glm::vec3 p)
+    : useTriangleBVH(false), numKnots(n), knotSpacing(k), position(p) {
+
+    createKnots();
+    createKnotNeighbors();
+    integrator = createIntegrator(INTEGRATOR_EXPLICIT);
+}
+
+
+Cloth::~Cloth() {
+    delete integrator;
+}
+
+
+void Cloth::createKnots() {
+
+    state.clear();
+    state.reserve(numKnots * numKnots);
+
+    for(int y = -floor(numKnots / 2); y < floor(numKnots / 2) + 1; y++) {
+        for(int x = -floor(numKnots / 2); x < floor(numKnots / 2) + 1; x++) {
+            state.addKnot(glm::vec3(static_cast<float>(x) * knotSpacing + position.x,
+                                    static_cast<float>(y) * knotSpacing + position.y,
+                                    position.z));
+        }
+    }
+}
+
+
+/*
+ * Creates the springs between the knots. Every spring is only added once, from the knot
+ * with the lower index, so the knot to the left or below never adds it a second time.
+ */
+void Cloth::createKnotNeighbors() {
+
+    const unsigned int n = state.size();
+
+    float l = knotSpacing;
+    float l_diag = sqrt(l*l + l*l);
+    float l_double = l * 2.0f;
+
+    forces.clear(n);
+    forces.getSprings()->reserve(n * 6);
+
+    for(unsigned int index = 0; index < n; index++) {
+        
+        // Add knot to the right
+        if((index + 1)%numKnots != 0 || index == 0)
+            forces.addSpring(index, index + 1, l, STRUCTURAL_STIFFNESS, STRUCTURAL_DAMPING, SPRING_STRUCTURAL);
+
+        // Add knot above
+        if((index < n - numKnots))
+            forces.addSpring(index, index + numKnots, l, STRUCTURAL_STIFFNESS, STRUCTURAL_DAMPING, SPRING_STRUCTURAL);
+
+        // Add knot upper right
+        if((index < n - numKnots - 1) && (index + 1)%numKnots != 0)
+            forces.addSpring(index, index + numKnots + 1, l_diag, SHEAR_STIFFNESS, SHEAR_DAMPING, SPRING_SHEAR);
+
+        // Add knot upper left
+        if((index < n - numKnots) && (index)%numKnots != 0)
+            forces.addSpring(index, index + numKnots - 1, l_diag, SHEAR_STIFFNESS, SHEAR_DAMPING, SPRING_SHEAR);
+
+        // Add knot 2 steps right
+        if(((index + 2)%numKnots != 0 &&(index + 1)%numKnots != 0) || index == 0)
+            forces.addSpring(index, index + 2, l_double, BEND_STIFFNESS, BEND_DAMPING, SPRING_BEND);
+
+        // Add knot 2 steps above
+        if((index < n - numKnots*2))
+            forces.addSpring(index, index + numKnots*2, l_double, BEND_STIFFNESS, BEND_DAMPING, SPRING_BEND);
+    }
+
+    forces.finalize(state);
+}
+
+
+void Cloth::reset() {
+    state.reset();
+}
+
+
+/*
+ * First phase of a step, evaluates the forces. With the explicit integrator this also
+ *  applies them to the velocities.
+ */
+void Cloth::applySpringForce(float dt, glm::vec3 a) {
+    integrator->applyForces(state, forces, a, dt);
+}
+
+
+/*
+ * Second phase of a step, moves the knots
+ */
+void Cloth::integrateVelocity(const glm::vec3 G, float dt) {
+    integrator->integrate(state, forces, G, dt);
+}
+
+
+/*
+ * Longest step the cloth can take right now. Limited by the stability of the integrator, and
+ *  by how fast the knots move so that they do not jump through each other or the colliders.
+ */
+float Cloth::getMaxStep() {
+
+    float step = integrator->getMaxStep(state, forces);
+    float maxSpeed2 = 0.0f;
+
+    for(unsigned int i = 0; i < state.size(); i++) {
+        if(state.isPinned(i)) continue;
+        maxSpeed2 = std::max(maxSpeed2, glm::dot(state.velocity[i], state.velocity[i]));
+    }
+
+    if(maxSpeed2 > 0.0f)
+        step = std::min(step, MAX_KNOT_TRAVEL * knotSpacing / std::sqrt(maxSpeed2));
+
+    return step;
+}
+
+
+/*
+ * Kinetic, gravitational and elastic energy of the free knots under the acceleration G
+ */
+double Cloth::getEnergy(const glm::vec3 G) {
+
+    double energy = forces.computeElasticEnergy(state, &state.position[0]);
+
+    for(unsigned int i = 0; i < state.size(); i++) {
+        if(state.isPinned(i)) continue;
+
+        double m = state.getMass(i);
+        energy += 0.5 * m * glm::dot(state.velocity[i], state.velocity[i]);
+        energy -= m * glm::dot(G, state.position[i]);
+    }
+
+    return energy;
+}
+
+
+void Cloth::setIntegrator(unsigned int type) {
+
+    if(integrator != NULL && integrator->getType() == type)
+        return;
+
+    delete integrator;
+    integrator = createIntegrator(type);
+}
+
+
+void Cloth::applyG(const glm::vec3 G, float dt) {
+
+    for(unsigned int i = 0; i < state.size(); i++) {
+        if(state.isPinned(i)) continue;
+        state.velocity[i] += G * dt;
+    }
+}
+
+
+/*
+ * Sorts the knots for the self collisions of this substep, before any knot is resolved
+ */
+void Cloth::buildCollisionGrid() {
+
+    selfCollision.build(state, numKnots, knotSpacing);
+}
+
+
+/*
+ * Moves the boxes of the BVH to where the knots ended up, once they stopped moving for this step
+ */
+void Cloth::refitTriangleBVH() {
+
+    if(useTriangleBVH)
+        bvh.refit(state);
+}
+
+
+/*
+ * Builds the BVH over the triangles of the cloth, or frees it
+ */
+void Cloth::setTriangleBVH(bool b) {
+
+    useTriangleBVH = b;
+
+    if(!b) {
+        bvh.clear();
+        return;
+    }
+
+    std::vector<unsigned int> triangles;
+    ClothGeometry::getTriangleKnots(numKnots, state.size(), triangles);
+    bvh.build(state, triangles);
+}
+
+
+/*
+ * Keeps knots [begin, end) from passing through the rest of the cloth
+ */
+void Cloth::resolveCollisions(ClothState &s, unsigned int begin, unsigned int end) {
+
+    if(!selfCollision.isEnabled())
+        return;
+
+    for(unsigned int i = begin; i < end; i++)
+        selfCollision.resolve(s, i);
+}
+
+
+void Cloth::enforceMaximumStretch() {
+    // Only allow springs to stretch or compress
+}
+
+
+void Cloth::setAllBodiesNonStatic() {
+    state.setAllNonPinned();
+}
+
+
+void Cloth::setWindForce(glm::vec3 w_f) {
+    state.wind = w_f;
+}
+
+
+void Cloth::setup1() {
+    
+    std::cout << "Loading setup 1 ...";
+
+    setAllBodiesNonStatic();
+
+    setBodyStatic(1056);
+    //setBodyStatic(1064);
+    //setBodyStatic(1072);
+    //setBodyStatic(1080);
+    setBodyStatic(1088);
+
+    // Reset the mesh, i.e. positions, velocities and forces.
+    reset();
+
+    unsigned int indx = 0;
+
+    glm::vec3 init_pos = state.initialPosition.front();
+    float x = init_pos.x;
+    float y = init_pos.y;
+    float z = init_pos.z;
+
+    // Give all knots new positions
+    state.forceDamping = 1.0f;
+
+    for(unsigned int i = 0; i < state.size(); i++) {
+        
+        state.position[i] = glm::vec3(x, y, z);
+        state.setMass(i, 1.0f);
+        x += knotSpacing;
+
+        if((indx + 1)%numKnots == 0 && indx > 0) {
+            y += knotSpacing;
+            x = init_pos.x;
+        }
+        indx++;
+    }
+
+    state.position[1072] += glm::vec3(0.0, 0.0, 0.1);
+
+    std::cout << "\tDone!" << std::endl << std::endl;
+}
+
+
+void Cloth::setup2() {
+
+    std::cout << "Loading setup 2 ...";
+
+    setAllBodiesNonStatic();
+
+    setBodyStatic(1056);
+    setBodyStatic(1064);
+    setBodyStatic(1072);
+    setBodyStatic(1080);
+    setBodyStatic(1088);
+
+    // Reset the mesh, i.e. positions, velocities and forces.
+    reset();
+
+    unsigned int indx = 0;
+
+    glm::vec3 init_pos = state.initialPosition.back();
+    float x = -init_pos.x;
+    float y = init_pos.y;
+    float z = -((numKnots - 1.0f) * knotSpacing);
+
+    // Give all knots new positions
+    state.forceDamping = 1.0f;
+
+    for(unsigned int i = 0; i < state.size(); i++) {
+
+        state.position[i] = glm::vec3(x, y, z);
+        state.setMass(i, 1.0f);
+        x += knotSpacing;
+
+        if((indx + 1)%numKnots == 0 && indx > 0) {
+            z += knotSpacing;
+            x = -init_pos.x;
+        }
+        indx++;
+    }
+    std::cout << "\tDone!" << std::endl << std::endl;
+}
+
+
+void Cloth::setup3() {
+
+    std::cout << "Loading setup 3 ...";
+
+    setAllBodiesNonStatic();
+
+    // Side 1
+    setBodyStatic(0);
+    setBodyStatic(8);
+    setBodyStatic(16);
+    setBodyStatic(24);
+    setBodyStatic(32);
+
+    // Sida 2
+    setBodyStatic(264);
+    setBodyStatic(528);
+    setBodyStatic(792);
+
+    // Sida 3
+    setBodyStatic(1056);
+    setBodyStatic(1064);
+    setBodyStatic(1072);
+    setBodyStatic(1080);
+    setBodyStatic(1088);
+
+    // Sida 4
+    setBodyStatic(296);
+    setBodyStatic(560);
+    setBodyStatic(824);
+
+    // Reset the mesh, i.e. positions, velocities and forces.
+    reset();
+
+    unsigned int indx = 0;
+
+    glm::vec3 init_pos = state.initialPosition.back();
+    float x = -init_pos.x;
+    float y = init_pos.y / 2.0;
+    float z = ((numKnots - 1.0f) * knotSpacing) / 2.0;
+
+    // Give all knots new positions
+    state.forceDamping = 1.0f;
+
+    for(unsigned int i = 0; i < state.size(); i++) {
+
+        state.position[i] = glm::vec3(x, y, z);
+        state.setMass(i, 1.0f);
+        x += knotSpacing;
+
+        if((indx + 1)%numKnots == 0 && indx > 0) {
+            z -= knotSpacing;
+            x = -init_pos.x;
+        }
+        indx++;
+    }
+
+    std::cout << "\tDone!" << std::endl << std::endl;
+}
+
+
+void Cloth::setup4() {
+
+    std::cout << "Loading setup 4 ...";
+
+    setAllBodiesNonStatic();
+
+    setBodyStatic(0);
+    setBodyStatic(32);
+    setBodyStatic(1056);
+    setBodyStatic(1088);
+
+    // Reset the mesh, i.e. positions, velocities and forces.
+    reset();
+
+    unsigned int indx = 0;
+
+    glm::vec3 init_pos = state.initialPosition.front();
+    float x = init_pos.x;
+    float y = init_pos.y;
+    float z = init_pos.z;
+
+    // Give all knots new positions
+    state.forceDamping = 1.0f;
+
+    for(unsigned int i = 0; i < state.size(); i++) {
+        
+        state.position[i] = glm::vec3(x, y, z);
+        state.setMass(i, 1.0f);
+        x += knotSpacing;
+
+        if((indx + 1)%numKnots == 0 && indx > 0) {
+            y += knotSpacing;
+            x = init_pos.x;
+        }
+        indx++;
+    }
+
+    float stretch = 0.5f;
+    // Stretch the mesh along the diagonals
+    state.position[0] += stretch * glm::vec3(-1.0, -1.0, 0.0);
+    state.position[32] += stretch * glm::vec3(1.0, -1.0, 0.0);
+    state.position[1056] += stretch * glm::vec3(-1.0, 1.0, 0.0);
+    state.position[1088] += stretch * glm::vec3(1.0, 1.0, 0.0);
+
+    std::cout << "\tDone!" << std::endl << std::endl;
+}
+
+
+void Cloth::setup5() {
+    
+    std::cout << "Loading setup 5 ...";
+
+    setAllBodiesNonStatic();
+
+    for(unsigned int i = 0; i < numKnots * numKnots - 1; i+=33)
+        setBodyStatic(i);
+
+    // Reset the mesh, i.e. positions, velocities and forces.
+    reset();
+
+    unsigned int indx = 0;
+
+    glm::vec3 init_pos = state.initialPosition.front();
+    float x = init_pos.x;
+    float y = init_pos.y;
+    float z = init_pos.z;
+
+    // Give all knots new positions
+    state.forceDamping = 1.0f;
+
+    for(unsigned int i = 0; i < state.size(); i++) {
+        
+        state.position[i] = glm::vec3(x, y, z);
+        state.setMass(i, 1.0f);
+        x += knotSpacing;
+
+        if((indx + 1)%numKnots == 0 && indx > 0) {
+            y += knotSpacing;
+            x = init_pos.x;
+        }
+        indx++;
+    }
+
+    state.addForce(1072, glm::vec3(0.0, 0.0, 0.5));
+
+    std::cout << "\tDone!" << std::endl << std::endl;
+}
+
+
+/*
+ * The knots, the springs and what the integrator keeps between steps
+ */
+void Cloth::reportMemory(MemoryReport &report) {
+    state.reportMemory(report);
+    forces.reportMemory(report);
+    integrator->reportMemory(report);
+    selfCollision.reportMemory(report);
+    bvh.reportMemory(report);
+}
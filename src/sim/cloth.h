@@ -0,0 +1,107 @@
+#ifndef CLOTH_H
+#define CLOTH_H
+
+// Spring material. Each spring is evaluated once per step, so these are twice the constants
+// the knots used back when every spring was visited from both of its ends.
+#define STRUCTURAL_STIFFNESS 14000.0f
+#define STRUCTURAL_DAMPING 160.0f
+#define SHEAR_STIFFNESS 14000.0f
+#define SHEAR_DAMPING 160.0f
+#define BEND_STIFFNESS 400.0f
+#define BEND_DAMPING 60.0f
+
+// How far a knot may move in one step, as a fraction of the knot spacing
+#define MAX_KNOT_TRAVEL 0.25f
+
+#include <glm/glm.hpp>
+#include "clothstate.h"
+#include "clothforces.h"
+#include "integrator.h"
+#include "selfcollision.h"
+#include "trianglebvh.h"
+#include "memoryreport.h"
+
+/*
+ * Cloth class
+ *  The physics of a square cloth: a grid of knots held together by structural, shear and
+ *  bend springs, and the integrator that moves it. Knows nothing about drawing, the Mesh
+ *  class draws a Cloth.
+ *
+ *  With setTriangleBVH(true) the cloth keeps a TriangleBVH over the triangles it is drawn
+ *  with for queries of its triangles, refitted to the knots at the end of every step.
+ */
+
+class Cloth {
+
+public:
+    // Constructors
+    Cloth(unsigned int, float, glm::vec3);
+
+    // Destructor
+    ~Cloth();
+
+    // Member functions
+    void createKnots();
+    void createKnotNeighbors();
+
+    // Some initial setups for the cloth
+    void setup1();
+    void setup2();
+    void setup3();
+    void setup4();
+    void setup5();
+
+    void reset();
+
+    void applySpringForce(float, glm::vec3);
+    void integrateVelocity(const glm::vec3, float);
+    void applyG(const glm::vec3, float);
+    void buildCollisionGrid();
+    void refitTriangleBVH();
+    void resolveCollisions(ClothState &, unsigned int, unsigned int);
+    void enforceMaximumStretch();
+    void reportMemory(MemoryReport &);
+
+    // Getters
+    ClothState * getState() { return &state; };
+    ClothForces * getForces() { return &forces; };
+    SpringSet * getSprings() { return forces.getSprings(); };
+    unsigned int getSpringKernel() { return forces.getSpringKernel(); };
+    unsigned int getSpringGrainSize() { return forces.getSpringGrainSize(); };
+    unsigned int getIntegrator() { return integrator->getType(); };
+    unsigned int getNumKnots() { return numKnots; };
+    bool getSelfCollision() { return selfCollision.isEnabled(); };
+    TriangleBVH * getTriangleBVH() { return useTriangleBVH ? &bvh : NULL; };
+    float getKnotSpacing() { return knotSpacing; };
+    glm::vec3 getPosition() { return position; };
+    float getMaxStep();
+    double getEnergy(const glm::vec3);
+
+    // Setters
+    void setBodyStatic(int index) { state.setPinned(index); };
+    void setBodyNonStatic(int index) { state.setNonPinned(index); }
+    void setAllBodiesNonStatic();
+    void setWindForce(glm::vec3);
+    void setSpringKernel(unsigned int k) { forces.setSpringKernel(k); };
+    void setSpringGrainSize(unsigned int g) { forces.setSpringGrainSize(g); };
+    void setIntegrator(unsigned int);
+    void setSelfCollision(bool s) { selfCollision.setEnabled(s); };
+    void setTriangleBVH(bool);
+
+private:
+    // A cloth owns its integrator
+    Cloth(const Cloth &);
+    Cloth & operator=(const Cloth &);
+
+    ClothState state;
+    ClothForces forces;
+    Integrator *integrator;
+    SelfCollision selfCollision;
+    TriangleBVH bvh;
+    bool useTriangleBVH;
+    unsigned int numKnots;      // Knots along each side
+    float knotSpacing;
+    glm::vec3 position;
+};
+
+#endif // CLOTH_H
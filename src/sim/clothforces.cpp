@@ -0,0 +1,377 @@
+#include "clothforces.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+ClothForces::ClothForces()
+    : springKernel(SPRING_KERNEL_SCALAR), springGrainSize(2048) {
+
+    telemetry.kineticEnergy = 0.0;
+    telemetry.elasticEnergy = 0.0;
+    telemetry.maxStrain = 0.0f;
+    telemetry.freeMass = 0.0;
+    telemetry.springEnergy = true;
+}
+
+
+void ClothForces::clear(unsigned int numKnots) {
+    springs.clear();
+    windWeight.assign(numKnots, 0.0f);
+}
+
+
+void ClothForces::addSpring(unsigned int i, unsigned int j, float l, float k, float b, unsigned char type) {
+
+    springs.addSpring(i, j, l, k, b, type);
+
+    // The wind used to be added once per spring visit, and structural springs were visited
+    // from both of their ends
+    float w = (type == SPRING_STRUCTURAL) ? 2.0f : 1.0f;
+    windWeight[i] += w;
+    windWeight[j] += w;
+}
+
+
+/*
+ * Call once all springs are added. Groups the springs so they can be evaluated by several
+ *  threads at once and picks the fastest spring kernel that agrees with the scalar one.
+ */
+void ClothForces::finalize(const ClothState &state) {
+
+    springs.colorSprings(state.size());
+    springKernel = selectSpringKernel(springs, &state.position[0], &state.velocity[0], state.size());
+}
+
+
+/*
+ * f = total force on every knot at positions x and velocities v. Pinned knots get no force.
+ */
+void ClothForces::computeForces(const ClothState &state, const glm::vec3 *x, const glm::vec3 *v, glm::vec3 *f) {
+    evaluateForces(state, x, v, f, false);
+}
+
+
+/*
+ * The force on every knot of the state at its own position and velocity, and the telemetry
+ *  of the cloth there
+ */
+void ClothForces::computeStateForces(ClothState &state) {
+    evaluateForces(state, &state.position[0], &state.velocity[0], &state.force[0], true);
+}
+
+
+void ClothForces::evaluateForces(const ClothState &state, const glm::vec3 *x, const glm::vec3 *v, glm::vec3 *f, bool measured) {
+
+    const unsigned int n = state.size();
+
+    ThreadPool::instance()->parallelFor(0, n, KNOT_GRAIN_SIZE,
+        [f](unsigned int begin, unsigned int end) {
+            for(unsigned int i = begin; i < end; i++)
+                f[i] = glm::vec3(0.0f, 0.0f, 0.0f);
+        });
+
+    if(measured)
+        beginTelemetry(n);
+
+    // No two springs in a colour share a knot, so each colour is split between the threads
+    // without any locking. The colours themselves have to run one after the other, so the
+    // tasks of every colour can share the stretch slots.
+    SpringKernel kernel = ::getSpringKernel(springKernel);
+    const SpringSet &s = springs;
+    const unsigned int grain = springGrainSize;
+
+    for(unsigned int c = 0; c < springs.getNumColors(); c++) {
+
+        const unsigned int offset = springs.colorOffsets[c];
+        SpringStretch *stretch = measured ? &stretchSlots[0] : NULL;
+
+        ThreadPool::instance()->parallelFor(offset, springs.colorOffsets[c + 1], grain,
+            [kernel, &s, x, v, f, offset, grain, stretch](unsigned int begin, unsigned int end) {
+                kernel(s, begin, end, x, v, f, stretch ? stretch + (begin - offset) / grain : NULL);
+            });
+    }
+
+    const ClothState *st = &state;
+    const float *w = &windWeight[0];
+    double *kinetic = measured ? &kineticSlots[0] : NULL;
+    double *mass = measured ? &massSlots[0] : NULL;
+
+    ThreadPool::instance()->parallelFor(0, n, KNOT_GRAIN_SIZE,
+        [st, w, v, f, kinetic, mass](unsigned int begin, unsigned int end) {
+
+            double e = 0.0;
+            double m = 0.0;
+
+            for(unsigned int i = begin; i < end; i++) {
+                if(st->isPinned(i)) {
+                    f[i] = glm::vec3(0.0f, 0.0f, 0.0f);
+                    continue;
+                }
+                f[i] += w[i] * st->wind;
+                f[i] *= st->forceDamping;
+
+                if(kinetic) {
+                    double mi = st->getMass(i);
+                    e += 0.5 * mi * glm::dot(v[i], v[i]);
+                    m += mi;
+                }
+            }
+
+            if(kinetic) {
+                kinetic[begin / KNOT_GRAIN_SIZE] = e;
+                mass[begin / KNOT_GRAIN_SIZE] = m;
+            }
+        });
+
+    if(measured)
+        endTelemetry(state, true);
+}
+
+
+/*
+ * The telemetry of the state on its own, for integrators that do not compute the spring
+ *  forces there
+ */
+void ClothForces::measure(const ClothState &state) {
+
+    const unsigned int n = state.size();
+
+    beginTelemetry(n);
+
+    const SpringSet &s = springs;
+    const glm::vec3 *x = &state.position[0];
+    const glm::vec3 *v = &state.velocity[0];
+    const unsigned int grain = springGrainSize;
+    SpringStretch *stretch = &stretchSlots[0];
+
+    ThreadPool::instance()->parallelFor(0, springs.size(), grain,
+        [&s, x, grain, stretch](unsigned int begin, unsigned int end) {
+
+            SpringStretch &slot = stretch[begin / grain];
+
+            for(unsigned int k = begin; k < end; k++) {
+                float e = glm::length(x[s.first[k]] - x[s.second[k]]) - s.restLength[k];
+                slot.energy += 0.5f * s.stiffness[k] * e * e;
+                slot.maxStrain = std::max(slot.maxStrain, e / s.restLength[k]);
+            }
+        });
+
+    const ClothState *st = &state;
+    double *kinetic = &kineticSlots[0];
+    double *mass = &massSlots[0];
+
+    ThreadPool::instance()->parallelFor(0, n, KNOT_GRAIN_SIZE,
+        [st, v, kinetic, mass](unsigned int begin, unsigned int end) {
+
+            double e = 0.0;
+            double m = 0.0;
+
+            for(unsigned int i = begin; i < end; i++) {
+                if(st->isPinned(i)) continue;
+
+                double mi = st->getMass(i);
+                e += 0.5 * mi * glm::dot(v[i], v[i]);
+                m += mi;
+            }
+
+            kinetic[begin / KNOT_GRAIN_SIZE] = e;
+            mass[begin / KNOT_GRAIN_SIZE] = m;
+        });
+
+    endTelemetry(state, false);
+}
+
+
+/*
+ * Clears a slot for every task. The slots only grow, a step must not allocate
+ */
+void ClothForces::beginTelemetry(unsigned int n) {
+
+    // Enough for the largest colour, and for all springs at once
+    unsigned int springTasks = (springs.size() + springGrainSize - 1) / springGrainSize;
+    unsigned int knotTasks = (n + KNOT_GRAIN_SIZE - 1) / KNOT_GRAIN_SIZE;
+
+    SpringStretch empty;
+    empty.energy = 0.0f;
+    empty.maxStrain = 0.0f;
+
+    if(stretchSlots.size() < springTasks + 1)
+        stretchSlots.resize(springTasks + 1);
+    if(kineticSlots.size() < knotTasks + 1) {
+        kineticSlots.resize(knotTasks + 1);
+        massSlots.resize(knotTasks + 1);
+    }
+
+    std::fill(stretchSlots.begin(), stretchSlots.end(), empty);
+    std::fill(kineticSlots.begin(), kineticSlots.end(), 0.0);
+    std::fill(massSlots.begin(), massSlots.end(), 0.0);
+}
+
+
+/*
+ * Adds up the slots. With springEnergy the elastic energy is what the integrator conserves
+ */
+void ClothForces::endTelemetry(const ClothState &state, bool springEnergy) {
+
+    double elastic = 0.0;
+    float maxStrain = 0.0f;
+
+    for(unsigned int k = 0; k < stretchSlots.size(); k++) {
+        elastic += stretchSlots[k].energy;
+
+        // A NaN strain is kept, it must not be hidden by a finite one
+        if(!(stretchSlots[k].maxStrain <= maxStrain))
+            maxStrain = stretchSlots[k].maxStrain;
+    }
+
+    double kinetic = 0.0;
+    double mass = 0.0;
+
+    for(unsigned int k = 0; k < kineticSlots.size(); k++) {
+        kinetic += kineticSlots[k];
+        mass += massSlots[k];
+    }
+
+    telemetry.kineticEnergy = kinetic;
+    telemetry.elasticEnergy = elastic * state.forceDamping;
+    telemetry.maxStrain = maxStrain;
+    telemetry.freeMass = mass;
+    telemetry.springEnergy = springEnergy;
+}
+
+
+/*
+ * f = the forces that do not come from the springs, the wind. For solvers that handle the
+ *  springs as constraints.
+ */
+void ClothForces::computeExternalForces(const ClothState &state, glm::vec3 *f) {
+
+    for(unsigned int i = 0; i < state.size(); i++) {
+        if(state.isPinned(i)) {
+            f[i] = glm::vec3(0.0f, 0.0f, 0.0f);
+            continue;
+        }
+        f[i] = windWeight[i] * state.wind * state.forceDamping;
+    }
+}
+
+
+/*
+ * Longest step an explicit integrator can take with these springs. Every knot is treated as
+ *  a damped oscillator with the sum of the stiffness and damping of its springs, explicit
+ *  Euler is stable for it while h < 2 / (c / m + sqrt(k / m)).
+ */
+float ClothForces::computeStableStep(const ClothState &state) {
+
+    knotStiffness.assign(state.size(), 0.0f);
+    knotDamping.assign(state.size(), 0.0f);
+
+    for(unsigned int s = 0; s < springs.size(); s++) {
+
+        float k = springs.stiffness[s] * state.forceDamping;
+
+        // The damping acts on the unnormalized spring, so it grows with the length
+        float c = springs.damping[s] * springs.restLength[s] * state.forceDamping;
+
+        knotStiffness[springs.first[s]] += k;
+        knotStiffness[springs.second[s]] += k;
+        knotDamping[springs.first[s]] += c;
+        knotDamping[springs.second[s]] += c;
+    }
+
+    float step = FLT_MAX;
+
+    for(unsigned int i = 0; i < state.size(); i++) {
+        if(state.isPinned(i)) continue;
+
+        float rate = knotDamping[i] * state.invMass[i] + std::sqrt(knotStiffness[i] * state.invMass[i]);
+        if(rate > 0.0f)
+            step = std::min(step, 2.0f / rate);
+    }
+
+    return step;
+}
+
+
+/*
+ * Energy stored in the springs at positions x, 1/2 k e^2 for a spring stretched by e
+ */
+double ClothForces::computeElasticEnergy(const ClothState &state, const glm::vec3 *x) {
+
+    double energy = 0.0;
+
+    for(unsigned int s = 0; s < springs.size(); s++) {
+        double e = glm::length(x[springs.first[s]] - x[springs.second[s]]) - springs.restLength[s];
+        energy += 0.5 * springs.stiffness[s] * state.forceDamping * e * e;
+    }
+
+    return energy;
+}
+
+
+/*
+ * Per spring blocks of the force Jacobian at positions x. For spring s between knots i and j
+ *  the force on i changes by dfdx[s] * (dx_i - dx_j) + dfdv[s] * (dv_i - dv_j), and the force
+ *  on j by the opposite. The transverse stiffness of compressed springs is dropped so the
+ *  blocks stay negative semi-definite, which the implicit solvers rely on.
+ */
+void ClothForces::computeJacobians(const ClothState &state, const glm::vec3 *x, glm::mat3 *dfdx, glm::mat3 *dfdv) {
+
+    const glm::mat3 I(1.0f);
+
+    for(unsigned int s = 0; s < springs.size(); s++) {
+
+        glm::vec3 d = x[springs.first[s]] - x[springs.second[s]];
+        float l = glm::length(d);
+        glm::vec3 d_hat = d / l;
+        glm::mat3 ddT = glm::outerProduct(d_hat, d_hat);
+
+        float k = springs.stiffness[s] * state.forceDamping;
+        float b = springs.damping[s] * state.forceDamping;
+        float transverse = std::max(1.0f - springs.restLength[s] / l, 0.0f);
+
+        dfdx[s] = -k * (ddT + transverse * (I - ddT));
+
+        // The damping acts along the unnormalized spring, so it grows with the length
+        dfdv[s] = -b * l * ddT;
+    }
+}
+
+
+/*
+ * out = J * p for the n knots, where J is the global Jacobian made of the per spring blocks J[s]
+ */
+void ClothForces::multiplyJacobian(const glm::mat3 *J, const glm::vec3 *p, glm::vec3 *out, unsigned int n) {
+
+    for(unsigned int i = 0; i < n; i++)
+        out[i] = glm::vec3(0.0f, 0.0f, 0.0f);
+
+    // Same colouring as the forces, no two springs in a colour write to the same knot
+    const SpringSet &s = springs;
+
+    for(unsigned int c = 0; c < springs.getNumColors(); c++) {
+        ThreadPool::instance()->parallelFor(springs.colorOffsets[c], springs.colorOffsets[c + 1], springGrainSize,
+            [&s, J, p, out](unsigned int begin, unsigned int end) {
+                for(unsigned int k = begin; k < end; k++) {
+                    unsigned int i = s.first[k];
+                    unsigned int j = s.second[k];
+                    glm::vec3 q = J[k] * (p[i] - p[j]);
+                    out[i] += q;
+                    out[j] -= q;
+                }
+            });
+    }
+}
+
+
+void ClothForces::reportMemory(MemoryReport &report) {
+
+    springs.reportMemory(report);
+
+    report.add("springs", "windWeight", windWeight);
+    report.add("springs", "knotStiffness", knotStiffness);
+    report.add("springs", "knotDamping", knotDamping);
+    report.add("springs", "stretchSlots", stretchSlots);
+    report.add("springs", "kineticSlots", kineticSlots);
+    report.add("springs", "massSlots", massSlots);
+}
@@ -0,0 +1,87 @@
+#ifndef CLOTHFORCES_H
+#define CLOTHFORCES_H
+
+#include <glm/glm.hpp>
+#include <vector>
+#include "clothstate.h"
+#include "springs.h"
+#include "memoryreport.h"
+#include "springkernel.h"
+#include "threadpool.h"
+
+/*
+ * Energy and strain of a cloth at the start of a step
+ */
+struct ClothTelemetry {
+    double kineticEnergy;
+    double elasticEnergy;
+    float maxStrain;        // Largest (length - rest length) / rest length of any spring
+    double freeMass;        // Of the knots that are not pinned
+    bool springEnergy;      // The springs are forces, so their energy tells a step that blew up
+};
+
+/*
+ * ClothForces class
+ *  Owns the springs of a cloth and evaluates the total internal force on every knot: the
+ *  damped springs, the wind and the force damping. Positions and velocities are passed in
+ *  separately from the state so integrators can evaluate forces at intermediate stages.
+ *
+ *  When the forces are computed at the knots of the state itself, the energy and strain of
+ *  the cloth are measured on the way, the spring kernels already have the elongation of every
+ *  spring. Each task sums into its own slot and the slots are added in order, so the
+ *  telemetry does not depend on the threads. Integrators that never evaluate the springs at
+ *  the state measure it separately. They solve the springs as constraints with a compliance
+ *  of their own, the stiffness springs are not what they conserve, so only the strain and
+ *  the finiteness of their energy count.
+ */
+
+class ClothForces {
+
+public:
+    // Constructors
+    ClothForces();
+
+    // Member functions
+    void addSpring(unsigned int, unsigned int, float, float, float, unsigned char);
+    void clear(unsigned int);
+    void finalize(const ClothState &);
+    void computeForces(const ClothState &, const glm::vec3 *x, const glm::vec3 *v, glm::vec3 *f);
+    void computeStateForces(ClothState &);
+    void measure(const ClothState &);
+    void computeExternalForces(const ClothState &, glm::vec3 *f);
+    float computeStableStep(const ClothState &);
+    double computeElasticEnergy(const ClothState &, const glm::vec3 *x);
+    void computeJacobians(const ClothState &, const glm::vec3 *x, glm::mat3 *dfdx, glm::mat3 *dfdv);
+    void multiplyJacobian(const glm::mat3 *J, const glm::vec3 *p, glm::vec3 *out, unsigned int n);
+    void reportMemory(MemoryReport &);
+
+    // Getters
+    SpringSet * getSprings() { return &springs; };
+    unsigned int getNumSprings() { return springs.size(); };
+    unsigned int getSpringKernel() { return springKernel; };
+    unsigned int getSpringGrainSize() { return springGrainSize; };
+    const ClothTelemetry & getTelemetry() { return telemetry; };
+
+    // Setters
+    void setSpringKernel(unsigned int k) { springKernel = k; };
+    void setSpringGrainSize(unsigned int g) { springGrainSize = g; };
+
+private:
+    void evaluateForces(const ClothState &, const glm::vec3 *x, const glm::vec3 *v, glm::vec3 *f, bool measured);
+    void beginTelemetry(unsigned int);
+    void endTelemetry(const ClothState &, bool);
+
+    SpringSet springs;
+    std::vector<float> windWeight;  // How many times each knot catches the wind
+    std::vector<float> knotStiffness;
+    std::vector<float> knotDamping;
+    unsigned int springKernel;      // SPRING_KERNEL_SCALAR, _SSE or _AVX2
+    unsigned int springGrainSize;   // Springs per task when a colour is split between threads
+
+    ClothTelemetry telemetry;       // At the knots of the state the forces were last computed at
+    std::vector<SpringStretch> stretchSlots;    // Per task of a colour, summed over the colours
+    std::vector<double> kineticSlots;           // Per task of knots
+    std::vector<double> massSlots;
+};
+
+#endif // CLOTHFORCES_H
@@ -0,0 +1,448 @@
+#include "clothgeometry.h"
+#include "profiler.h"
+
+ClothGeometry::ClothGeometry(unsigned int n)
+    : numKnots(n) {
+
+}
+
+
+/*
+ * Builds all triangles, normals and texture coordinates of the cloth
+ */
+void ClothGeometry::create(const ClothState &state) {
+    createVertices(state);
+    createFaceNormals();
+    createVertexNormals(state);
+    createColorVector(glm::vec3(1.0f, 0.0f, 0.0f));
+    createUVs(state);
+}
+
+
+/*
+ * Moves the triangles to the current knot positions and recomputes the normals
+ */
+void ClothGeometry::update(const ClothState &state) {
+
+    TraceScope trace("updateGeometry");
+
+    updateVertices(state);
+    updateFaceNormals();
+    updateVertexNormals(state);
+    updateVertexNormalsList(state);
+}
+
+
+void ClothGeometry::createVertices(const ClothState &state) {
+
+    const std::vector<glm::vec3> &p = state.position;
+
+    for(unsigned int index = 0; index < state.size() - (numKnots + 1); index++) {
+        
+        // Check if we're on the border
+        if((index+1)%numKnots != 0 || index == 0) {
+
+            // Face 1
+            vertices.push_back(p[index]);
+            vertices.push_back(p[index + numKnots + 1]);
+            vertices.push_back(p[index + numKnots]);
+            // Face 2
+            vertices.push_back(p[index]);
+            vertices.push_back(p[index + 1]);
+            vertices.push_back(p[index + numKnots + 1]);
+        }
+    }
+}
+
+
+/*
+ * The three knots of every triangle, in the order of the vertices, of a cloth with n knots
+ * along each side and the given number of knots
+ */
+void ClothGeometry::getTriangleKnots(unsigned int n, unsigned int knots, std::vector<unsigned int> &triangles) {
+
+    triangles.clear();
+
+    for(unsigned int index = 0; index + n + 1 < knots; index++) {
+
+        if((index+1)%n != 0 || index == 0) {
+
+            unsigned int faces[6] = { index, index + n + 1, index + n,
+                                      index, index + 1, index + n + 1 };
+
+            triangles.insert(triangles.end(), faces, faces + 6);
+        }
+    }
+}
+
+
+void ClothGeometry::createColorVector(glm::vec3 color) {
+
+    for(unsigned int i = 0; i < vertices.size(); i++)
+        colors.push_back(color);
+}
+
+
+void ClothGeometry::createFaceNormals() {
+
+    // TODO
+    for(std::vector<glm::vec3>::iterator it = vertices.begin(); it != vertices.end(); std::advance(it, 3)) {
+        
+        glm::vec3 v0 = (*(it + 1)) - (*it);
+        glm::vec3 v1 = (*(it + 2)) - (*it);
+
+        faceNormals.push_back(glm::normalize(glm::cross(v0, v1)));
+    }
+}
+
+
+/*
+ * Lists the triangles around every knot, knot i has the face normals
+ * knotFaces[knotFaceOffsets[i]] to knotFaces[knotFaceOffsets[i + 1] - 1]. The grid does not
+ * change, so this is done once and the normals are summed from it every frame
+ */
+void ClothGeometry::createKnotFaces(const ClothState &state) {
+
+    unsigned int row = 0;
+
+    knotFaces.clear();
+    knotFaceOffsets.clear();
+
+    // At most six triangles touch a knot
+    knotFaces.reserve(state.size() * 6);
+    knotFaceOffsets.reserve(state.size() + 1);
+
+    for(unsigned int i = 0; i < state.size(); i++) {
+
+        knotFaceOffsets.push_back(knotFaces.size());
+
+        if(i < numKnots) {
+            if(i == 0) {
+                knotFaces.push_back(i + 1);
+            } else if(i == numKnots - 1) {
+                knotFaces.push_back(((i - row) * 2) - 1);
+            } else {
+                knotFaces.push_back(((i - row) * 2) - 1);
+                knotFaces.push_back(((i - row) * 2));
+                knotFaces.push_back(((i - row) * 2) + 1);
+            }
+        } else if(i > (numKnots*numKnots) - (numKnots + 1)) {
+            if(i == numKnots*numKnots - 1) {
+                knotFaces.push_back((i - (row + 1)) * 2 - (numKnots) * 2);
+                knotFaces.push_back((i - (row + 1)) * 2 - (numKnots) * 2 + 1);
+            } else if(i == (numKnots*numKnots) - numKnots) {
+                knotFaces.push_back((i - row - 1) * 2 - (numKnots - 1) * 2);
+            } else {
+                knotFaces.push_back((i - row - 1) * 2 - (numKnots) * 2);
+                knotFaces.push_back((i - row - 1) * 2 - (numKnots - 1) * 2);
+                knotFaces.push_back((i - row - 1) * 2 - (numKnots - 1) * 2 - 1);
+            }
+        } else {
+            if(i%numKnots == 0) {
+                knotFaces.push_back((i - row - 1) * 2 - (numKnots - 1) * 2);
+                knotFaces.push_back((i - row - 1) * 2);
+                knotFaces.push_back((i - row - 1) * 2 + 1);
+            } else if((i+1)%numKnots == 0) {
+                knotFaces.push_back((i - row - 1) * 2 - (numKnots) * 2);
+                knotFaces.push_back((i - row - 1) * 2 - (numKnots) * 2 + 1);
+                knotFaces.push_back(((i - row - 1) * 2) - 1);
+            } else {
+                knotFaces.push_back((i - row - 1) * 2);
+                knotFaces.push_back(((i - row - 1) * 2) - 1);
+                knotFaces.push_back(((i - row - 1) * 2) + 1);
+                knotFaces.push_back((i - row - 1) * 2 - (numKnots - 1) * 2 - 2);
+                knotFaces.push_back((i - row - 1) * 2 - (numKnots - 1) * 2 - 1);
+                knotFaces.push_back((i - row - 1) * 2 - (numKnots - 1) * 2);
+            }
+        }
+
+        if((i+1)%(numKnots) == 0 && i > numKnots) {
+            row++;
+        }
+    }
+
+    knotFaceOffsets.push_back(knotFaces.size());
+}
+
+
+void ClothGeometry::createVertexNormals(const ClothState &state) {
+
+    createKnotFaces(state);
+
+    for(unsigned int i = 0; i < state.size(); i++)
+        uniqueVertexNormals.push_back(computeVertexNormal(i));
+
+    createVertexNormalsList(state);
+}
+
+
+/*
+ * Normal of knot i, the normalized sum of the normals of the triangles around it
+ */
+glm::vec3 ClothGeometry::computeVertexNormal(unsigned int i) {
+
+    glm::vec3 vertexNormal = glm::vec3(0.0f, 0.0f, 0.0f);
+
+    for(unsigned int f = knotFaceOffsets[i]; f < knotFaceOffsets[i + 1]; f++) {
+        vertexNormal += faceNormals[knotFaces[f]];
+    }
+    vertexNormal = glm::normalize(vertexNormal);
+
+    return vertexNormal;
+}
+
+
+void ClothGeometry::createVertexNormalsList(const ClothState &state) {
+
+    for(unsigned int i = 0; i < state.size() - (numKnots + 1); i++) {
+        
+        // Check if we're on the border
+        if((i+1)%numKnots != 0 || i == 0) {
+
+            // Face 1
+            vertexNormals.push_back(uniqueVertexNormals[i]);
+            vertexNormals.push_back(uniqueVertexNormals[i + numKnots + 1]);
+            vertexNormals.push_back(uniqueVertexNormals[i + numKnots]);
+            // Face 2
+            vertexNormals.push_back(uniqueVertexNormals[i]);
+            vertexNormals.push_back(uniqueVertexNormals[i + 1]);
+            vertexNormals.push_back(uniqueVertexNormals[i + numKnots + 1]);
+        }
+    }
+}
+
+
+void ClothGeometry::createUVs(const ClothState &state) {
+
+    float d_uv = 1.0f / static_cast<float>(numKnots-1);
+    unsigned int row = 0, col = 0;
+
+    for(unsigned int i = 0; i < state.size(); i++) {
+        
+        if(((i+1)%numKnots != 0 && i < (numKnots*numKnots) - numKnots) || (i == 0 && i < (numKnots*numKnots) - numKnots)) {
+            uvs.push_back(glm::vec2(static_cast<float>(col) * d_uv, static_cast<float>(row) * d_uv));
+            uvs.push_back(glm::vec2(static_cast<float>(col+1) * d_uv, static_cast<float>(row+1) * d_uv));
+            uvs.push_back(glm::vec2(static_cast<float>(col) * d_uv, static_cast<float>(row+1) * d_uv));
+
+            uvs.push_back(glm::vec2(static_cast<float>(col) * d_uv, static_cast<float>(row) * d_uv));
+            uvs.push_back(glm::vec2(static_cast<float>(col+1) * d_uv, static_cast<float>(row) * d_uv));
+            uvs.push_back(glm::vec2(static_cast<float>(col+1) * d_uv, static_cast<float>(row+1) * d_uv));
+        }
+
+        col++;
+
+        if((i+1)%(numKnots) == 0 ) {
+            row++;
+            col = 0;
+        }
+    }
+}
+
+
+void ClothGeometry::computeTangentBasis() {
+
+    for(unsigned int i = 0; i < vertices.size(); i += 3) {
+
+        // Shortcuts for vertices
+        glm::vec3 &v0 = vertices[i + 0];
+        glm::vec3 &v1 = vertices[i + 1];
+        glm::vec3 &v2 = vertices[i + 2];
+
+        // Shortcut for UVs
+        glm::vec2 &uv0 = uvs[i + 0];
+        glm::vec2 &uv1 = uvs[i + 1];
+        glm::vec2 &uv2 = uvs[i + 2];
+
+        // Edges of the triangle
+        glm::vec3 deltaPos1 = v1 - v0;
+        glm::vec3 deltaPos2 = v2 - v0;
+
+        // UV delta
+        glm::vec2 deltaUV1 = uv1 - uv0;
+        glm::vec2 deltaUV2 = uv2 - uv0;
+
+        float r = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV1.y * deltaUV2.x);
+
+        glm::vec3 tangent = (deltaPos1 * deltaUV2.y - deltaPos2 * deltaUV1.y) * r;
+        glm::vec3 bitangent = (deltaPos2 * deltaUV1.x - deltaPos1 * deltaUV2.x) * r;
+
+        tangents.push_back(tangent);
+        tangents.push_back(tangent);
+        tangents.push_back(tangent);
+
+        bitangents.push_back(bitangent);
+        bitangents.push_back(bitangent);
+        bitangents.push_back(bitangent);
+    }
+}
+
+
+void ClothGeometry::updateVertices(const ClothState &state) {
+
+    ScopedTimer timer(PROFILE_UPDATE_VERTICES);
+
+    unsigned int indx = 0;
+    const std::vector<glm::vec3> &p = state.position;
+
+    for(unsigned int i = 0; i < state.size() - (numKnots + 1); i++) {
+        
+        if((i + 1)%numKnots != 0 || i == 0) {
+
+            vertices[indx] = p[i];
+            vertices[indx + 1] = p[i + numKnots + 1];
+            vertices[indx + 2] = p[i + numKnots];
+            
+            vertices[indx + 3] = p[i];
+            vertices[indx + 4] = p[i + 1];
+            vertices[indx + 5] = p[i + numKnots + 1];
+
+            indx += 6;
+        }
+    }
+}
+
+
+void ClothGeometry::updateFaceNormals() {
+
+    ScopedTimer timer(PROFILE_UPDATE_FACE_NORMALS);
+
+    unsigned int indx = 0;
+
+    for(std::vector<glm::vec3>::iterator it = vertices.begin(); it != vertices.end(); std::advance(it, 3)) {
+        
+        glm::vec3 v0 = (*(it + 1)) - (*it);
+        glm::vec3 v1 = (*(it + 2)) - (*it);
+
+        faceNormals[indx] = glm::normalize(glm::cross(v0, v1));
+
+        indx++;
+    }
+}
+
+
+void ClothGeometry::updateVertexNormals(const ClothState &state) {
+
+    ScopedTimer timer(PROFILE_UPDATE_VERTEX_NORMALS);
+
+    for(unsigned int i = 0; i < state.size(); i++)
+        uniqueVertexNormals[i] = computeVertexNormal(i);
+}
+
+
+void ClothGeometry::updateVertexNormalsList(const ClothState &state) {
+
+    ScopedTimer timer(PROFILE_UPDATE_VERTEX_NORMALS_LIST);
+
+    unsigned int indx = 0;
+
+    for(unsigned int i = 0; i < state.size() - (numKnots + 1); i++) {
+        
+        // Check if we're on the border
+        if((i+1)%numKnots != 0 || i == 0) {
+
+            // Face 1
+            vertexNormals[indx] = uniqueVertexNormals[i];
+            vertexNormals[indx + 1] = uniqueVertexNormals[i + numKnots + 1];
+            vertexNormals[indx + 2] = uniqueVertexNormals[i + numKnots];
+            // Face 2
+            vertexNormals[indx + 3] = uniqueVertexNormals[i];
+            vertexNormals[indx + 4] = uniqueVertexNormals[i + 1];
+            vertexNormals[indx + 5] = uniqueVertexNormals[i + numKnots + 1];
+
+            indx += 6;
+        }
+    }
+}
+
+
+void ClothGeometry::flipNormals(const ClothState &state) {
+
+    ScopedTimer timer(PROFILE_FLIP);
+
+    unsigned int indx = 0;
+    glm::vec3 tmp = glm::vec3(0.0f);
+
+    for(unsigned int i = 0; i < state.size() - (numKnots + 1); i++) {
+        
+        if((i + 1)%numKnots != 0 || i == 0) {
+
+            tmp = vertexNormals[indx + 1];
+            vertexNormals[indx + 1] = vertexNormals[indx + 2];
+            vertexNormals[indx + 2] = tmp;
+            
+            tmp = vertexNormals[indx + 4];
+            vertexNormals[indx + 4] = vertexNormals[indx + 5];
+            vertexNormals[indx + 5] = tmp;
+
+            indx += 6;
+        }
+    }
+
+    for(unsigned int i = 0; i < vertexNormals.size(); i++) {
+        vertexNormals[i] = -vertexNormals[i];
+    }
+}
+
+
+void ClothGeometry::flipMesh(const ClothState &state) {
+
+    ScopedTimer timer(PROFILE_FLIP);
+
+    unsigned int indx = 0;
+    const std::vector<glm::vec3> &p = state.position;
+
+    for(unsigned int i = 0; i < state.size() - (numKnots + 1); i++) {
+        
+        if((i + 1)%numKnots != 0 || i == 0) {
+
+            vertices[indx] = p[i];
+            vertices[indx + 1] = p[i + numKnots];
+            vertices[indx + 2] = p[i + numKnots + 1];
+            
+            vertices[indx + 3] = p[i];
+            vertices[indx + 4] = p[i + numKnots + 1];
+            vertices[indx + 5] = p[i + 1];
+
+            indx += 6;
+        }
+    }
+}
+
+
+void ClothGeometry::flipUvs(const ClothState &state) {
+
+    ScopedTimer timer(PROFILE_FLIP);
+
+    unsigned int indx = 0;
+    glm::vec2 tmp = glm::vec2(0.0f);
+
+    for(unsigned int i = 0; i < state.size(); i++) {
+        
+        if(((i+1)%numKnots != 0 && i < (numKnots*numKnots) - numKnots) || (i == 0 && i < (numKnots*numKnots) - numKnots)) {
+            
+            tmp = uvs[indx + 1];
+            uvs[indx + 1] = uvs[indx + 2];
+            uvs[indx + 2] = tmp;
+            
+            tmp = uvs[indx + 4];
+            uvs[indx + 4] = uvs[indx + 5];
+            uvs[indx + 5] = tmp;
+
+            indx += 6;
+        }
+    }
+}
+
+
+void ClothGeometry::reportMemory(MemoryReport &report) {
+    report.add("geometry", "vertices", vertices);
+    report.add("geometry", "faceNormals", faceNormals);
+    report.add("geometry", "uniqueVertexNormals", uniqueVertexNormals);
+    report.add("geometry", "vertexNormals", vertexNormals);
+    report.add("geometry", "uvs", uvs);
+    report.add("geometry", "colors", colors);
+    report.add("geometry", "tangents", tangents);
+    report.add("geometry", "bitangents", bitangents);
+    report.add("geometry", "knotFaces", knotFaces);
+    report.add("geometry", "knotFaceOffsets", knotFaceOffsets);
+}
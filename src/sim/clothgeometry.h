@@ -0,0 +1,68 @@
+#ifndef CLOTHGEOMETRY_H
+#define CLOTHGEOMETRY_H
+
+#include <glm/glm.hpp>
+#include <iterator>
+#include <vector>
+#include "clothstate.h"
+#include "memoryreport.h"
+
+/*
+ * ClothGeometry class
+ *  The triangles of a cloth as they are drawn: two triangles per grid cell with their own
+ *  vertices, normals, texture coordinates and tangents. Built on the CPU from the knot
+ *  positions every frame, the Mesh class uploads it to OpenGL.
+ */
+
+class ClothGeometry {
+
+public:
+    // Constructors
+    ClothGeometry() : numKnots(0) {};
+    ClothGeometry(unsigned int);
+
+    // Member functions
+    void create(const ClothState &);
+    void update(const ClothState &);
+
+    void createVertices(const ClothState &);
+    void createColorVector(glm::vec3);
+    void createFaceNormals();
+    void createKnotFaces(const ClothState &);
+    void createVertexNormals(const ClothState &);
+    glm::vec3 computeVertexNormal(unsigned int);
+    void createVertexNormalsList(const ClothState &);
+    void createUVs(const ClothState &);
+    void computeTangentBasis();
+    void reportMemory(MemoryReport &);
+
+    static void getTriangleKnots(unsigned int, unsigned int, std::vector<unsigned int> &);
+
+    // Functions that updates the geometry every frame
+    void updateVertices(const ClothState &);
+    void updateFaceNormals();
+    void updateVertexNormals(const ClothState &);
+    void updateVertexNormalsList(const ClothState &);
+    void flipNormals(const ClothState &);
+    void flipUvs(const ClothState &);
+    void flipMesh(const ClothState &);
+
+    // Per vertex data, three vertices per triangle
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec3> faceNormals;
+    std::vector<glm::vec3> uniqueVertexNormals;     // One normal per knot
+    std::vector<glm::vec3> vertexNormals;
+    std::vector<glm::vec2> uvs;
+    std::vector<glm::vec3> colors;
+    std::vector<glm::vec3> tangents;
+    std::vector<glm::vec3> bitangents;
+
+    // Triangles around every knot, knot i has [knotFaceOffsets[i], knotFaceOffsets[i + 1])
+    std::vector<unsigned int> knotFaces;
+    std::vector<unsigned int> knotFaceOffsets;
+
+private:
+    unsigned int numKnots;      // Knots along each side
+};
+
+#endif // CLOTHGEOMETRY_H
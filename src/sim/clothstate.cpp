@@ -0,0 +1,135 @@
+#include "clothstate.h"
+
+ClothState::ClothState()
+    : forceDamping(0.75f), wind(glm::vec3(0.0f, 0.0f, 0.0f)), pinVersion(0), resetVersion(0), previousVersion(0) {
+
+}
+
+
+unsigned int ClothState::addKnot(glm::vec3 p, float m) {
+
+    position.push_back(p);
+    initialPosition.push_back(p);
+    previousPosition.push_back(p);
+    velocity.push_back(glm::vec3(0.0f, 0.0f, 0.0f));
+    force.push_back(glm::vec3(0.0f, 0.0f, 0.0f));
+    invMass.push_back(1.0f / m);
+    pinned.push_back(0);
+    pinVersion++;
+    resetVersion++;
+
+    return position.size() - 1;
+}
+
+
+void ClothState::reserve(unsigned int n) {
+    position.reserve(n);
+    initialPosition.reserve(n);
+    previousPosition.reserve(n);
+    velocity.reserve(n);
+    force.reserve(n);
+    invMass.reserve(n);
+    pinned.reserve(n);
+}
+
+
+void ClothState::clear() {
+    position.clear();
+    initialPosition.clear();
+    previousPosition.clear();
+    velocity.clear();
+    force.clear();
+    invMass.clear();
+    pinned.clear();
+    pinVersion++;
+    resetVersion++;
+}
+
+
+/*
+ * Resets positions, velocities and forces of all knots that are not pinned
+ */
+void ClothState::reset() {
+
+    for(unsigned int i = 0; i < size(); i++) {
+        if(!isPinned(i))
+            resetKnot(i);
+    }
+
+    resetVersion++;
+}
+
+
+void ClothState::resetKnot(unsigned int i) {
+    position[i] = initialPosition[i];
+    velocity[i] = glm::vec3(0.0f, 0.0f, 0.0f);
+    force[i] = glm::vec3(0.0f, 0.0f, 0.0f);
+}
+
+
+/*
+ * The knots start their paths where they are
+ */
+void ClothState::setPreviousPosition() {
+    previousPosition = position;
+    previousVersion = resetVersion;
+}
+
+
+void ClothState::setPinned(unsigned int i) {
+
+    if(pinned[i] == 0)
+        pinVersion++;
+
+    pinned[i] = 1;
+}
+
+
+void ClothState::setNonPinned(unsigned int i) {
+
+    if(pinned[i] != 0)
+        pinVersion++;
+
+    pinned[i] = 0;
+}
+
+
+void ClothState::setAllNonPinned() {
+    for(unsigned int i = 0; i < size(); i++)
+        setNonPinned(i);
+}
+
+
+Derivative evaluate(const ClothState &s, unsigned int i, float dt, glm::vec3 a, const Derivative &d) {
+
+    State state;
+    state.x = s.position[i] + d.dx * dt;
+    state.v = s.velocity[i] + d.dv * dt;
+
+    Derivative output;
+    output.dx = state.v;
+    output.dv = a;
+
+    return output;
+}
+
+
+Derivative evaluate(const ClothState &s, unsigned int i, glm::vec3 a) {
+
+    Derivative output;
+    output.dx = s.velocity[i];
+    output.dv = a;
+
+    return output;
+}
+
+
+void ClothState::reportMemory(MemoryReport &report) {
+    report.add("cloth state", "position", position);
+    report.add("cloth state", "initialPosition", initialPosition);
+    report.add("cloth state", "previousPosition", previousPosition);
+    report.add("cloth state", "velocity", velocity);
+    report.add("cloth state", "force", force);
+    report.add("cloth state", "invMass", invMass);
+    report.add("cloth state", "pinned", pinned);
+}
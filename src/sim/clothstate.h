@@ -0,0 +1,89 @@
+#ifndef CLOTHSTATE_H
+#define CLOTHSTATE_H
+
+// Knots per task when a loop over the knots is split between threads
+#define KNOT_GRAIN_SIZE 1024
+
+#include <glm/glm.hpp>
+#include <vector>
+#include "memoryreport.h"
+
+/*
+ * ClothState class
+ *  Structure-of-arrays storage for all knots in a cloth. Every knot attribute lives in its
+ *  own contiguous array indexed by the knot index, so the simulation loops stream through
+ *  memory instead of chasing one heap allocation per knot.
+ *
+ *  The previous positions are where the knots were after the collisions of the last substep,
+ *  so a collider can follow the path a knot took since. They are unknown after the knots are
+ *  reset or added, or moved by a setup after that, until setPreviousPosition() is called.
+ */
+
+class ClothState {
+
+public:
+    // Constructors
+    ClothState();
+
+    // Member functions
+    unsigned int addKnot(glm::vec3, float m = 1.0f);
+    void reserve(unsigned int);
+    void clear();
+    void reset();
+    void resetKnot(unsigned int);
+    void reportMemory(MemoryReport &);
+
+    // Getters
+    unsigned int size() const { return position.size(); };
+    bool isPinned(unsigned int i) const { return pinned[i] != 0; };
+    float getMass(unsigned int i) const { return 1.0f / invMass[i]; };
+    unsigned int getPinVersion() const { return pinVersion; };
+    unsigned int getResetVersion() const { return resetVersion; };
+    bool hasPreviousPosition() const { return previousVersion == resetVersion; };
+
+    // Setters
+    void setPinned(unsigned int);
+    void setNonPinned(unsigned int);
+    void setAllNonPinned();
+    void setMass(unsigned int i, float m) { invMass[i] = 1.0f / m; };
+    void addForce(unsigned int i, glm::vec3 f) { force[i] += f; };
+    void setPreviousPosition();
+
+    // Per knot data, all arrays have the same length
+    std::vector<glm::vec3> position;
+    std::vector<glm::vec3> initialPosition;
+    std::vector<glm::vec3> previousPosition;    // After the collisions of the last substep
+    std::vector<glm::vec3> velocity;
+    std::vector<glm::vec3> force;
+    std::vector<float> invMass;
+    std::vector<unsigned char> pinned;
+
+    // Shared by all knots in the cloth
+    float forceDamping;
+    glm::vec3 wind;
+
+private:
+    unsigned int pinVersion;    // Changes every time a knot is pinned or released
+    unsigned int resetVersion;  // Changes every time the knots are reset or added
+    unsigned int previousVersion;   // Reset version when the previous positions were set
+};
+
+
+/*
+ * Some helpers for Runge-Kutta 4
+ */
+
+struct Derivative {
+    glm::vec3 dx;
+    glm::vec3 dv;
+};
+
+struct State {
+    glm::vec3 x;
+    glm::vec3 v;
+};
+
+Derivative evaluate(const ClothState &, unsigned int, float dt, glm::vec3 a, const Derivative &d);
+Derivative evaluate(const ClothState &, unsigned int, glm::vec3 a);
+
+#endif // CLOTHSTATE_H
@@ -0,0 +1,58 @@
+#ifndef COLLIDER_H
+#define COLLIDER_H
+
+#include <glm/glm.hpp>
+#include <cfloat>
+#include "clothstate.h"
+#include "memoryreport.h"
+
+/*
+ * Abstract Collider class
+ *  Something the cloth can collide with. Colliders push knots out of themselves and change
+ *  their velocities, they are not moved by the cloth. resolveCollisions is called for
+ *  different ranges of knots from several threads at once and may only change the knots in
+ *  its range. It resolves one knot after the other with resolveCollision unless a collider
+ *  has a faster loop of its own.
+ *
+ *  getBounds gives a box the collider is inside of, the simulation skips a collider for the
+ *  knots whose box does not overlap it. Colliders without bounds are never skipped. The box
+ *  of the knots holds their previous positions too, and a collider that moves holds where it
+ *  was, so a collider can follow the paths of the knots since the last substep.
+ *
+ *  beginCollisions is called with the dt before a step is taken, and endCollisions once it
+ *  was taken. A collider that moves goes along its path in between. beginSubstep is called
+ *  before the collisions of every substep with how far into the step it starts and how long
+ *  the knots have moved along their paths, so the collider can follow its own path over the
+ *  same time. After a rollback the substep may start before the step did.
+ */
+
+class Collider {
+
+public:
+
+    virtual ~Collider() {};
+
+    virtual void resolveCollision(ClothState &, unsigned int) = 0;
+    virtual void reset() {};
+    virtual void beginCollisions(float) {};
+    virtual void beginSubstep(float, float) {};
+    virtual void endCollisions() {};
+
+    virtual void resolveCollisions(ClothState &s, unsigned int begin, unsigned int end) {
+        for(unsigned int i = begin; i < end; i++)
+            resolveCollision(s, i);
+    };
+
+    virtual void getBounds(glm::vec3 &lower, glm::vec3 &upper) {
+        lower = glm::vec3(-FLT_MAX);
+        upper = glm::vec3(FLT_MAX);
+    };
+
+    // Adds what the collider keeps besides itself, like a baked field
+    virtual void reportMemory(MemoryReport &) {};
+
+    virtual glm::vec3 getPosition() = 0;
+    virtual void setPosition(glm::vec3) = 0;
+};
+
+#endif // COLLIDER_H
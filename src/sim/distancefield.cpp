@@ -0,0 +1,399 @@
+#include "distancefield.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include "threadpool.h"
+
+// First bytes of a baked field on disk
+static const char fileMagic[8] = { 'C', 'L', 'O', 'T', 'H', 'S', 'D', 'F' };
+
+
+/*
+ * Distance from p to the triangle abc, from the closest point on it as in Ericson's Real-Time
+ * Collision Detection
+ */
+static float getTriangleDistance(const glm::vec3 &p, const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c) {
+
+    glm::vec3 ab = b - a;
+    glm::vec3 ac = c - a;
+    glm::vec3 ap = p - a;
+
+    float d1 = glm::dot(ab, ap);
+    float d2 = glm::dot(ac, ap);
+    if(d1 <= 0.0f && d2 <= 0.0f)
+        return glm::length(ap);
+
+    glm::vec3 bp = p - b;
+    float d3 = glm::dot(ab, bp);
+    float d4 = glm::dot(ac, bp);
+    if(d3 >= 0.0f && d4 <= d3)
+        return glm::length(bp);
+
+    float vc = d1 * d4 - d3 * d2;
+    if(vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+        return glm::length(ap - (d1 / (d1 - d3)) * ab);
+
+    glm::vec3 cp = p - c;
+    float d5 = glm::dot(ab, cp);
+    float d6 = glm::dot(ac, cp);
+    if(d6 >= 0.0f && d5 <= d6)
+        return glm::length(cp);
+
+    float vb = d5 * d2 - d1 * d6;
+    if(vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+        return glm::length(ap - (d2 / (d2 - d6)) * ac);
+
+    float va = d3 * d6 - d5 * d4;
+    if(va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+        return glm::length(bp - ((d4 - d3) / ((d4 - d3) + (d5 - d6))) * (c - b));
+
+    float denominator = 1.0f / (va + vb + vc);
+    return glm::length(ap - (vb * denominator) * ab - (vc * denominator) * ac);
+}
+
+
+static float getTriangleDistance(const glm::vec3 &p, const std::vector<glm::vec3> &vertices,
+                                 const std::vector<unsigned int> &triangles, int t) {
+    return getTriangleDistance(p, vertices[triangles[3 * t]], vertices[triangles[3 * t + 1]],
+                               vertices[triangles[3 * t + 2]]);
+}
+
+
+DistanceField::DistanceField()
+    : origin(0.0f, 0.0f, 0.0f), cellSize(1.0f), nx(0), ny(0), nz(0) {
+
+}
+
+
+glm::vec3 DistanceField::getUpper() const {
+    return origin + cellSize * glm::vec3(static_cast<float>(nx - 1), static_cast<float>(ny - 1),
+                                         static_cast<float>(nz - 1));
+}
+
+
+void DistanceField::clear() {
+    nx = ny = nz = 0;
+    distance.clear();
+}
+
+
+/*
+ * Bakes the field of a closed mesh, the triangles are three vertex indices each, with cubic
+ * cells of the given size
+ */
+void DistanceField::bake(const std::vector<glm::vec3> &vertices, const std::vector<unsigned int> &triangles, float size) {
+
+    clear();
+
+    if(vertices.empty() || triangles.size() < 3 || size <= 0.0f)
+        return;
+
+    glm::vec3 lower = vertices[0];
+    glm::vec3 upper = vertices[0];
+
+    for(unsigned int v = 1; v < vertices.size(); v++) {
+        lower = glm::min(lower, vertices[v]);
+        upper = glm::max(upper, vertices[v]);
+    }
+
+    cellSize = size;
+    origin = lower - glm::vec3(DISTANCE_FIELD_PADDING * cellSize);
+
+    glm::vec3 cells = (upper - lower) / cellSize;
+    nx = static_cast<unsigned int>(std::ceil(cells.x)) + 2 * DISTANCE_FIELD_PADDING + 1;
+    ny = static_cast<unsigned int>(std::ceil(cells.y)) + 2 * DISTANCE_FIELD_PADDING + 1;
+    nz = static_cast<unsigned int>(std::ceil(cells.z)) + 2 * DISTANCE_FIELD_PADDING + 1;
+
+    const unsigned int corners = nx * ny * nz;
+    const unsigned int numTriangles = static_cast<unsigned int>(triangles.size() / 3);
+
+    // Farther than any corner can be from the mesh
+    distance.assign(corners, (nx + ny + nz) * cellSize);
+
+    std::vector<int> closest(corners, -1);
+    std::vector<unsigned int> crossings(corners, 0);
+
+    // The rays along x start a little off the corners, in cells, so they do not pass exactly
+    // through the edges and vertices of meshes that are aligned with the grid
+    const float rayY = 0.000314159f;
+    const float rayZ = 0.000271828f;
+
+    for(unsigned int t = 0; t < numTriangles; t++) {
+
+        const glm::vec3 &a = vertices[triangles[3 * t]];
+        const glm::vec3 &b = vertices[triangles[3 * t + 1]];
+        const glm::vec3 &c = vertices[triangles[3 * t + 2]];
+
+        // Grid coordinates of the vertices
+        glm::vec3 ga = (a - origin) / cellSize;
+        glm::vec3 gb = (b - origin) / cellSize;
+        glm::vec3 gc = (c - origin) / cellSize;
+
+        glm::vec3 low = glm::min(ga, glm::min(gb, gc));
+        glm::vec3 high = glm::max(ga, glm::max(gb, gc));
+
+        // The corners around the triangle measure it directly
+        int i0 = std::max(0, static_cast<int>(std::floor(low.x)) - DISTANCE_FIELD_EXACT_BAND);
+        int j0 = std::max(0, static_cast<int>(std::floor(low.y)) - DISTANCE_FIELD_EXACT_BAND);
+        int k0 = std::max(0, static_cast<int>(std::floor(low.z)) - DISTANCE_FIELD_EXACT_BAND);
+        int i1 = std::min(static_cast<int>(nx) - 1, static_cast<int>(std::ceil(high.x)) + DISTANCE_FIELD_EXACT_BAND);
+        int j1 = std::min(static_cast<int>(ny) - 1, static_cast<int>(std::ceil(high.y)) + DISTANCE_FIELD_EXACT_BAND);
+        int k1 = std::min(static_cast<int>(nz) - 1, static_cast<int>(std::ceil(high.z)) + DISTANCE_FIELD_EXACT_BAND);
+
+        for(int k = k0; k <= k1; k++) {
+            for(int j = j0; j <= j1; j++) {
+                for(int i = i0; i <= i1; i++) {
+
+                    glm::vec3 p = origin + cellSize * glm::vec3(static_cast<float>(i), static_cast<float>(j), static_cast<float>(k));
+                    float d = getTriangleDistance(p, a, b, c);
+                    unsigned int index = getIndex(i, j, k);
+
+                    if(d < distance[index]) {
+                        distance[index] = d;
+                        closest[index] = static_cast<int>(t);
+                    }
+                }
+            }
+        }
+
+        // Rows of corners whose ray along x crosses the triangle, counted at the first corner
+        // past the crossing
+        j0 = std::max(0, static_cast<int>(std::ceil(low.y - rayY)));
+        k0 = std::max(0, static_cast<int>(std::ceil(low.z - rayZ)));
+        j1 = std::min(static_cast<int>(ny) - 1, static_cast<int>(std::floor(high.y - rayY)));
+        k1 = std::min(static_cast<int>(nz) - 1, static_cast<int>(std::floor(high.z - rayZ)));
+
+        for(int k = k0; k <= k1; k++) {
+            for(int j = j0; j <= j1; j++) {
+
+                float y = j + rayY;
+                float z = k + rayZ;
+
+                // Barycentric coordinates of the ray in the triangle projected along x
+                float wa = (gb.y - y) * (gc.z - z) - (gb.z - z) * (gc.y - y);
+                float wb = (gc.y - y) * (ga.z - z) - (gc.z - z) * (ga.y - y);
+                float wc = (ga.y - y) * (gb.z - z) - (ga.z - z) * (gb.y - y);
+
+                bool positive = wa > 0.0f && wb > 0.0f && wc > 0.0f;
+                bool negative = wa < 0.0f && wb < 0.0f && wc < 0.0f;
+
+                if(!positive && !negative)
+                    continue;
+
+                float x = (wa * ga.x + wb * gb.x + wc * gc.x) / (wa + wb + wc);
+                int first = static_cast<int>(std::ceil(x));
+
+                if(first < 0)
+                    crossings[getIndex(0, j, k)]++;
+                else if(first < static_cast<int>(nx))
+                    crossings[getIndex(first, j, k)]++;
+            }
+        }
+    }
+
+    // Twice in all eight directions, so the closest triangle reaches round the corners of the
+    // mesh
+    for(unsigned int pass = 0; pass < 2; pass++) {
+        sweep(vertices, triangles, closest,  1,  1,  1);
+        sweep(vertices, triangles, closest, -1, -1, -1);
+        sweep(vertices, triangles, closest,  1,  1, -1);
+        sweep(vertices, triangles, closest, -1, -1,  1);
+        sweep(vertices, triangles, closest,  1, -1,  1);
+        sweep(vertices, triangles, closest, -1,  1, -1);
+        sweep(vertices, triangles, closest,  1, -1, -1);
+        sweep(vertices, triangles, closest, -1,  1,  1);
+    }
+
+    // A corner after an odd number of crossings along its row is inside
+    float *field = &distance[0];
+    const unsigned int *crossed = &crossings[0];
+    const unsigned int rowLength = nx;
+
+    ThreadPool::instance()->parallelFor(0, ny * nz, 64,
+        [field, crossed, rowLength](unsigned int begin, unsigned int end) {
+            for(unsigned int row = begin; row < end; row++) {
+
+                unsigned int count = 0;
+
+                for(unsigned int i = row * rowLength; i < (row + 1) * rowLength; i++) {
+                    count += crossed[i];
+                    if(count % 2 == 1)
+                        field[i] = -field[i];
+                }
+            }
+        });
+}
+
+
+/*
+ * Visits the grid in the direction of di, dj and dk, and gives every corner the triangle of
+ * the neighbours it came from when that triangle is closer than its own
+ */
+void DistanceField::sweep(const std::vector<glm::vec3> &vertices, const std::vector<unsigned int> &triangles,
+                          std::vector<int> &closest, int di, int dj, int dk) {
+
+    int i0 = di > 0 ? 1 : static_cast<int>(nx) - 2, i1 = di > 0 ? static_cast<int>(nx) : -1;
+    int j0 = dj > 0 ? 1 : static_cast<int>(ny) - 2, j1 = dj > 0 ? static_cast<int>(ny) : -1;
+    int k0 = dk > 0 ? 1 : static_cast<int>(nz) - 2, k1 = dk > 0 ? static_cast<int>(nz) : -1;
+
+    for(int k = k0; k != k1; k += dk) {
+        for(int j = j0; j != j1; j += dj) {
+            for(int i = i0; i != i1; i += di) {
+
+                const unsigned int index = getIndex(i, j, k);
+                const glm::vec3 p = origin + cellSize * glm::vec3(static_cast<float>(i), static_cast<float>(j), static_cast<float>(k));
+
+                // The seven neighbours behind the corner in the direction of the sweep
+                const unsigned int neighbours[7] = {
+                    getIndex(i - di, j, k),
+                    getIndex(i, j - dj, k),
+                    getIndex(i - di, j - dj, k),
+                    getIndex(i, j, k - dk),
+                    getIndex(i - di, j, k - dk),
+                    getIndex(i, j - dj, k - dk),
+                    getIndex(i - di, j - dj, k - dk)
+                };
+
+                for(unsigned int n = 0; n < 7; n++) {
+
+                    int t = closest[neighbours[n]];
+
+                    if(t < 0 || t == closest[index])
+                        continue;
+
+                    float d = getTriangleDistance(p, vertices, triangles, t);
+
+                    if(d < distance[index]) {
+                        distance[index] = d;
+                        closest[index] = t;
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+/*
+ * Distance and gradient at n points, trilinearly interpolated from the corners of the cell
+ * each point is in. Does not allocate
+ */
+void DistanceField::query(const glm::vec3 *points, unsigned int n, float *d, glm::vec3 *gradient) const {
+
+    const glm::vec3 upper = getUpper();
+    const float inverse = 1.0f / cellSize;
+    const float *field = &distance[0];
+    const unsigned int slab = nx * ny;
+
+    for(unsigned int p = 0; p < n; p++) {
+
+        glm::vec3 q = glm::clamp(points[p], origin, upper);
+        glm::vec3 g = (q - origin) * inverse;
+
+        // On the upper faces the point is at the far end of the last cell
+        unsigned int i = std::min(static_cast<unsigned int>(g.x), nx - 2);
+        unsigned int j = std::min(static_cast<unsigned int>(g.y), ny - 2);
+        unsigned int k = std::min(static_cast<unsigned int>(g.z), nz - 2);
+
+        float tx = g.x - i;
+        float ty = g.y - j;
+        float tz = g.z - k;
+
+        const float *c = field + getIndex(i, j, k);
+
+        float c000 = c[0],            c100 = c[1];
+        float c010 = c[nx],           c110 = c[nx + 1];
+        float c001 = c[slab],         c101 = c[slab + 1];
+        float c011 = c[slab + nx],    c111 = c[slab + nx + 1];
+
+        // Along x, then y, then z
+        float c00 = c000 + tx * (c100 - c000);
+        float c10 = c010 + tx * (c110 - c010);
+        float c01 = c001 + tx * (c101 - c001);
+        float c11 = c011 + tx * (c111 - c011);
+
+        float c0 = c00 + ty * (c10 - c00);
+        float c1 = c01 + ty * (c11 - c01);
+
+        // The derivatives of the same interpolation
+        float x0 = (c100 - c000) + ty * ((c110 - c010) - (c100 - c000));
+        float x1 = (c101 - c001) + ty * ((c111 - c011) - (c101 - c001));
+
+        d[p] = c0 + tz * (c1 - c0) + glm::length(points[p] - q);
+        gradient[p] = inverse * glm::vec3(x0 + tz * (x1 - x0), (c10 - c00) + tz * ((c11 - c01) - (c10 - c00)), c1 - c0);
+    }
+}
+
+
+/*
+ * Reads a field written with the same key, returns false when there is none or it was baked
+ * from something else
+ */
+bool DistanceField::read(const std::string &fileName, uint64_t key) {
+
+    std::ifstream file(fileName.c_str(), std::ios::binary);
+
+    if(!file)
+        return false;
+
+    char magic[sizeof(fileMagic)];
+    uint64_t fileKey = 0;
+    uint32_t size[3] = { 0, 0, 0 };
+    float header[4];
+
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char *>(&fileKey), sizeof(fileKey));
+    file.read(reinterpret_cast<char *>(size), sizeof(size));
+    file.read(reinterpret_cast<char *>(header), sizeof(header));
+
+    if(!file || std::memcmp(magic, fileMagic, sizeof(fileMagic)) != 0 || fileKey != key ||
+       size[0] < 2 || size[1] < 2 || size[2] < 2 || header[3] <= 0.0f)
+        return false;
+
+    std::vector<float> corners(static_cast<size_t>(size[0]) * size[1] * size[2]);
+    file.read(reinterpret_cast<char *>(&corners[0]), corners.size() * sizeof(float));
+
+    if(!file)
+        return false;
+
+    origin = glm::vec3(header[0], header[1], header[2]);
+    cellSize = header[3];
+    nx = size[0];
+    ny = size[1];
+    nz = size[2];
+    distance.swap(corners);
+
+    return true;
+}
+
+
+bool DistanceField::write(const std::string &fileName, uint64_t key) {
+
+    if(isEmpty())
+        return false;
+
+    std::ofstream file(fileName.c_str(), std::ios::binary);
+
+    if(!file) {
+        std::cerr << "Could not open " << fileName << std::endl;
+        return false;
+    }
+
+    uint32_t size[3] = { nx, ny, nz };
+    float header[4] = { origin.x, origin.y, origin.z, cellSize };
+
+    file.write(fileMagic, sizeof(fileMagic));
+    file.write(reinterpret_cast<const char *>(&key), sizeof(key));
+    file.write(reinterpret_cast<const char *>(size), sizeof(size));
+    file.write(reinterpret_cast<const char *>(header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(&distance[0]), distance.size() * sizeof(float));
+
+    return static_cast<bool>(file);
+}
+
+
+void DistanceField::reportMemory(MemoryReport &report) {
+    report.add("colliders", "distance field", distance);
+}
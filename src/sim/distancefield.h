@@ -0,0 +1,74 @@
+#ifndef DISTANCEFIELD_H
+#define DISTANCEFIELD_H
+
+// Empty cells baked around the mesh on every side, so the field outside the mesh is exact up
+// to a few cells away
+#define DISTANCE_FIELD_PADDING 3
+
+// Cells around each triangle where the distance is measured to it directly, the rest of the
+// grid gets it from the triangle closest to its neighbours
+#define DISTANCE_FIELD_EXACT_BAND 1
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "memoryreport.h"
+
+/*
+ * DistanceField class
+ *  Signed distance to a closed triangle mesh, sampled at the corners of a uniform grid of
+ *  cubic cells that covers the mesh. Negative inside the mesh, positive outside.
+ *
+ *  bake() measures the distance from every corner near a triangle to that triangle, and then
+ *  sweeps the grid eight ways so every other corner takes the closest of the triangles its
+ *  neighbours found. Whether a corner is inside is the parity of the triangles crossed by a
+ *  ray along x from the start of its row, so the mesh has to be closed. A baked field can be
+ *  written to a file with a key, usually a hash of the mesh and cell size, and read back on the
+ *  next start instead of baking again.
+ *
+ *  query() interpolates the distance and its gradient trilinearly from the eight corners of
+ *  the cell around each point, for many points at once. Points outside the grid are clamped
+ *  to it and get the distance to the grid added. Queries only read the field, so any number
+ *  of threads can query it at once.
+ */
+
+class DistanceField {
+
+public:
+    // Constructors
+    DistanceField();
+
+    // Member functions
+    void bake(const std::vector<glm::vec3> &, const std::vector<unsigned int> &, float);
+    void query(const glm::vec3 *, unsigned int, float *, glm::vec3 *) const;
+    bool read(const std::string &, uint64_t);
+    bool write(const std::string &, uint64_t);
+    void clear();
+    void reportMemory(MemoryReport &);
+
+    // Getters
+    bool isEmpty() const { return distance.empty(); };
+    glm::vec3 getLower() const { return origin; };
+    glm::vec3 getUpper() const;
+    float getCellSize() const { return cellSize; };
+    unsigned int getNumCorners() const { return static_cast<unsigned int>(distance.size()); };
+
+private:
+    unsigned int getIndex(unsigned int i, unsigned int j, unsigned int k) const {
+        return (k * ny + j) * nx + i;
+    };
+
+    void sweep(const std::vector<glm::vec3> &, const std::vector<unsigned int> &, std::vector<int> &,
+               int, int, int);
+
+    glm::vec3 origin;           // Corner (0, 0, 0)
+    float cellSize;
+    unsigned int nx;            // Corners along each axis
+    unsigned int ny;
+    unsigned int nz;
+
+    std::vector<float> distance;    // By corner, x fastest
+};
+
+#endif // DISTANCEFIELD_H
@@ -0,0 +1,207 @@
+#include "distancefieldcollider.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+DistanceFieldCollider::DistanceFieldCollider(glm::vec3 p, float t)
+    : position(p), initialPosition(p), thickness(t) {
+
+}
+
+
+void DistanceFieldCollider::reset() {
+    position = initialPosition;
+}
+
+
+/*
+ * Reads the vertices and faces of an OBJ file, faces with more than three corners are split
+ * into a fan of triangles. The hash is an FNV-1a hash of the whole file
+ */
+bool DistanceFieldCollider::readOBJ(const std::string &fileName, std::vector<glm::vec3> &vertices,
+                                    std::vector<unsigned int> &triangles, uint64_t &hash) {
+
+    std::ifstream file(fileName.c_str(), std::ios::binary);
+
+    if(!file) {
+        std::cerr << "Could not open " << fileName << std::endl;
+        return false;
+    }
+
+    std::stringstream contents;
+    contents << file.rdbuf();
+    const std::string text = contents.str();
+
+    hash = 14695981039346656037ull;
+    for(unsigned int i = 0; i < text.size(); i++)
+        hash = (hash ^ static_cast<unsigned char>(text[i])) * 1099511628211ull;
+
+    vertices.clear();
+    triangles.clear();
+
+    std::stringstream lines(text);
+    std::string line;
+    std::vector<unsigned int> face;
+
+    while(std::getline(lines, line)) {
+
+        std::stringstream values(line);
+        std::string type;
+        values >> type;
+
+        if(type == "v") {
+            glm::vec3 v;
+            if(values >> v.x >> v.y >> v.z)
+                vertices.push_back(v);
+        } else if(type == "f") {
+
+            face.clear();
+            std::string corner;
+
+            // v, v/vt, v//vn or v/vt/vn, negative indices count back from the last vertex
+            while(values >> corner) {
+
+                int index = atoi(corner.c_str());
+
+                if(index < 0)
+                    index += static_cast<int>(vertices.size()) + 1;
+
+                if(index < 1 || index > static_cast<int>(vertices.size())) {
+                    std::cerr << fileName << ": face refers to a vertex that is not there: " << line << std::endl;
+                    return false;
+                }
+
+                face.push_back(static_cast<unsigned int>(index - 1));
+            }
+
+            for(unsigned int c = 2; c < face.size(); c++) {
+                triangles.push_back(face[0]);
+                triangles.push_back(face[c - 1]);
+                triangles.push_back(face[c]);
+            }
+        }
+    }
+
+    if(triangles.empty()) {
+        std::cerr << fileName << " has no triangles" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+/*
+ * Loads the mesh of an OBJ file with cells of the given size. The field is read from the
+ * cache file when it was baked from the same file with the same cell size, and baked and
+ * written to it otherwise. Without a cache file it is fileName.sdf
+ */
+bool DistanceFieldCollider::load(const std::string &fileName, float cellSize, const std::string &cacheFile) {
+
+    std::vector<glm::vec3> vertices;
+    std::vector<unsigned int> triangles;
+    uint64_t key = 0;
+
+    if(!readOBJ(fileName, vertices, triangles, key))
+        return false;
+
+    // The cell size is part of what was baked
+    uint32_t cellBits = 0;
+    std::memcpy(&cellBits, &cellSize, sizeof(cellBits));
+    key = (key ^ cellBits) * 1099511628211ull;
+
+    const std::string cacheName = cacheFile.empty() ? fileName + ".sdf" : cacheFile;
+
+    if(field.read(cacheName, key)) {
+        std::cout << "Distance field of " << fileName << " read from " << cacheName << std::endl;
+        return true;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    field.bake(vertices, triangles, cellSize);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Baked " << fileName << ", " << triangles.size() / 3 << " triangles into "
+              << field.getNumCorners() << " corners in " << seconds << " s" << std::endl;
+
+    if(field.write(cacheName, key))
+        std::cout << "Distance field written to " << cacheName << std::endl;
+
+    return true;
+}
+
+
+void DistanceFieldCollider::resolveCollision(ClothState &s, unsigned int i) {
+    resolveCollisions(s, i, i + 1);
+}
+
+
+/*
+ * Queries the field for DISTANCE_FIELD_BATCH knots at a time and pushes the ones that are too
+ * close out of the mesh. Only the arrays on the stack are used, so it does not allocate
+ */
+void DistanceFieldCollider::resolveCollisions(ClothState &s, unsigned int begin, unsigned int end) {
+
+    if(field.isEmpty())
+        return;
+
+    glm::vec3 *x = &s.position[0];
+    glm::vec3 *v = &s.velocity[0];
+
+    glm::vec3 local[DISTANCE_FIELD_BATCH];
+    float distance[DISTANCE_FIELD_BATCH];
+    glm::vec3 gradient[DISTANCE_FIELD_BATCH];
+
+    for(unsigned int first = begin; first < end; first += DISTANCE_FIELD_BATCH) {
+
+        const unsigned int n = std::min(end - first, static_cast<unsigned int>(DISTANCE_FIELD_BATCH));
+
+        for(unsigned int k = 0; k < n; k++)
+            local[k] = x[first + k] - position;
+
+        field.query(local, n, distance, gradient);
+
+        for(unsigned int k = 0; k < n; k++) {
+
+            // Far from the mesh, or where the gradient vanishes in the middle of it
+            float length = glm::length(gradient[k]);
+            if(distance[k] >= thickness || length == 0.0f)
+                continue;
+
+            const unsigned int i = first + k;
+            glm::vec3 normal = gradient[k] / length;
+
+            x[i] += (thickness - distance[k]) * normal;
+
+            float approach = std::min(glm::dot(v[i], normal), 0.0f);
+            v[i] = 0.8f * (v[i] - approach * normal);
+        }
+    }
+}
+
+
+/*
+ * The grid of the field where it is in the scene
+ */
+void DistanceFieldCollider::getBounds(glm::vec3 &lower, glm::vec3 &upper) {
+
+    if(field.isEmpty()) {
+        lower = glm::vec3(FLT_MAX);
+        upper = glm::vec3(-FLT_MAX);
+        return;
+    }
+
+    lower = field.getLower() + position;
+    upper = field.getUpper() + position;
+}
+
+
+void DistanceFieldCollider::reportMemory(MemoryReport &report) {
+    field.reportMemory(report);
+}
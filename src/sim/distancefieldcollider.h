@@ -0,0 +1,62 @@
+#ifndef DISTANCEFIELDCOLLIDER_H
+#define DISTANCEFIELDCOLLIDER_H
+
+// How far above the surface of the mesh the knots are kept
+#define DISTANCE_FIELD_THICKNESS 0.1f
+
+// Knots whose distance is queried at once
+#define DISTANCE_FIELD_BATCH 64
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "collider.h"
+#include "distancefield.h"
+#include "memoryreport.h"
+
+/*
+ * DistanceFieldCollider class
+ *  A static solid of any shape, loaded from a closed triangle mesh in an OBJ file and baked
+ *  into a DistanceField. The field is cached next to the mesh, or in any file given, under a
+ *  hash of the file and the cell size, so it is only baked again when one of them changes.
+ *
+ *  Knots closer to the surface than the thickness, or inside, are pushed out along the
+ *  gradient of the field and lose the velocity they had into it and some of the rest, like
+ *  on the sphere. A knot costs the eight corners of its cell whatever the number of
+ *  triangles, and the knots are queried DISTANCE_FIELD_BATCH at a time.
+ */
+
+class DistanceFieldCollider : public Collider {
+
+public:
+    // Constructors
+    DistanceFieldCollider(glm::vec3 p = glm::vec3(0.0f, 0.0f, 0.0f), float t = DISTANCE_FIELD_THICKNESS);
+
+    // Member functions
+    bool load(const std::string &, float, const std::string &cacheFile = "");
+    void resolveCollision(ClothState &, unsigned int);
+    void resolveCollisions(ClothState &, unsigned int, unsigned int);
+    void reset();
+    void getBounds(glm::vec3 &, glm::vec3 &);
+    void reportMemory(MemoryReport &);
+
+    static bool readOBJ(const std::string &, std::vector<glm::vec3> &, std::vector<unsigned int> &, uint64_t &);
+
+    // Getters
+    glm::vec3 getPosition() { return position; };
+    float getThickness() { return thickness; };
+    const DistanceField & getField() { return field; };
+
+    // Setters
+    void setPosition(glm::vec3 p) { position = p; };
+    void setThickness(float t) { thickness = t; };
+
+private:
+    DistanceField field;        // Around the mesh as it is in the file
+    glm::vec3 position;         // Where the origin of the file is in the scene
+    glm::vec3 initialPosition;
+    float thickness;
+};
+
+#endif // DISTANCEFIELDCOLLIDER_H
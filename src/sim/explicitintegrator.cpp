@@ -0,0 +1,42 @@
+#include "explicitintegrator.h"
+
+void ExplicitIntegrator::applyForces(ClothState &state, ClothForces &forces, const glm::vec3 /* G */, float dt) {
+
+    forces.computeStateForces(state);
+
+    // Explicit Euler step of the spring forces, every knot on its own
+    ClothState *s = &state;
+
+    ThreadPool::instance()->parallelFor(0, state.size(), KNOT_GRAIN_SIZE,
+        [s, dt](unsigned int begin, unsigned int end) {
+            for(unsigned int i = begin; i < end; i++) {
+                if(s->isPinned(i)) continue;
+                s->velocity[i] += (s->force[i] * s->invMass[i]) * dt;
+            }
+        });
+}
+
+
+void ExplicitIntegrator::integrate(ClothState &state, ClothForces &/* forces */, const glm::vec3 G, float dt) {
+
+    ClothState *s = &state;
+
+    ThreadPool::instance()->parallelFor(0, state.size(), KNOT_GRAIN_SIZE,
+        [s, G, dt](unsigned int begin, unsigned int end) {
+            for(unsigned int i = begin; i < end; i++) {
+                if(s->isPinned(i)) continue;
+
+                // Runge-Kutta 4
+                Derivative k1 = evaluate(*s, i, G);
+                Derivative k2 = evaluate(*s, i, dt*0.5f, G, k1);
+                Derivative k3 = evaluate(*s, i, dt*0.5f, G, k2);
+                Derivative k4 = evaluate(*s, i, dt, G, k3);
+
+                glm::vec3 dxdt = 1.0f/6.0f * (k1.dx + 2.0f*(k2.dx + k3.dx) + k4.dx);
+                glm::vec3 dvdt = 1.0f/6.0f * (k1.dv + 2.0f*(k2.dv + k3.dv) + k4.dv);
+
+                s->position[i] += dxdt * dt;
+                s->velocity[i] += dvdt * dt;
+            }
+        });
+}
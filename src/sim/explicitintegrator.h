@@ -0,0 +1,22 @@
+#ifndef EXPLICITINTEGRATOR_H
+#define EXPLICITINTEGRATOR_H
+
+#include "integrator.h"
+
+/*
+ * ExplicitIntegrator class
+ *  The original integrator. The spring forces are applied to the velocities with an explicit
+ *  Euler step, after which the knots are moved with Runge-Kutta 4 under constant gravity.
+ */
+
+class ExplicitIntegrator : public Integrator {
+
+public:
+    void applyForces(ClothState &, ClothForces &, const glm::vec3, float);
+    void integrate(ClothState &, ClothForces &, const glm::vec3, float);
+
+    float getMaxStep(const ClothState &s, ClothForces &f) { return f.computeStableStep(s); };
+    unsigned int getType() { return INTEGRATOR_EXPLICIT; };
+};
+
+#endif // EXPLICITINTEGRATOR_H
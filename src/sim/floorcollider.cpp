@@ -0,0 +1,43 @@
+#include "floorcollider.h"
+#include <cmath>
+
+void FloorCollider::resolveCollision(ClothState &s, unsigned int i) {
+
+    if(s.position[i].y < this->position.y) {
+
+        float dist = std::abs(s.position[i].y - this->position.y);
+
+        s.position[i].y = this->position.y + dist*4.0f;
+
+        s.velocity[i] = glm::vec3(0.0f, 0.0f, 0.0f);
+    }
+}
+
+
+/*
+ * The same as resolveCollision for knots [begin, end), with selects instead of a branch so
+ * the loop can be vectorized
+ */
+void FloorCollider::resolveCollisions(ClothState &s, unsigned int begin, unsigned int end) {
+
+    glm::vec3 *x = &s.position[0];
+    glm::vec3 *v = &s.velocity[0];
+    const float floor = position.y;
+
+    for(unsigned int i = begin; i < end; i++) {
+
+        bool below = x[i].y < floor;
+
+        x[i].y = below ? floor + std::abs(x[i].y - floor) * 4.0f : x[i].y;
+        v[i] = below ? glm::vec3(0.0f, 0.0f, 0.0f) : v[i];
+    }
+}
+
+
+/*
+ * Everything below the floor
+ */
+void FloorCollider::getBounds(glm::vec3 &lower, glm::vec3 &upper) {
+    lower = glm::vec3(-FLT_MAX);
+    upper = glm::vec3(FLT_MAX, position.y, FLT_MAX);
+}
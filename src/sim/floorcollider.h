@@ -0,0 +1,32 @@
+#ifndef FLOORCOLLIDER_H
+#define FLOORCOLLIDER_H
+
+#include "collider.h"
+
+/*
+ * FloorCollider class
+ *  An infinite horizontal floor, knots that fall through it are put back above it and stopped
+ */
+
+class FloorCollider : public Collider {
+
+public:
+    // Constructors
+    FloorCollider(glm::vec3 p) : position(p) {};
+
+    // Member functions
+    void resolveCollision(ClothState &, unsigned int);
+    void resolveCollisions(ClothState &, unsigned int, unsigned int);
+    void getBounds(glm::vec3 &, glm::vec3 &);
+
+    // Getters
+    glm::vec3 getPosition() { return position; };
+
+    // Setters
+    void setPosition(glm::vec3 p) { position = p; };
+
+private:
+    glm::vec3 position;
+};
+
+#endif // FLOORCOLLIDER_H
@@ -0,0 +1,161 @@
+#include "implicitintegrator.h"
+
+void ImplicitIntegrator::resize(unsigned int numKnots, unsigned int numSprings) {
+
+    if(dv.size() != numKnots) {
+        invDiag.resize(numKnots);
+        dv.assign(numKnots, glm::vec3(0.0f, 0.0f, 0.0f));
+        b.resize(numKnots);
+        r.resize(numKnots);
+        z.resize(numKnots);
+        p.resize(numKnots);
+        q.resize(numKnots);
+    }
+
+    if(dfdx.size() != numSprings) {
+        dfdx.resize(numSprings);
+        system.resize(numSprings);
+    }
+}
+
+
+/*
+ * out = A * in, A = M - h df/dv - h^2 df/dx
+ */
+void ImplicitIntegrator::multiply(const ClothState &state, ClothForces &forces, const glm::vec3 *in, glm::vec3 *out) {
+
+    forces.multiplyJacobian(&system[0], in, out, state.size());
+
+    for(unsigned int i = 0; i < state.size(); i++)
+        out[i] = state.getMass(i) * in[i] - out[i];
+
+    filter(state, out);
+}
+
+
+void ImplicitIntegrator::filter(const ClothState &state, glm::vec3 *x) {
+
+    for(unsigned int i = 0; i < state.size(); i++) {
+        if(state.isPinned(i))
+            x[i] = glm::vec3(0.0f, 0.0f, 0.0f);
+    }
+}
+
+
+float ImplicitIntegrator::dot(const glm::vec3 *x, const glm::vec3 *y, unsigned int n) {
+
+    double sum = 0.0;
+
+    for(unsigned int i = 0; i < n; i++)
+        sum += glm::dot(x[i], y[i]);
+
+    return static_cast<float>(sum);
+}
+
+
+/*
+ * Solves for the new velocities, integrate then moves the knots with them
+ */
+void ImplicitIntegrator::applyForces(ClothState &state, ClothForces &forces, const glm::vec3 G, float h) {
+
+    const unsigned int n = state.size();
+    const unsigned int numSprings = forces.getNumSprings();
+
+    resize(n, numSprings);
+
+    const SpringSet *springs = forces.getSprings();
+
+    forces.computeStateForces(state);
+    forces.computeJacobians(state, &state.position[0], &dfdx[0], &system[0]);
+
+    // q = df/dx v
+    forces.multiplyJacobian(&dfdx[0], &state.velocity[0], &q[0], n);
+
+    for(unsigned int s = 0; s < numSprings; s++)
+        system[s] = h * system[s] + (h * h) * dfdx[s];
+
+    // Right hand side and the diagonal of A
+    for(unsigned int i = 0; i < n; i++) {
+        float m = state.getMass(i);
+        b[i] = h * (state.force[i] + m * G + h * q[i]);
+        invDiag[i] = glm::vec3(m, m, m);
+    }
+
+    for(unsigned int s = 0; s < numSprings; s++) {
+        glm::vec3 d(system[s][0][0], system[s][1][1], system[s][2][2]);
+        invDiag[springs->first[s]] -= d;
+        invDiag[springs->second[s]] -= d;
+    }
+
+    for(unsigned int i = 0; i < n; i++)
+        invDiag[i] = glm::vec3(1.0f / invDiag[i].x, 1.0f / invDiag[i].y, 1.0f / invDiag[i].z);
+
+    filter(state, &b[0]);
+    filter(state, &dv[0]);
+
+    // Preconditioned conjugate gradient, starting from the last solution
+    multiply(state, forces, &dv[0], &q[0]);
+
+    for(unsigned int i = 0; i < n; i++) {
+        r[i] = b[i] - q[i];
+        z[i] = invDiag[i] * r[i];
+        p[i] = z[i];
+    }
+
+    const float threshold = IMPLICIT_TOLERANCE * IMPLICIT_TOLERANCE * dot(&b[0], &b[0], n);
+    float rz = dot(&r[0], &z[0], n);
+
+    for(iterations = 0; iterations < IMPLICIT_MAX_ITERATIONS; iterations++) {
+
+        if(dot(&r[0], &r[0], n) <= threshold)
+            break;
+
+        multiply(state, forces, &p[0], &q[0]);
+
+        float pq = dot(&p[0], &q[0], n);
+        if(pq <= 0.0f)
+            break;
+
+        float alpha = rz / pq;
+
+        for(unsigned int i = 0; i < n; i++) {
+            dv[i] += alpha * p[i];
+            r[i] -= alpha * q[i];
+            z[i] = invDiag[i] * r[i];
+        }
+
+        float rzNew = dot(&r[0], &z[0], n);
+        float beta = rzNew / rz;
+        rz = rzNew;
+
+        for(unsigned int i = 0; i < n; i++)
+            p[i] = z[i] + beta * p[i];
+    }
+
+    for(unsigned int i = 0; i < n; i++) {
+        if(state.isPinned(i)) continue;
+        state.velocity[i] += dv[i];
+    }
+}
+
+
+void ImplicitIntegrator::integrate(ClothState &state, ClothForces &/* forces */, const glm::vec3 /* G */, float h) {
+
+    for(unsigned int i = 0; i < state.size(); i++) {
+        if(state.isPinned(i)) continue;
+        state.position[i] += state.velocity[i] * h;
+    }
+}
+
+
+void ImplicitIntegrator::reportMemory(MemoryReport &report) {
+    report.add("integrator", "implicit dfdx", dfdx);
+    report.add("integrator", "implicit system", system);
+    report.add("integrator", "implicit invDiag", invDiag);
+    report.add("integrator", "implicit dv", dv);
+    report.add("integrator", "implicit b", b);
+    report.add("integrator", "implicit r", r);
+    report.add("integrator", "implicit z", z);
+    report.add("integrator", "implicit p", p);
+    report.add("integrator", "implicit q", q);
+}
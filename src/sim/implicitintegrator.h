@@ -0,0 +1,61 @@
+#ifndef IMPLICITINTEGRATOR_H
+#define IMPLICITINTEGRATOR_H
+
+// Conjugate gradient stops after this many iterations, or when the residual has dropped by
+// IMPLICIT_TOLERANCE relative to the right hand side
+#define IMPLICIT_MAX_ITERATIONS 200
+#define IMPLICIT_TOLERANCE 1e-4f
+
+// Stable for any step, but the cloth gets too damped beyond this
+#define IMPLICIT_MAX_STEP (1.0f / 120.0f)
+
+#include <vector>
+#include "integrator.h"
+
+/*
+ * ImplicitIntegrator class
+ *  Backward Euler in the style of Baraff and Witkin. The forces are linearized around the
+ *  current state and the velocity change dv is solved from
+ *
+ *      (M - h df/dv - h^2 df/dx) dv = h (f + M G + h df/dx v)
+ *
+ *  with a Jacobi preconditioned conjugate gradient. The matrix is never assembled, products
+ *  are taken straight from the per spring Jacobian blocks. Pinned knots are kept out of the
+ *  solve by filtering them from the residual. Stable for much larger steps than the explicit
+ *  integrators at the same stiffness.
+ */
+
+class ImplicitIntegrator : public Integrator {
+
+public:
+    // Constructors
+    ImplicitIntegrator() : iterations(0) {};
+
+    void applyForces(ClothState &, ClothForces &, const glm::vec3, float);
+    void integrate(ClothState &, ClothForces &, const glm::vec3, float);
+
+    float getMaxStep(const ClothState &, ClothForces &) { return IMPLICIT_MAX_STEP; };
+    unsigned int getType() { return INTEGRATOR_IMPLICIT; };
+    unsigned int getIterations() { return iterations; };
+    void reportMemory(MemoryReport &);
+
+private:
+    void resize(unsigned int, unsigned int);
+    void multiply(const ClothState &, ClothForces &, const glm::vec3 *, glm::vec3 *);
+    void filter(const ClothState &, glm::vec3 *);
+    float dot(const glm::vec3 *, const glm::vec3 *, unsigned int);
+
+    std::vector<glm::mat3> dfdx;    // Per spring position Jacobian blocks
+    std::vector<glm::mat3> system;  // Per spring blocks of h df/dv + h^2 df/dx
+    std::vector<glm::vec3> invDiag; // Jacobi preconditioner
+    std::vector<glm::vec3> dv;      // Solution, kept as the initial guess for the next step
+    std::vector<glm::vec3> b;
+    std::vector<glm::vec3> r;
+    std::vector<glm::vec3> z;
+    std::vector<glm::vec3> p;
+    std::vector<glm::vec3> q;
+
+    unsigned int iterations;        // Conjugate gradient iterations in the last step
+};
+
+#endif // IMPLICITINTEGRATOR_H
@@ -0,0 +1,39 @@
+#include "integrator.h"
+#include "explicitintegrator.h"
+#include "rk4integrator.h"
+#include "implicitintegrator.h"
+#include "xpbdintegrator.h"
+#include "projectiveintegrator.h"
+
+Integrator * createIntegrator(unsigned int type) {
+
+    switch(type) {
+    case INTEGRATOR_RK4:
+        return new RK4Integrator();
+    case INTEGRATOR_IMPLICIT:
+        return new ImplicitIntegrator();
+    case INTEGRATOR_XPBD:
+        return new XPBDIntegrator();
+    case INTEGRATOR_PROJECTIVE:
+        return new ProjectiveIntegrator();
+    default:
+        return new ExplicitIntegrator();
+    }
+}
+
+
+const char * getIntegratorName(unsigned int type) {
+
+    switch(type) {
+    case INTEGRATOR_RK4:
+        return "Runge-Kutta 4";
+    case INTEGRATOR_IMPLICIT:
+        return "implicit Euler";
+    case INTEGRATOR_XPBD:
+        return "XPBD";
+    case INTEGRATOR_PROJECTIVE:
+        return "projective dynamics";
+    default:
+        return "explicit";
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef INTEGRATOR_H
+#define INTEGRATOR_H
+
+#define INTEGRATOR_EXPLICIT 0
+#define INTEGRATOR_RK4 1
+#define INTEGRATOR_IMPLICIT 2
+#define INTEGRATOR_XPBD 3
+#define INTEGRATOR_PROJECTIVE 4
+#define NUM_INTEGRATORS 5
+
+#include <glm/glm.hpp>
+#include "clothstate.h"
+#include "clothforces.h"
+#include "memoryreport.h"
+
+/*
+ * Abstract Integrator class
+ *  Advances a cloth one time step. A step is split in two phases so the scene can run them
+ *  for all bodies in turn: applyForces evaluates the forces, integrate moves the knots.
+ */
+
+class Integrator {
+
+public:
+
+    virtual ~Integrator() {};
+
+    virtual void applyForces(ClothState &, ClothForces &, const glm::vec3, float) = 0;
+    virtual void integrate(ClothState &, ClothForces &, const glm::vec3, float) = 0;
+
+    // Longest stable step for the cloth as it is now
+    virtual float getMaxStep(const ClothState &, ClothForces &) = 0;
+
+    virtual unsigned int getType() = 0;
+
+    // Adds the arrays the integrator keeps between steps
+    virtual void reportMemory(MemoryReport &) {};
+};
+
+
+Integrator * createIntegrator(unsigned int);
+const char * getIntegratorName(unsigned int);
+
+#endif // INTEGRATOR_H
@@ -0,0 +1,213 @@
+#include "memoryreport.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#define MEMORY_HAS_RUSAGE
+#endif
+
+MemoryReport::MemoryReport()
+    : total(0), peakTotal(0), numReports(0) {
+
+}
+
+
+/*
+ * Starts a new report, the peaks of the earlier ones are kept
+ */
+void MemoryReport::begin() {
+
+    for(unsigned int i = 0; i < entries.size(); i++)
+        entries[i].bytes = 0;
+
+    total = 0;
+}
+
+
+/*
+ * Adds bytes to an entry of a subsystem. Adding to the same entry twice in one report sums
+ * the bytes, so every cloth of a scene can add to the same entries
+ */
+void MemoryReport::add(const char *subsystem, const char *name, size_t bytes) {
+
+    total += bytes;
+
+    for(unsigned int i = 0; i < entries.size(); i++) {
+        Entry &e = entries[i];
+
+        if(std::strcmp(e.subsystem, subsystem) == 0 && std::strcmp(e.name, name) == 0) {
+            e.bytes += bytes;
+            e.peakBytes = std::max(e.peakBytes, e.bytes);
+            return;
+        }
+    }
+
+    Entry e;
+    e.subsystem = subsystem;
+    e.name = name;
+    e.bytes = bytes;
+    e.peakBytes = bytes;
+    entries.push_back(e);
+}
+
+
+void MemoryReport::end() {
+    peakTotal = std::max(peakTotal, total);
+    numReports++;
+}
+
+
+/*
+ * Forgets every entry and peak
+ */
+void MemoryReport::clear() {
+    entries.clear();
+    total = 0;
+    peakTotal = 0;
+    numReports = 0;
+}
+
+
+size_t MemoryReport::getSubsystemTotal(const char *subsystem) {
+
+    size_t bytes = 0;
+
+    for(unsigned int i = 0; i < entries.size(); i++) {
+        if(std::strcmp(entries[i].subsystem, subsystem) == 0)
+            bytes += entries[i].bytes;
+    }
+
+    return bytes;
+}
+
+
+/*
+ * The sum of the peaks of the entries. They need not have peaked in the same report, so this
+ * is an upper bound
+ */
+size_t MemoryReport::getSubsystemPeak(const char *subsystem) {
+
+    size_t bytes = 0;
+
+    for(unsigned int i = 0; i < entries.size(); i++) {
+        if(std::strcmp(entries[i].subsystem, subsystem) == 0)
+            bytes += entries[i].peakBytes;
+    }
+
+    return bytes;
+}
+
+
+/*
+ * Largest resident set of the process so far in bytes, 0 where it is not known
+ */
+size_t MemoryReport::getPeakResidentBytes() {
+
+#ifdef MEMORY_HAS_RUSAGE
+    struct rusage usage;
+
+    if(getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    // Linux counts in kilobytes
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#else
+    return 0;
+#endif
+}
+
+
+/*
+ * Writes a table of every subsystem and its entries, the last report and the peak in KiB.
+ * With the number of knots it also writes the bytes per knot, to see how large a grid fits
+ */
+void MemoryReport::write(std::ostream &out, unsigned int numKnots) {
+
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+
+    out << std::fixed << std::setprecision(1)
+        << std::left << std::setw(36) << "Memory (KiB)" << std::right << std::setw(14) << "steady" << std::setw(14) << "peak" << std::endl;
+
+    std::vector<const char *> written;
+
+    for(unsigned int i = 0; i < entries.size(); i++) {
+
+        const char *subsystem = entries[i].subsystem;
+
+        bool done = false;
+        for(unsigned int w = 0; w < written.size(); w++)
+            done = done || std::strcmp(written[w], subsystem) == 0;
+
+        if(done)
+            continue;
+
+        written.push_back(subsystem);
+
+        out << std::left << std::setw(36) << subsystem << std::right
+            << std::setw(14) << getSubsystemTotal(subsystem) / 1024.0
+            << std::setw(14) << getSubsystemPeak(subsystem) / 1024.0 << std::endl;
+
+        for(unsigned int j = i; j < entries.size(); j++) {
+            if(std::strcmp(entries[j].subsystem, subsystem) != 0)
+                continue;
+
+            out << "  " << std::left << std::setw(34) << entries[j].name << std::right
+                << std::setw(14) << entries[j].bytes / 1024.0
+                << std::setw(14) << entries[j].peakBytes / 1024.0 << std::endl;
+        }
+    }
+
+    out << std::left << std::setw(36) << "Total" << std::right
+        << std::setw(14) << total / 1024.0 << std::setw(14) << peakTotal / 1024.0 << std::endl;
+
+    if(numKnots > 0) {
+        out << std::left << std::setw(36) << "Bytes per knot" << std::right
+            << std::setw(14) << static_cast<double>(total) / numKnots
+            << std::setw(14) << static_cast<double>(peakTotal) / numKnots << std::endl;
+    }
+
+    size_t resident = getPeakResidentBytes();
+    if(resident > 0) {
+        out << std::left << std::setw(36) << "Peak resident size of the process" << std::right
+            << std::setw(28) << resident / 1024.0 << std::endl;
+    }
+
+    out << numReports << " reports" << std::endl;
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+
+/*
+ * One line per entry: subsystem, name, bytes in the last report and peak bytes
+ */
+bool MemoryReport::writeCSV(const std::string &fileName) {
+
+    std::ofstream file(fileName.c_str());
+
+    if(!file) {
+        std::cerr << "Could not open " << fileName << std::endl;
+        return false;
+    }
+
+    file << "subsystem,name,bytes,peak_bytes" << std::endl;
+
+    for(unsigned int i = 0; i < entries.size(); i++)
+        file << entries[i].subsystem << "," << entries[i].name << "," << entries[i].bytes << "," << entries[i].peakBytes << std::endl;
+
+    file << "total,total," << total << "," << peakTotal << std::endl;
+
+    std::cout << "Memory report written to " << fileName << std::endl;
+
+    return true;
+}
@@ -0,0 +1,67 @@
+#ifndef MEMORYREPORT_H
+#define MEMORYREPORT_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/*
+ * MemoryReport class
+ *  Breaks the memory of a scene down per subsystem. The owners of the data add how many bytes
+ *  each of their arrays takes between begin() and end(), what a std::vector has reserved
+ *  counts and not only what it holds. GL buffers are added with the size that was uploaded.
+ *
+ *  The report is meant to be taken again and again, every frame or every step. Each entry
+ *  keeps the largest size it had in any report as its peak, and the total keeps its own
+ *  peak, so a report after a run shows both the steady state and the worst frame. Entries are
+ *  named by string literals and only allocate the first time they are added, so a report
+ *  taken between steps does not allocate. What happens inside a step that is freed before
+ *  the report is only seen in the peak resident size of the process.
+ */
+
+class MemoryReport {
+
+public:
+    struct Entry {
+        const char *subsystem;  // String literals, they are compared by content
+        const char *name;
+        size_t bytes;           // In the last report
+        size_t peakBytes;       // Largest in any report
+    };
+
+    // Constructors
+    MemoryReport();
+
+    // Member functions
+    void begin();
+    void add(const char *, const char *, size_t);
+    void end();
+    void clear();
+
+    template<typename T>
+    void add(const char *subsystem, const char *name, const std::vector<T> &v) {
+        add(subsystem, name, v.capacity() * sizeof(T));
+    };
+
+    void write(std::ostream &, unsigned int numKnots = 0);
+    bool writeCSV(const std::string &);
+
+    static size_t getPeakResidentBytes();
+
+    // Getters
+    const std::vector<Entry> & getEntries() { return entries; };
+    size_t getTotal() { return total; };
+    size_t getPeakTotal() { return peakTotal; };
+    size_t getSubsystemTotal(const char *);
+    size_t getSubsystemPeak(const char *);
+    unsigned int getNumReports() { return numReports; };
+
+private:
+    std::vector<Entry> entries;     // In the order they were first added
+    size_t total;
+    size_t peakTotal;
+    unsigned int numReports;
+};
+
+#endif // MEMORYREPORT_H
@@ -0,0 +1,222 @@
+#include "perfcounters.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <dirent.h>
+#include <unistd.h>
+#define PERF_HAS_EVENTS
+#endif
+
+static const char * counterNames[NUM_PERF_COUNTERS] = {
+    "cycles",
+    "instructions",
+    "cacheReferences",
+    "cacheMisses",
+    "branches",
+    "branchMisses"
+};
+
+#ifdef PERF_HAS_EVENTS
+static const uint64_t counterEvents[NUM_PERF_COUNTERS] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_REFERENCES,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_INSTRUCTIONS,
+    PERF_COUNT_HW_BRANCH_MISSES
+};
+
+
+static int openEvent(uint64_t event, int tid, int groupFd) {
+
+    struct perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = event;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.disabled = groupFd == -1 ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, tid, -1, groupFd, 0));
+}
+#endif
+
+
+PerfCounters::PerfCounters()
+    : opened(false) {
+
+    for(unsigned int c = 0; c < NUM_PERF_COUNTERS; c++)
+        available[c] = false;
+}
+
+
+PerfCounters::~PerfCounters() {
+    close();
+}
+
+
+PerfCounters * PerfCounters::instance() {
+
+    static PerfCounters counters;
+
+    return &counters;
+}
+
+
+const char * PerfCounters::getCounterName(unsigned int c) {
+    return c < NUM_PERF_COUNTERS ? counterNames[c] : "unknown";
+}
+
+
+/*
+ * Opens the events of one thread from first on as a group, the first event that opens
+ * leads it
+ */
+bool PerfCounters::openGroup(int tid, unsigned int first, Group &group) {
+
+    group.leader = -1;
+
+#ifdef PERF_HAS_EVENTS
+    for(unsigned int c = first; c < first + PERF_GROUP_SIZE && c < NUM_PERF_COUNTERS; c++) {
+
+        int fd = openEvent(counterEvents[c], tid, group.leader);
+
+        if(fd == -1)
+            continue;
+
+        if(group.leader == -1)
+            group.leader = fd;
+
+        group.fds.push_back(fd);
+        group.counters.push_back(c);
+    }
+
+    if(group.leader == -1)
+        return false;
+
+    ioctl(group.leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(group.leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#else
+    (void) tid;
+    (void) first;
+#endif
+
+    return group.leader != -1;
+}
+
+
+/*
+ * Opens the counters on every thread the process has now. Returns false and prints why
+ * when there are none to read, on other systems than Linux, in virtual machines without a
+ * virtual PMU, or when perf_event_paranoid does not let the user count
+ */
+bool PerfCounters::open() {
+
+    close();
+
+#ifdef PERF_HAS_EVENTS
+    DIR *tasks = opendir("/proc/self/task");
+
+    if(tasks == NULL) {
+        std::cerr << "Could not list the threads in /proc/self/task" << std::endl;
+        return false;
+    }
+
+    while(struct dirent *entry = readdir(tasks)) {
+
+        int tid = atoi(entry->d_name);
+        if(tid <= 0)
+            continue;
+
+        for(unsigned int c = 0; c < NUM_PERF_COUNTERS; c += PERF_GROUP_SIZE) {
+            Group group;
+            if(openGroup(tid, c, group))
+                groups.push_back(group);
+        }
+    }
+
+    closedir(tasks);
+
+    if(groups.empty()) {
+        std::cerr << "Could not open any hardware counter, see /proc/sys/kernel/perf_event_paranoid" << std::endl;
+        return false;
+    }
+
+    for(unsigned int g = 0; g < groups.size(); g++) {
+        for(unsigned int i = 0; i < groups[g].counters.size(); i++)
+            available[groups[g].counters[i]] = true;
+    }
+
+    buffer.resize(PERF_GROUP_SIZE + 3);
+    opened.store(true, std::memory_order_relaxed);
+
+    return true;
+#else
+    std::cerr << "Hardware counters are only read on Linux" << std::endl;
+    return false;
+#endif
+}
+
+
+void PerfCounters::close() {
+
+    opened.store(false, std::memory_order_relaxed);
+
+#ifdef PERF_HAS_EVENTS
+    for(unsigned int g = 0; g < groups.size(); g++) {
+        for(unsigned int i = 0; i < groups[g].fds.size(); i++)
+            ::close(groups[g].fds[i]);
+    }
+#endif
+
+    groups.clear();
+
+    for(unsigned int c = 0; c < NUM_PERF_COUNTERS; c++)
+        available[c] = false;
+}
+
+
+/*
+ * The counts of every event summed over the threads since the counters were opened, with
+ * how long they were enabled and counted. Reads every group of every thread and does not
+ * allocate
+ */
+void PerfCounters::read(Sample &sample) {
+
+    for(unsigned int c = 0; c < NUM_PERF_COUNTERS; c++) {
+        sample.value[c] = 0;
+        sample.enabled[c] = 0;
+        sample.running[c] = 0;
+    }
+
+#ifdef PERF_HAS_EVENTS
+    for(unsigned int g = 0; g < groups.size(); g++) {
+
+        const Group &group = groups[g];
+
+        // A group read gives the number of events, the time the group was enabled and the
+        // time it was counted, followed by the values
+        ssize_t size = ::read(group.leader, &buffer[0], buffer.size() * sizeof(uint64_t));
+        if(size < static_cast<ssize_t>(3 * sizeof(uint64_t)))
+            continue;
+
+        unsigned int n = static_cast<unsigned int>(std::min<uint64_t>(buffer[0], group.counters.size()));
+
+        for(unsigned int i = 0; i < n; i++) {
+            unsigned int c = group.counters[i];
+            sample.value[c] += buffer[i + 3];
+            sample.enabled[c] += buffer[1];
+            sample.running[c] += buffer[2];
+        }
+    }
+#endif
+}
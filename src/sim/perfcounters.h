@@ -0,0 +1,83 @@
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+// Hardware events that are counted
+#define PERF_CYCLES 0
+#define PERF_INSTRUCTIONS 1
+#define PERF_CACHE_REFERENCES 2
+#define PERF_CACHE_MISSES 3
+#define PERF_BRANCHES 4
+#define PERF_BRANCH_MISSES 5
+#define NUM_PERF_COUNTERS 6
+
+// Events per group, an event and the one it is divided by are always counted together
+#define PERF_GROUP_SIZE 2
+
+#include <atomic>
+#include <vector>
+#include <stdint.h>
+
+/*
+ * PerfCounters class
+ *  Reads the hardware counters of the CPU with perf_event_open on Linux: cycles,
+ *  instructions, last level cache references and misses, and branches and branch misses.
+ *  The events are opened in pairs per thread of the process, cycles with instructions,
+ *  cache references with misses and branches with branch misses, and a sample is the sum
+ *  over the threads. Only user space is counted.
+ *
+ *  A CPU with fewer free counters than events takes turns between the pairs, so every read
+ *  also gives how long each event was enabled and how long it was counted. A count is scaled
+ *  up by the time it missed, and an event that was never counted has a running time of zero.
+ *
+ *  Threads started after the counters were opened are not counted, open them again after
+ *  the number of threads changes. Where the kernel or the CPU does not offer an event it
+ *  reads as zero and isAvailable tells it apart from an event that did not happen.
+ */
+
+class PerfCounters {
+
+public:
+    struct Sample {
+        uint64_t value[NUM_PERF_COUNTERS];
+        uint64_t enabled[NUM_PERF_COUNTERS];    // Nanoseconds the event was enabled
+        uint64_t running[NUM_PERF_COUNTERS];    // and actually counted
+    };
+
+    // Constructors
+    PerfCounters();
+
+    // Destructor
+    ~PerfCounters();
+
+    static PerfCounters * instance();
+
+    // Member functions
+    bool open();
+    void close();
+    void read(Sample &);
+
+    static const char * getCounterName(unsigned int);
+
+    // Getters
+    bool isOpen() { return opened.load(std::memory_order_relaxed); };
+    bool isAvailable(unsigned int c) { return available[c]; };
+
+private:
+    struct Group {
+        int leader;
+        std::vector<int> fds;
+        std::vector<unsigned int> counters;     // Which event every member of the group counts
+    };
+
+    PerfCounters(const PerfCounters &);
+    PerfCounters & operator=(const PerfCounters &);
+
+    bool openGroup(int, unsigned int, Group &);
+
+    std::atomic<bool> opened;
+    bool available[NUM_PERF_COUNTERS];
+    std::vector<Group> groups;
+    std::vector<uint64_t> buffer;               // What one group read returns
+};
+
+#endif // PERFCOUNTERS_H
@@ -0,0 +1,359 @@
+#include "profiler.h"
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+static const char * phaseNames[NUM_PROFILE_PHASES] = {
+    "step",
+    "checkCollisions",
+    "applySpringForce",
+    "integrateVelocities",
+    "updateVertices",
+    "updateFaceNormals",
+    "updateVertexNormals",
+    "updateVertexNormalsList",
+    "flip",
+    "upload",
+    "draw"
+};
+
+
+Profiler::Profiler()
+    : enabled(false), frameStart(Clock::now()), frames(PROFILER_FRAMES), writeIndex(0), counting(false) {
+
+    for(unsigned int p = 0; p < NUM_PROFILE_PHASES; p++) {
+        phaseTime[p].store(0, std::memory_order_relaxed);
+        phaseCalls[p].store(0, std::memory_order_relaxed);
+    }
+
+    clearCounters();
+}
+
+
+Profiler * Profiler::instance() {
+
+    static Profiler profiler;
+
+    return &profiler;
+}
+
+
+const char * Profiler::getPhaseName(unsigned int phase) {
+    return phase < NUM_PROFILE_PHASES ? phaseNames[phase] : "unknown";
+}
+
+
+/*
+ * Moves the times of the current frame into the ring buffer and starts a new frame
+ */
+void Profiler::endFrame() {
+
+    Clock::time_point now = Clock::now();
+
+    if(!isEnabled()) {
+        frameStart = now;
+        return;
+    }
+
+    uint64_t index = writeIndex.load(std::memory_order_relaxed);
+    Frame &frame = frames[index % PROFILER_FRAMES];
+
+    for(unsigned int p = 0; p < NUM_PROFILE_PHASES; p++) {
+        frame.time[p] = phaseTime[p].exchange(0, std::memory_order_relaxed);
+        frame.calls[p] = phaseCalls[p].exchange(0, std::memory_order_relaxed);
+    }
+
+    frame.frameTime = std::chrono::duration_cast<std::chrono::nanoseconds>(now - frameStart).count();
+    frameStart = now;
+
+    // Publish the frame
+    writeIndex.store(index + 1, std::memory_order_release);
+}
+
+
+/*
+ * Forgets all recorded frames. Only call this from the thread that ends the frames
+ */
+void Profiler::clear() {
+
+    for(unsigned int p = 0; p < NUM_PROFILE_PHASES; p++) {
+        phaseTime[p].store(0, std::memory_order_relaxed);
+        phaseCalls[p].store(0, std::memory_order_relaxed);
+    }
+
+    writeIndex.store(0, std::memory_order_release);
+    frameStart = Clock::now();
+}
+
+
+/*
+ * Forgets the hardware counter totals of every phase
+ */
+void Profiler::clearCounters() {
+
+    for(unsigned int p = 0; p < NUM_PROFILE_PHASES; p++) {
+        for(unsigned int c = 0; c < NUM_PERF_COUNTERS; c++) {
+            counterTotals[p][c] = 0;
+            counterRunning[p][c] = 0;
+        }
+        counterCalls[p] = 0;
+    }
+}
+
+
+/*
+ * The frames still in the ring buffer, oldest first
+ */
+std::vector<Profiler::Frame> Profiler::getFrames() {
+
+    uint64_t end = writeIndex.load(std::memory_order_acquire);
+    uint64_t begin = end > PROFILER_FRAMES ? end - PROFILER_FRAMES : 0;
+
+    std::vector<Frame> result;
+    result.reserve(end - begin);
+
+    for(uint64_t i = begin; i < end; i++)
+        result.push_back(frames[i % PROFILER_FRAMES]);
+
+    return result;
+}
+
+
+/*
+ * One row per frame, the time of every phase in microseconds followed by how often it ran
+ */
+bool Profiler::writeCSV(const std::string &fileName) {
+
+    std::ofstream file(fileName.c_str());
+
+    if(!file) {
+        std::cerr << "Could not open " << fileName << std::endl;
+        return false;
+    }
+
+    std::vector<Frame> f = getFrames();
+    uint64_t first = getNumFrames() - f.size();
+
+    file << "frame,frame_us";
+    for(unsigned int p = 0; p < NUM_PROFILE_PHASES; p++)
+        file << "," << phaseNames[p] << "_us";
+    for(unsigned int p = 0; p < NUM_PROFILE_PHASES; p++)
+        file << "," << phaseNames[p] << "_calls";
+    file << std::endl;
+
+    for(unsigned int i = 0; i < f.size(); i++) {
+
+        file << first + i << "," << f[i].frameTime * 1e-3;
+        for(unsigned int p = 0; p < NUM_PROFILE_PHASES; p++)
+            file << "," << f[i].time[p] * 1e-3;
+        for(unsigned int p = 0; p < NUM_PROFILE_PHASES; p++)
+            file << "," << f[i].calls[p];
+        file << std::endl;
+    }
+
+    return true;
+}
+
+
+/*
+ * The same frames as the CSV file, as an array of objects with a "phases" object each
+ */
+bool Profiler::writeJSON(const std::string &fileName) {
+
+    std::ofstream file(fileName.c_str());
+
+    if(!file) {
+        std::cerr << "Could not open " << fileName << std::endl;
+        return false;
+    }
+
+    std::vector<Frame> f = getFrames();
+    uint64_t first = getNumFrames() - f.size();
+
+    file << "{\"unit\": \"us\", \"frames\": [" << std::endl;
+
+    for(unsigned int i = 0; i < f.size(); i++) {
+
+        file << "  {\"frame\": " << first + i << ", \"frame_us\": " << f[i].frameTime * 1e-3 << ", \"phases\": {";
+
+        for(unsigned int p = 0; p < NUM_PROFILE_PHASES; p++) {
+            file << (p > 0 ? ", " : "") << "\"" << phaseNames[p] << "\": {\"us\": " << f[i].time[p] * 1e-3
+                 << ", \"calls\": " << f[i].calls[p] << "}";
+        }
+
+        file << "}}" << (i + 1 < f.size() ? "," : "") << std::endl;
+    }
+
+    file << "]}" << std::endl;
+
+    return true;
+}
+
+
+/*
+ * Writes <name>.csv and <name>.json
+ */
+bool Profiler::dump(const std::string &name) {
+
+    bool ok = writeCSV(name + ".csv") && writeJSON(name + ".json");
+
+    if(ok)
+        std::cout << "Wrote " << getFrames().size() << " profiled frames to " << name << ".csv and " << name << ".json" << std::endl;
+
+    return ok;
+}
+
+
+/*
+ * A column of the counters table, a dash where an event it needs was not counted
+ */
+static void writeCounterColumn(std::ostream &out, int width, int precision, bool counted, double value) {
+
+    out << std::setw(width);
+
+    if(counted)
+        out << std::setprecision(precision) << value;
+    else
+        out << "-";
+}
+
+
+/*
+ * Per phase that was counted the calls, the cycles per call, instructions per cycle, the
+ * share of the last level cache references that missed, the misses per call and the share
+ * of the branches that were mispredicted
+ */
+void Profiler::writeCounters(std::ostream &out) {
+
+    PerfCounters *counters = PerfCounters::instance();
+
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+
+    out << std::left << std::setw(26) << "Hardware counters" << std::right << std::setw(10) << "calls"
+        << std::setw(16) << "cycles/call" << std::setw(8) << "IPC" << std::setw(14) << "cache miss %"
+        << std::setw(16) << "misses/call" << std::setw(15) << "branch miss %" << std::endl;
+
+    bool missing = false;
+
+    for(unsigned int p = 0; p < NUM_PROFILE_PHASES; p++) {
+
+        if(counterCalls[p] == 0)
+            continue;
+
+        const uint64_t *t = counterTotals[p];
+        double calls = static_cast<double>(counterCalls[p]);
+
+        bool counted[NUM_PERF_COUNTERS];
+        for(unsigned int c = 0; c < NUM_PERF_COUNTERS; c++) {
+            counted[c] = counterRunning[p][c] > 0;
+            missing = missing || !counted[c];
+        }
+
+        // A ratio needs both events, and something to divide by
+        bool ipc = counted[PERF_INSTRUCTIONS] && counted[PERF_CYCLES] && t[PERF_CYCLES] > 0;
+        bool cache = counted[PERF_CACHE_MISSES] && counted[PERF_CACHE_REFERENCES] && t[PERF_CACHE_REFERENCES] > 0;
+        bool branch = counted[PERF_BRANCH_MISSES] && counted[PERF_BRANCHES] && t[PERF_BRANCHES] > 0;
+
+        out << std::left << std::setw(26) << phaseNames[p] << std::right << std::setw(10) << counterCalls[p] << std::fixed;
+
+        writeCounterColumn(out, 16, 0, counted[PERF_CYCLES], t[PERF_CYCLES] / calls);
+        writeCounterColumn(out, 8, 2, ipc, ipc ? t[PERF_INSTRUCTIONS] / static_cast<double>(t[PERF_CYCLES]) : 0.0);
+        writeCounterColumn(out, 14, 2, cache, cache ? 100.0 * t[PERF_CACHE_MISSES] / t[PERF_CACHE_REFERENCES] : 0.0);
+        writeCounterColumn(out, 16, 1, counted[PERF_CACHE_MISSES], t[PERF_CACHE_MISSES] / calls);
+        writeCounterColumn(out, 15, 2, branch, branch ? 100.0 * t[PERF_BRANCH_MISSES] / t[PERF_BRANCHES] : 0.0);
+
+        out << std::endl;
+    }
+
+    for(unsigned int c = 0; c < NUM_PERF_COUNTERS; c++) {
+        if(!counters->isAvailable(c))
+            out << PerfCounters::getCounterName(c) << " is not counted on this machine" << std::endl;
+    }
+
+    if(missing)
+        out << "- is an event that was not counted while the phase ran, or a ratio with nothing to divide by" << std::endl;
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+
+/*
+ * One row per counted phase with the calls and the total of every counter, empty where the
+ * counter was not counted in the phase
+ */
+bool Profiler::writeCountersCSV(const std::string &fileName) {
+
+    std::ofstream file(fileName.c_str());
+
+    if(!file) {
+        std::cerr << "Could not open " << fileName << std::endl;
+        return false;
+    }
+
+    file << "phase,calls";
+    for(unsigned int c = 0; c < NUM_PERF_COUNTERS; c++)
+        file << "," << PerfCounters::getCounterName(c);
+    file << std::endl;
+
+    for(unsigned int p = 0; p < NUM_PROFILE_PHASES; p++) {
+
+        if(counterCalls[p] == 0)
+            continue;
+
+        file << phaseNames[p] << "," << counterCalls[p];
+        for(unsigned int c = 0; c < NUM_PERF_COUNTERS; c++) {
+            file << ",";
+            if(counterRunning[p][c] > 0)
+                file << counterTotals[p][c];
+        }
+        file << std::endl;
+    }
+
+    std::cout << "Hardware counters written to " << fileName << std::endl;
+
+    return true;
+}
+
+
+/*
+ * Opens the hardware counters and starts new totals, or closes them. Returns false when
+ * they could not be opened, the totals of the last time they were on are kept until then
+ */
+bool Profiler::setCounting(bool c) {
+
+    if(!c) {
+        counting.store(false, std::memory_order_relaxed);
+        PerfCounters::instance()->close();
+        return true;
+    }
+
+    if(!PerfCounters::instance()->open())
+        return false;
+
+    clearCounters();
+    counting.store(true, std::memory_order_relaxed);
+
+    return true;
+}
+
+
+void Profiler::setEnabled(bool e) {
+
+    // Start the first frame now, without what was timed when the profiler was last used
+    if(e && !isEnabled()) {
+        for(unsigned int p = 0; p < NUM_PROFILE_PHASES; p++) {
+            phaseTime[p].store(0, std::memory_order_relaxed);
+            phaseCalls[p].store(0, std::memory_order_relaxed);
+        }
+        frameStart = Clock::now();
+    }
+
+    enabled.store(e, std::memory_order_relaxed);
+}
+
+
+void Profiler::reportMemory(MemoryReport &report) {
+    report.add("profiler", "frames", frames);
+}
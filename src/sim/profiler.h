@@ -0,0 +1,177 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Phases of a frame that are timed
+#define PROFILE_STEP 0
+#define PROFILE_COLLISIONS 1
+#define PROFILE_SPRING_FORCE 2
+#define PROFILE_INTEGRATE 3
+#define PROFILE_UPDATE_VERTICES 4
+#define PROFILE_UPDATE_FACE_NORMALS 5
+#define PROFILE_UPDATE_VERTEX_NORMALS 6
+#define PROFILE_UPDATE_VERTEX_NORMALS_LIST 7
+#define PROFILE_FLIP 8
+#define PROFILE_UPLOAD 9
+#define PROFILE_DRAW 10
+#define NUM_PROFILE_PHASES 11
+
+// Frames kept in the ring buffer, a bit more than a minute at 60 Hz
+#define PROFILER_FRAMES 4096
+
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "tracer.h"
+#include "memoryreport.h"
+#include "perfcounters.h"
+
+/*
+ * Profiler class
+ *  Collects how long every phase of a frame takes. ScopedTimers add the time of a phase to
+ *  the current frame, and endFrame moves the frame into a ring buffer of the last
+ *  PROFILER_FRAMES frames, from where it can be written to CSV and JSON files.
+ *
+ *  The ring buffer has one writer, the thread that ends the frames, and the writer never
+ *  waits. A reader copies the frames between the oldest one still in the buffer and the
+ *  write index. When the profiler is disabled a timer costs one relaxed load and a branch.
+ *
+ *  With the hardware counters on, every timed phase also adds what PerfCounters counted while
+ *  it ran to totals per phase, to judge a change by its cache and branch misses and not only
+ *  by its time. The totals are kept from when the counters were turned on, not per frame,
+ *  and the phases that add to them must be timed from one thread. A count is scaled up by
+ *  the time the CPU spent counting other events, and an event that was never counted in a
+ *  phase is reported as not counted instead of as zero.
+ */
+
+class Profiler {
+
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Frame {
+        uint64_t time[NUM_PROFILE_PHASES];      // Nanoseconds spent in every phase
+        uint32_t calls[NUM_PROFILE_PHASES];     // Times the phase ran, steps for PROFILE_STEP
+        uint64_t frameTime;                     // Nanoseconds since the previous frame ended
+    };
+
+    // Constructors
+    Profiler();
+
+    static Profiler * instance();
+
+    // Member functions
+    void add(unsigned int phase, uint64_t ns) {
+        phaseTime[phase].fetch_add(ns, std::memory_order_relaxed);
+        phaseCalls[phase].fetch_add(1, std::memory_order_relaxed);
+    };
+
+    void addCounters(unsigned int phase, const PerfCounters::Sample &start, const PerfCounters::Sample &stop) {
+        for(unsigned int c = 0; c < NUM_PERF_COUNTERS; c++) {
+
+            uint64_t running = stop.running[c] - start.running[c];
+            if(running == 0)
+                continue;
+
+            double scale = static_cast<double>(stop.enabled[c] - start.enabled[c]) / running;
+            counterTotals[phase][c] += static_cast<uint64_t>(scale * (stop.value[c] - start.value[c]));
+            counterRunning[phase][c] += running;
+        }
+        counterCalls[phase]++;
+    };
+
+    void endFrame();
+    void clear();
+    void clearCounters();
+    void reportMemory(MemoryReport &);
+
+    std::vector<Frame> getFrames();
+    bool writeCSV(const std::string &);
+    bool writeJSON(const std::string &);
+    bool dump(const std::string &);
+    void writeCounters(std::ostream &);
+    bool writeCountersCSV(const std::string &);
+
+    static const char * getPhaseName(unsigned int);
+
+    // Getters
+    bool isEnabled() { return enabled.load(std::memory_order_relaxed); };
+    uint64_t getNumFrames() { return writeIndex.load(std::memory_order_acquire); };
+    bool isCounting() { return counting.load(std::memory_order_relaxed); };
+
+    // Setters
+    void setEnabled(bool);
+    bool setCounting(bool);
+
+private:
+    std::atomic<bool> enabled;
+
+    // The frame being timed
+    std::atomic<uint64_t> phaseTime[NUM_PROFILE_PHASES];
+    std::atomic<uint32_t> phaseCalls[NUM_PROFILE_PHASES];
+    Clock::time_point frameStart;
+
+    // Ring buffer of finished frames, frame i is in slot i % PROFILER_FRAMES
+    std::vector<Frame> frames;
+    std::atomic<uint64_t> writeIndex;
+
+    // Hardware counters of every phase since they were turned on
+    std::atomic<bool> counting;
+    uint64_t counterTotals[NUM_PROFILE_PHASES][NUM_PERF_COUNTERS];
+    uint64_t counterRunning[NUM_PROFILE_PHASES][NUM_PERF_COUNTERS];    // Nanoseconds, zero when never counted
+    uint64_t counterCalls[NUM_PROFILE_PHASES];
+};
+
+
+/*
+ * ScopedTimer class
+ *  Adds the time from its construction to its destruction to a phase of the current frame,
+ *  and records it as a trace event named after the phase when the tracer is on. With the
+ *  hardware counters on it reads them before and after, outside of the timed interval.
+ */
+
+class ScopedTimer {
+
+public:
+    ScopedTimer(unsigned int p)
+        : phase(p), profiling(Profiler::instance()->isEnabled()), tracing(Tracer::instance()->isEnabled()),
+          counting(Profiler::instance()->isCounting()) {
+        if(counting)
+            PerfCounters::instance()->read(startCounters);
+        if(profiling || tracing)
+            start = Profiler::Clock::now();
+    };
+
+    ~ScopedTimer() {
+        if(counting) {
+            PerfCounters::Sample stopCounters;
+            PerfCounters::instance()->read(stopCounters);
+            Profiler::instance()->addCounters(phase, startCounters, stopCounters);
+        }
+
+        if(!profiling && !tracing)
+            return;
+
+        Profiler::Clock::time_point stop = Profiler::Clock::now();
+
+        if(profiling)
+            Profiler::instance()->add(phase, std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count());
+        if(tracing)
+            Tracer::instance()->record(Profiler::getPhaseName(phase), start, stop);
+    };
+
+private:
+    ScopedTimer(const ScopedTimer &);
+    ScopedTimer & operator=(const ScopedTimer &);
+
+    unsigned int phase;
+    bool profiling;
+    bool tracing;
+    bool counting;
+    Profiler::Clock::time_point start;
+    PerfCounters::Sample startCounters;
+};
+
+#endif // PROFILER_H
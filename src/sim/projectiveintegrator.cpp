@@ -0,0 +1,242 @@
+#include "projectiveintegrator.h"
+#include <iostream>
+
+#define NOT_FREE 0xffffffffu
+
+ProjectiveIntegrator::ProjectiveIntegrator()
+    : current(NULL), steps(0), factoredPinVersion(0), factoredSprings(0), factoredDamping(0.0f),
+      numFactorizations(0) {
+
+    // Never grows past this, so current stays valid
+    factors.reserve(PROJECTIVE_MAX_FACTORS);
+}
+
+
+/*
+ * If the factorizations were made for other pins, springs or damping
+ */
+bool ProjectiveIntegrator::needsSystem(const ClothState &state, ClothForces &forces) {
+
+    if(state.forceDamping != factoredDamping || forces.getNumSprings() != factoredSprings ||
+       state.size() != factoredPins.size())
+        return true;
+
+    // The pins have been touched, but a setup often releases all knots and pins the same
+    // ones again
+    if(state.getPinVersion() != factoredPinVersion) {
+        factoredPinVersion = state.getPinVersion();
+        return state.pinned != factoredPins;
+    }
+
+    return false;
+}
+
+
+/*
+ * Numbers the free knots again and throws away the factorizations of the old system
+ */
+void ProjectiveIntegrator::buildSystem(const ClothState &state, ClothForces &forces) {
+
+    const unsigned int n = state.size();
+
+    row.assign(n, NOT_FREE);
+    freeKnots.clear();
+
+    for(unsigned int i = 0; i < n; i++) {
+        if(state.isPinned(i)) continue;
+        row[i] = freeKnots.size();
+        freeKnots.push_back(i);
+    }
+
+    b.resize(freeKnots.size());
+    x.resize(freeKnots.size());
+
+    factors.clear();
+
+    factoredPinVersion = state.getPinVersion();
+    factoredPins = state.pinned;
+    factoredSprings = forces.getNumSprings();
+    factoredDamping = state.forceDamping;
+}
+
+
+/*
+ * The factorization for steps of h, factored now if there is none yet
+ */
+ProjectiveIntegrator::Factorization * ProjectiveIntegrator::getFactorization(const ClothState &state, ClothForces &forces, float h) {
+
+    Factorization *oldest = NULL;
+
+    for(unsigned int f = 0; f < factors.size(); f++) {
+
+        if(factors[f].step == h)
+            return &factors[f];
+
+        if(oldest == NULL || factors[f].lastUsed < oldest->lastUsed)
+            oldest = &factors[f];
+    }
+
+    if(factors.size() < PROJECTIVE_MAX_FACTORS) {
+        factors.push_back(Factorization());
+        oldest = &factors.back();
+    }
+
+    factorize(*oldest, state, forces, h);
+    return oldest;
+}
+
+
+void ProjectiveIntegrator::factorize(Factorization &factor, const ClothState &state, ClothForces &forces, float h) {
+
+    const SpringSet *springs = forces.getSprings();
+    SparseCholesky &solver = factor.solver;
+
+    solver.clear(freeKnots.size());
+
+    for(unsigned int r = 0; r < freeKnots.size(); r++)
+        solver.addEntry(r, r, state.getMass(freeKnots[r]) / (h * h));
+
+    for(unsigned int s = 0; s < springs->size(); s++) {
+
+        float w = springs->stiffness[s] * state.forceDamping;
+        unsigned int ri = row[springs->first[s]];
+        unsigned int rj = row[springs->second[s]];
+
+        if(ri != NOT_FREE)
+            solver.addEntry(ri, ri, w);
+        if(rj != NOT_FREE)
+            solver.addEntry(rj, rj, w);
+        if(ri != NOT_FREE && rj != NOT_FREE)
+            solver.addEntry(ri, rj, -w);
+    }
+
+    factor.factored = solver.factor();
+    if(!factor.factored)
+        std::cout << "Projective dynamics system is not positive definite" << std::endl;
+
+    factor.step = h;
+    numFactorizations++;
+}
+
+
+/*
+ * Moves the knots to where gravity and wind alone would take them
+ */
+void ProjectiveIntegrator::applyForces(ClothState &state, ClothForces &forces, const glm::vec3 G, float h) {
+
+    const unsigned int n = state.size();
+
+    // The springs are never evaluated at the knots the step starts from
+    forces.measure(state);
+
+    if(needsSystem(state, forces))
+        buildSystem(state, forces);
+
+    current = getFactorization(state, forces, h);
+    current->lastUsed = ++steps;
+
+    previous.resize(n);
+    inertia.resize(n);
+    rhs.resize(n);
+    projection.resize(forces.getNumSprings());
+
+    forces.computeExternalForces(state, &state.force[0]);
+
+    for(unsigned int i = 0; i < n; i++) {
+
+        previous[i] = state.position[i];
+
+        if(state.isPinned(i)) continue;
+
+        glm::vec3 y = state.position[i] + state.velocity[i] * h + (state.force[i] * state.invMass[i] + G) * (h * h);
+        inertia[i] = y * (state.getMass(i) / (h * h));
+        state.position[i] = y;
+    }
+}
+
+
+/*
+ * Local/global iterations, then the velocities from how far the knots moved
+ */
+void ProjectiveIntegrator::integrate(ClothState &state, ClothForces &forces, const glm::vec3 /* G */, float h) {
+
+    if(current == NULL || !current->factored)
+        return;
+
+    const unsigned int n = state.size();
+    const SpringSet *springs = forces.getSprings();
+    const unsigned int grain = forces.getSpringGrainSize();
+    const float forceDamping = state.forceDamping;
+
+    const glm::vec3 *p = &state.position[0];
+    glm::vec3 *d = &projection[0];
+    glm::vec3 *r = &rhs[0];
+
+    for(unsigned int iteration = 0; iteration < PROJECTIVE_ITERATIONS; iteration++) {
+
+        // Local step, every spring on its own
+        ThreadPool::instance()->parallelFor(0, springs->size(), grain,
+            [springs, p, d](unsigned int begin, unsigned int end) {
+                for(unsigned int s = begin; s < end; s++) {
+                    glm::vec3 delta = p[springs->first[s]] - p[springs->second[s]];
+                    float length = glm::length(delta);
+                    d[s] = (length > 0.0f) ? delta * (springs->restLength[s] / length) : delta;
+                }
+            });
+
+        // Right hand side. Pinned neighbours are known so they move over from the matrix.
+        for(unsigned int i = 0; i < n; i++)
+            r[i] = state.isPinned(i) ? state.position[i] : inertia[i];
+
+        const unsigned char *pinned = &state.pinned[0];
+
+        for(unsigned int c = 0; c < springs->getNumColors(); c++) {
+            ThreadPool::instance()->parallelFor(springs->colorOffsets[c], springs->colorOffsets[c + 1], grain,
+                [springs, p, d, r, pinned, forceDamping](unsigned int begin, unsigned int end) {
+                    for(unsigned int s = begin; s < end; s++) {
+
+                        unsigned int i = springs->first[s];
+                        unsigned int j = springs->second[s];
+
+                        float k = springs->stiffness[s] * forceDamping;
+
+                        if(!pinned[i])
+                            r[i] += k * (pinned[j] ? d[s] + p[j] : d[s]);
+                        if(!pinned[j])
+                            r[j] -= k * (pinned[i] ? d[s] - p[i] : d[s]);
+                    }
+                });
+        }
+
+        // Global step
+        for(unsigned int k = 0; k < freeKnots.size(); k++)
+            b[k] = r[freeKnots[k]];
+
+        current->solver.solve(&b[0], &x[0]);
+
+        for(unsigned int k = 0; k < freeKnots.size(); k++)
+            state.position[freeKnots[k]] = x[k];
+    }
+
+    for(unsigned int i = 0; i < n; i++) {
+        if(state.isPinned(i)) continue;
+        state.velocity[i] = (state.position[i] - previous[i]) / h;
+    }
+}
+
+
+void ProjectiveIntegrator::reportMemory(MemoryReport &report) {
+
+    for(unsigned int f = 0; f < factors.size(); f++)
+        factors[f].solver.reportMemory(report);
+
+    report.add("integrator", "projective row", row);
+    report.add("integrator", "projective freeKnots", freeKnots);
+    report.add("integrator", "projective previous", previous);
+    report.add("integrator", "projective inertia", inertia);
+    report.add("integrator", "projective projection", projection);
+    report.add("integrator", "projective rhs", rhs);
+    report.add("integrator", "projective b", b);
+    report.add("integrator", "projective x", x);
+    report.add("integrator", "projective factoredPins", factoredPins);
+}
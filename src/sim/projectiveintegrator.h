@@ -0,0 +1,89 @@
+#ifndef PROJECTIVEINTEGRATOR_H
+#define PROJECTIVEINTEGRATOR_H
+
+// Local/global iterations per step
+#define PROJECTIVE_ITERATIONS 10
+
+// Stable for any step, but the cloth gets too damped beyond this
+#define PROJECTIVE_MAX_STEP (1.0f / 120.0f)
+
+// Factorizations kept for different step sizes, enough for every level of the scheduler and
+// every halving of a rolled back step
+#define PROJECTIVE_MAX_FACTORS 8
+
+#include <vector>
+#include "integrator.h"
+#include "sparsecholesky.h"
+
+/*
+ * ProjectiveIntegrator class
+ *  Projective dynamics for the mass-spring cloth. Every step alternates a local step, where
+ *  each spring is projected to its rest length, and a global step that solves
+ *
+ *      (M / h^2 + sum k A^T A) x = M / h^2 y + sum k A^T d
+ *
+ *  for the positions, where y is where the knots would go without the springs. The matrix
+ *  only depends on the topology, the pinned knots, the step size and the force damping, so it
+ *  is factored once and every iteration is a back substitution. The steps come in a few
+ *  halvings of a frame, from the scheduler or a rolled back step, so a factorization is kept
+ *  for each of up to PROJECTIVE_MAX_FACTORS step sizes, and the one used longest ago makes
+ *  room for a new one. They are all thrown away when anything else changes, in practice when
+ *  a setup pins other knots.
+ *
+ *  The spring damping is left out, it would either end up in the matrix along every
+ *  direction and stop the cloth from swinging, or change the matrix every step. The
+ *  solver damps like backward Euler on its own.
+ */
+
+class ProjectiveIntegrator : public Integrator {
+
+public:
+    // Constructors
+    ProjectiveIntegrator();
+
+    void applyForces(ClothState &, ClothForces &, const glm::vec3, float);
+    void integrate(ClothState &, ClothForces &, const glm::vec3, float);
+
+    float getMaxStep(const ClothState &, ClothForces &) { return PROJECTIVE_MAX_STEP; };
+    unsigned int getType() { return INTEGRATOR_PROJECTIVE; };
+    unsigned int getNumFactorizations() { return numFactorizations; };
+    void reportMemory(MemoryReport &);
+
+private:
+    struct Factorization {
+        SparseCholesky solver;
+        float step;
+        bool factored;
+        unsigned int lastUsed;  // Step it was last used in
+    };
+
+    bool needsSystem(const ClothState &, ClothForces &);
+    void buildSystem(const ClothState &, ClothForces &);
+    Factorization * getFactorization(const ClothState &, ClothForces &, float);
+    void factorize(Factorization &, const ClothState &, ClothForces &, float);
+
+    std::vector<Factorization> factors;
+    Factorization *current;     // For the step being taken
+    unsigned int steps;
+
+    // Pinned knots are not part of the system, row[i] is the row of knot i or NOT_FREE
+    std::vector<unsigned int> row;
+    std::vector<unsigned int> freeKnots;
+
+    std::vector<glm::vec3> previous;    // Positions at the start of the step
+    std::vector<glm::vec3> inertia;     // M / h^2 y
+    std::vector<glm::vec3> projection;  // Projected spring vectors d
+    std::vector<glm::vec3> rhs;         // Right hand side per knot
+    std::vector<glm::vec3> b;           // Right hand side per row
+    std::vector<glm::vec3> x;           // Solution per row
+
+    // What the factorizations were made for, apart from the step
+    unsigned int factoredPinVersion;
+    std::vector<unsigned char> factoredPins;
+    unsigned int factoredSprings;
+    float factoredDamping;
+
+    unsigned int numFactorizations;
+};
+
+#endif // PROJECTIVEINTEGRATOR_H
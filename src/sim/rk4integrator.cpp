@@ -0,0 +1,111 @@
+#include "rk4integrator.h"
+
+void RK4Integrator::resize(unsigned int n) {
+
+    if(stageX.size() == n)
+        return;
+
+    stageX.resize(n);
+    stageV.resize(n);
+    stageF.resize(n);
+    sumX.resize(n);
+    sumV.resize(n);
+}
+
+
+/*
+ * First stage, the forces at the start of the step
+ */
+void RK4Integrator::applyForces(ClothState &state, ClothForces &forces, const glm::vec3 G, float dt) {
+
+    resize(state.size());
+
+    forces.computeStateForces(state);
+
+    const ClothState *s = &state;
+
+    ThreadPool::instance()->parallelFor(0, state.size(), KNOT_GRAIN_SIZE,
+        [this, s](unsigned int begin, unsigned int end) {
+            for(unsigned int i = begin; i < end; i++) {
+                sumX[i] = glm::vec3(0.0f, 0.0f, 0.0f);
+                sumV[i] = glm::vec3(0.0f, 0.0f, 0.0f);
+                stageV[i] = s->velocity[i];
+                stageF[i] = s->force[i];
+            }
+        });
+
+    // k1, and the state at the midpoint for k2
+    addStage(state, G, 1.0f, dt * 0.5f);
+}
+
+
+/*
+ * Remaining stages and the final update
+ */
+void RK4Integrator::integrate(ClothState &state, ClothForces &forces, const glm::vec3 G, float dt) {
+
+    resize(state.size());
+
+    // k2, and the state at the midpoint for k3
+    forces.computeForces(state, &stageX[0], &stageV[0], &stageF[0]);
+    addStage(state, G, 2.0f, dt * 0.5f);
+
+    // k3, and the state at the end for k4
+    forces.computeForces(state, &stageX[0], &stageV[0], &stageF[0]);
+    addStage(state, G, 2.0f, dt);
+
+    // k4
+    forces.computeForces(state, &stageX[0], &stageV[0], &stageF[0]);
+    addStage(state, G, 1.0f, 0.0f);
+
+    ClothState *s = &state;
+
+    ThreadPool::instance()->parallelFor(0, state.size(), KNOT_GRAIN_SIZE,
+        [this, s, dt](unsigned int begin, unsigned int end) {
+            for(unsigned int i = begin; i < end; i++) {
+                if(s->isPinned(i)) continue;
+                s->position[i] += sumX[i] * (dt / 6.0f);
+                s->velocity[i] += sumV[i] * (dt / 6.0f);
+            }
+        });
+}
+
+
+/*
+ * Adds the derivative of the current stage with the given weight to the sums, and sets up
+ *  the next stage at h from the start of the step along that derivative.
+ */
+void RK4Integrator::addStage(const ClothState &state, const glm::vec3 G, float weight, float h) {
+
+    const ClothState *s = &state;
+
+    ThreadPool::instance()->parallelFor(0, state.size(), KNOT_GRAIN_SIZE,
+        [this, s, G, weight, h](unsigned int begin, unsigned int end) {
+            for(unsigned int i = begin; i < end; i++) {
+
+                if(s->isPinned(i)) {
+                    stageX[i] = s->position[i];
+                    stageV[i] = s->velocity[i];
+                    continue;
+                }
+
+                glm::vec3 dx = stageV[i];
+                glm::vec3 dv = stageF[i] * s->invMass[i] + G;
+
+                sumX[i] += weight * dx;
+                sumV[i] += weight * dv;
+
+                stageX[i] = s->position[i] + dx * h;
+                stageV[i] = s->velocity[i] + dv * h;
+            }
+        });
+}
+
+
+void RK4Integrator::reportMemory(MemoryReport &report) {
+    report.add("integrator", "RK4 stageX", stageX);
+    report.add("integrator", "RK4 stageV", stageV);
+    report.add("integrator", "RK4 stageF", stageF);
+    report.add("integrator", "RK4 sumX", sumX);
+    report.add("integrator", "RK4 sumV", sumV);
+}
@@ -0,0 +1,38 @@
+#ifndef RK4INTEGRATOR_H
+#define RK4INTEGRATOR_H
+
+// Runge-Kutta 4 stays stable for longer steps than explicit Euler
+#define RK4_STABILITY 1.4f
+
+#include <vector>
+#include "integrator.h"
+
+/*
+ * RK4Integrator class
+ *  Classic Runge-Kutta 4 over the whole cloth. The spring, damping and wind forces are
+ *  evaluated again at every stage, so the springs are integrated to fourth order and not
+ *  only the gravity. The stage buffers are kept between steps so a step does not allocate.
+ */
+
+class RK4Integrator : public Integrator {
+
+public:
+    void applyForces(ClothState &, ClothForces &, const glm::vec3, float);
+    void integrate(ClothState &, ClothForces &, const glm::vec3, float);
+
+    float getMaxStep(const ClothState &s, ClothForces &f) { return RK4_STABILITY * f.computeStableStep(s); };
+    unsigned int getType() { return INTEGRATOR_RK4; };
+    void reportMemory(MemoryReport &);
+
+private:
+    void resize(unsigned int);
+    void addStage(const ClothState &, const glm::vec3, float, float);
+
+    std::vector<glm::vec3> stageX;      // Positions of the stage being evaluated
+    std::vector<glm::vec3> stageV;      // Velocities of the stage being evaluated
+    std::vector<glm::vec3> stageF;      // Forces of the stage being evaluated
+    std::vector<glm::vec3> sumX;        // Weighted sum of the position derivatives so far
+    std::vector<glm::vec3> sumV;        // Weighted sum of the velocity derivatives so far
+};
+
+#endif // RK4INTEGRATOR_H
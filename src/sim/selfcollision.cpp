@@ -0,0 +1,174 @@
+#include "selfcollision.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include "threadpool.h"
+
+SelfCollision::SelfCollision()
+    : enabled(true), built(false), side(1), thickness(0.0f), mask(0) {
+
+}
+
+
+/*
+ * Sorts the knots into the cells of the grid. The side is the knots along each side of the
+ * cloth and the spacing how far apart they are. Only allocates when the knots change
+ */
+void SelfCollision::build(const ClothState &s, unsigned int n, float spacing) {
+
+    built = false;
+
+    if(!enabled || s.size() == 0)
+        return;
+
+    const unsigned int knots = s.size();
+
+    side = n;
+    thickness = SELF_COLLISION_THICKNESS * spacing;
+
+    // At least two buckets per knot, a power of two so the hash is masked
+    unsigned int buckets = 1;
+    while(buckets < 2 * knots)
+        buckets *= 2;
+
+    mask = buckets - 1;
+
+    if(knotCell.size() != knots || bucketStart.size() != buckets + 1) {
+        knotCell.resize(knots);
+        bucketStart.resize(buckets + 1);
+        sorted.resize(knots);
+    }
+
+    const float inverse = 1.0f / thickness;
+    const glm::vec3 *x = &s.position[0];
+    glm::ivec3 *cell = &knotCell[0];
+
+    // Converting a NaN or a float beyond the range of an int is undefined
+    const glm::vec3 limit(static_cast<float>(SELF_COLLISION_MAX_CELL));
+
+    ThreadPool::instance()->parallelFor(0, knots, KNOT_GRAIN_SIZE,
+        [x, cell, inverse, limit](unsigned int begin, unsigned int end) {
+            for(unsigned int i = begin; i < end; i++) {
+                glm::vec3 c = glm::floor(x[i] * inverse);
+
+                if(std::isfinite(c.x) && std::isfinite(c.y) && std::isfinite(c.z))
+                    cell[i] = glm::ivec3(glm::clamp(c, -limit, limit));
+                else
+                    cell[i] = glm::ivec3(SELF_COLLISION_NO_CELL, SELF_COLLISION_NO_CELL, SELF_COLLISION_NO_CELL);
+            }
+        });
+
+    // Counting sort, count every bucket, sum them up to where they end and walk the knots
+    // backwards so every bucket ends up in knot order
+    std::fill(bucketStart.begin(), bucketStart.end(), 0);
+
+    for(unsigned int i = 0; i < knots; i++)
+        bucketStart[getBucket(knotCell[i])]++;
+
+    for(unsigned int b = 1; b <= buckets; b++)
+        bucketStart[b] += bucketStart[b - 1];
+
+    for(unsigned int i = knots; i-- > 0; ) {
+
+        Entry &e = sorted[--bucketStart[getBucket(knotCell[i])]];
+
+        e.position = s.position[i];
+        e.velocity = s.velocity[i];
+        e.cell = knotCell[i];
+        e.row = i / side;
+        e.column = i % side;
+        e.share = s.isPinned(i) ? 1.0f : 0.5f;
+    }
+
+    built = true;
+}
+
+
+/*
+ * Pushes knot i out of the other knots it is too close to, call build() first this substep
+ */
+void SelfCollision::resolve(ClothState &s, unsigned int i) {
+
+    if(!built || s.isPinned(i) || knotCell[i].x == SELF_COLLISION_NO_CELL)
+        return;
+
+    Query q;
+    q.position = s.position[i];
+    q.velocity = s.velocity[i];
+    q.cell = knotCell[i];
+    q.row = i / side;
+    q.column = i % side;
+    q.dx = glm::vec3(0.0f);
+    q.dv = glm::vec3(0.0f);
+
+    for(int z = -1; z <= 1; z++) {
+        for(int y = -1; y <= 1; y++) {
+
+            const glm::ivec3 row = q.cell + glm::ivec3(0, y, z);
+
+            // The three cells along x, in one range unless it wraps around the table
+            const unsigned int first = getBucket(row + glm::ivec3(-1, 0, 0));
+
+            if(first + 2 <= mask) {
+                resolveRange(q, row, bucketStart[first], bucketStart[first + 3]);
+            } else {
+                for(unsigned int b = 0; b < 3; b++) {
+                    unsigned int bucket = (first + b) & mask;
+                    resolveRange(q, row, bucketStart[bucket], bucketStart[bucket + 1]);
+                }
+            }
+        }
+    }
+
+    s.position[i] += q.dx;
+    s.velocity[i] += q.dv;
+}
+
+
+/*
+ * Adds the contacts with the sorted knots [begin, end) that are in the cells along x around
+ * the cell row
+ */
+void SelfCollision::resolveRange(Query &q, const glm::ivec3 &row, unsigned int begin, unsigned int end) const {
+
+    for(unsigned int k = begin; k < end; k++) {
+
+        const Entry &e = sorted[k];
+
+        // Other cells share the buckets
+        if(e.cell.y != row.y || e.cell.z != row.z || std::abs(e.cell.x - row.x) > 1)
+            continue;
+
+        glm::vec3 d = q.position - e.position;
+        float distance2 = glm::dot(d, d);
+
+        if(distance2 >= thickness * thickness)
+            continue;
+
+        // Near in the cloth, the springs keep them apart. The knot itself is one of them
+        if(std::abs(e.row - q.row) <= SELF_COLLISION_RING && std::abs(e.column - q.column) <= SELF_COLLISION_RING)
+            continue;
+
+        float distance = std::sqrt(distance2);
+        glm::vec3 normal;
+
+        // Knots on top of each other have no direction between them, they are pushed apart
+        // along y, the knot later in the cloth up and the other one down
+        if(distance > 0.0f)
+            normal = d / distance;
+        else
+            normal = glm::vec3(0.0f, (q.row > e.row || (q.row == e.row && q.column > e.column)) ? 1.0f : -1.0f, 0.0f);
+
+        q.dx += (e.share * (thickness - distance)) * normal;
+
+        float approach = glm::dot(q.velocity - e.velocity, normal);
+        if(approach < 0.0f)
+            q.dv -= (e.share * approach) * normal;
+    }
+}
+
+void SelfCollision::reportMemory(MemoryReport &report) {
+    report.add("self collision", "knotCell", knotCell);
+    report.add("self collision", "bucketStart", bucketStart);
+    report.add("self collision", "sorted", sorted);
+}
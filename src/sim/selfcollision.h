@@ -0,0 +1,100 @@
+#ifndef SELFCOLLISION_H
+#define SELFCOLLISION_H
+
+// Closest two knots of a cloth may come, as a fraction of the knot spacing. The middle of a
+// square of knots is 0.71 spacings from its corners, so a knot cannot slip through it
+#define SELF_COLLISION_THICKNESS 0.75f
+
+// Knots this many rows and columns apart or less are held apart by the springs, they never
+// collide with each other
+#define SELF_COLLISION_RING 2
+
+// Cell coordinates are clamped to this, far outside any scene, so they always fit in an int.
+// Knots that are not finite go in a cell beyond it, next to no other cell
+#define SELF_COLLISION_MAX_CELL 1048576
+#define SELF_COLLISION_NO_CELL (SELF_COLLISION_MAX_CELL + 2)
+
+#include <glm/glm.hpp>
+#include <vector>
+#include "clothstate.h"
+#include "memoryreport.h"
+
+/*
+ * SelfCollision class
+ *  Keeps the knots of a cloth from passing through each other. Every substep build() sorts
+ *  the knots into a uniform grid of cells as wide as the thickness, hashed into a table of
+ *  buckets with a counting sort, in time linear in the knots. The sorted copy of the
+ *  positions and velocities is what the knots are tested against.
+ *
+ *  The hash is linear in the cell coordinates, so the cells next to each other along x are
+ *  in buckets next to each other, and the 27 cells around a knot are 9 runs of 3 buckets
+ *  that each are one contiguous range of the sorted knots.
+ *
+ *  resolve() looks up the cells around a knot and pushes it out of every knot closer than
+ *  the thickness, and takes away the velocity it approaches that knot with. It only
+ *  changes the knot it is given and only reads the sorted copy, so every knot can be
+ *  resolved from a different thread, and the result does not depend on the order. Both knots
+ *  of a contact take half of it, a pinned knot none. Knots near each other in the grid of the
+ *  cloth are skipped by comparing their rows and columns. Knots on top of each other are
+ *  pushed apart along y. A knot with a NaN or infinite position is neither resolved nor
+ *  pushed against.
+ */
+
+class SelfCollision {
+
+public:
+    // Constructors
+    SelfCollision();
+
+    // Member functions
+    void build(const ClothState &, unsigned int, float);
+    void resolve(ClothState &, unsigned int);
+    void reportMemory(MemoryReport &);
+
+    // Getters
+    bool isEnabled() { return enabled; };
+
+    // Setters
+    void setEnabled(bool e) { enabled = e; };
+
+private:
+    struct Entry {
+        glm::vec3 position;
+        glm::vec3 velocity;
+        glm::ivec3 cell;
+        int row;            // Of the knot in the cloth
+        int column;
+        float share;        // Of a contact this knot does not take, 1 when it is pinned
+    };
+
+    unsigned int getBucket(const glm::ivec3 &c) const {
+        return (static_cast<unsigned int>(c.x) + static_cast<unsigned int>(c.y) * 19349663u +
+                static_cast<unsigned int>(c.z) * 83492791u) & mask;
+    };
+
+    // One knot being resolved and what its contacts add up to
+    struct Query {
+        glm::vec3 position;
+        glm::vec3 velocity;
+        glm::ivec3 cell;
+        int row;
+        int column;
+        glm::vec3 dx;
+        glm::vec3 dv;
+    };
+
+    void resolveRange(Query &, const glm::ivec3 &, unsigned int, unsigned int) const;
+
+    bool enabled;
+    bool built;             // Since the knots were last sorted
+    unsigned int side;      // Knots along each side of the cloth
+    float thickness;
+    unsigned int mask;      // Buckets - 1
+
+    std::vector<glm::ivec3> knotCell;           // Cell of every knot, by knot index
+    std::vector<unsigned int> bucketStart;      // Bucket b is [bucketStart[b], bucketStart[b + 1])
+
+    std::vector<Entry> sorted;                  // The knots sorted by bucket
+};
+
+#endif // SELFCOLLISION_H
@@ -0,0 +1,341 @@
+#include "simulation.h"
+#include "profiler.h"
+#include <algorithm>
+#include <cfloat>
+
+Simulation::Simulation()
+    : t(0.0f), dt(0.0f), acceleration(glm::vec3(0.0f, 0.0f, 0.0f)), integrator(INTEGRATOR_EXPLICIT),
+      stabilityControl(true), rollbacks(0), failedSteps(0), lastStep(0.0f), stepLimit(FLT_MAX), stableSteps(0),
+      pathTime(0.0f) {
+
+}
+
+
+void Simulation::addCloth(Cloth *c) {
+    cloths.push_back(c);
+    monitors.push_back(StabilityMonitor());
+    c->setIntegrator(integrator);
+}
+
+
+void Simulation::addCollider(Collider *c) {
+    colliders.push_back(c);
+}
+
+
+void Simulation::reset() {
+
+    for(std::vector<Cloth *>::iterator it = cloths.begin(); it != cloths.end(); ++it)
+        (*it)->reset();
+
+    for(std::vector<Collider *>::iterator it = colliders.begin(); it != colliders.end(); ++it)
+        (*it)->reset();
+
+    for(unsigned int c = 0; c < monitors.size(); c++)
+        monitors[c].reset();
+
+    stepLimit = FLT_MAX;
+    stableSteps = 0;
+    lastStep = 0.0f;
+    pathTime = 0.0f;
+}
+
+
+/*
+ * Box around knots [begin, end) and where they were at the last substep
+ */
+static void getKnotBounds(const ClothState &s, unsigned int begin, unsigned int end, glm::vec3 &lower, glm::vec3 &upper) {
+
+    lower = glm::vec3(FLT_MAX);
+    upper = glm::vec3(-FLT_MAX);
+
+    for(unsigned int i = begin; i < end; i++) {
+        lower = glm::min(lower, glm::min(s.position[i], s.previousPosition[i]));
+        upper = glm::max(upper, glm::max(s.position[i], s.previousPosition[i]));
+    }
+}
+
+
+static bool overlaps(const glm::vec3 &lowerA, const glm::vec3 &upperA, const glm::vec3 &lowerB, const glm::vec3 &upperB) {
+    return lowerA.x <= upperB.x && lowerB.x <= upperA.x &&
+           lowerA.y <= upperB.y && lowerB.y <= upperA.y &&
+           lowerA.z <= upperB.z && lowerB.z <= upperA.z;
+}
+
+
+void Simulation::checkCollisions() {
+    collide(false, 0.0f);
+}
+
+
+/*
+ * Resolves the collisions of every cloth, the time into the step. With snapshot the knots are
+ * saved afterwards by the monitors, so the substep that starts from them can be rolled back
+ */
+void Simulation::collide(bool snapshot, float time) {
+
+    ScopedTimer timer(PROFILE_COLLISIONS);
+
+    for(std::vector<Collider *>::iterator it = colliders.begin(); it != colliders.end(); ++it)
+        (*it)->beginSubstep(time, pathTime);
+
+    for(unsigned int k = 0; k < cloths.size(); k++) {
+
+        Cloth *cloth = cloths[k];
+        ClothState *state = cloth->getState();
+        const std::vector<Collider *> *c = &colliders;
+        StabilityMonitor *monitor = snapshot ? &monitors[k] : NULL;
+
+        cloth->buildCollisionGrid();
+
+        // A setup may have moved the knots, the first path starts where they are
+        if(!state->hasPreviousPosition())
+            state->setPreviousPosition();
+
+        if(monitor)
+            monitor->beginSnapshot(*state);
+
+        // A collision only moves the knot it is resolved for, so the knots are split between
+        // the threads. Every range of knots meets the cloth itself first, then the colliders
+        // in order. A collider is skipped when it does not overlap the box around the knots,
+        // which is measured again once a collider may have moved them. Where the knots end up
+        // is where their paths start in the next substep
+        ThreadPool::instance()->parallelFor(0, state->size(), KNOT_GRAIN_SIZE,
+            [cloth, state, c, monitor](unsigned int begin, unsigned int end) {
+
+                cloth->resolveCollisions(*state, begin, end);
+
+                glm::vec3 lower, upper;
+                getKnotBounds(*state, begin, end, lower, upper);
+
+                for(std::vector<Collider *>::const_iterator it = c->begin(); it != c->end(); ++it) {
+
+                    glm::vec3 colliderLower, colliderUpper;
+                    (*it)->getBounds(colliderLower, colliderUpper);
+
+                    if(!overlaps(lower, upper, colliderLower, colliderUpper))
+                        continue;
+
+                    (*it)->resolveCollisions(*state, begin, end);
+
+                    if(it + 1 != c->end())
+                        getKnotBounds(*state, begin, end, lower, upper);
+                }
+
+                std::copy(state->position.begin() + begin, state->position.begin() + end,
+                          state->previousPosition.begin() + begin);
+
+                if(monitor)
+                    monitor->saveSnapshot(*state, begin, end);
+            });
+    }
+
+    pathTime = 0.0f;
+}
+
+
+void Simulation::step() {
+
+    ScopedTimer timer(PROFILE_STEP);
+
+    for(std::vector<Collider *>::iterator it = colliders.begin(); it != colliders.end(); ++it)
+        (*it)->beginCollisions(dt);
+
+    if(stabilityControl) {
+        takeStableSteps();
+    } else {
+        takeStep();
+        lastStep = 0.0f;
+    }
+
+    // The knots may still be rolled back until the last substep, queries come between steps
+    for(std::vector<Cloth *>::iterator it = cloths.begin(); it != cloths.end(); ++it)
+        (*it)->refitTriangleBVH();
+
+    // Not after every substep, the substeps of a step follow the paths of the colliders over
+    // the whole step
+    for(std::vector<Collider *>::iterator it = colliders.begin(); it != colliders.end(); ++it)
+        (*it)->endCollisions();
+}
+
+
+void Simulation::takeStep() {
+
+    checkCollisions();
+    //applyG();
+    applySpringForce();
+    integrateVelocities();
+    //enforceMaximumStretch();
+}
+
+
+/*
+ * Takes a step of dt as substeps no longer than the step limit. The forces of every substep
+ * measure the knots the substep before left behind, an unstable one is rolled back and taken
+ * again with half the length, down to dt / 2^STABILITY_MAX_HALVINGS. The energy must stay
+ * finite, when it does not the substep is rolled back if it can be and the step ends there
+ */
+void Simulation::takeStableSteps() {
+
+    const float step = dt;
+    const float time = t;
+    const float shortest = step / (1 << STABILITY_MAX_HALVINGS);
+
+    // A rollback may add back a substep of an earlier step, with another dt, so the remaining
+    // time is not always a multiple of the shortest substep
+    float remaining = step;
+
+    while(remaining > 1e-3f * shortest) {
+
+        float h = step;
+        while(h > stepLimit && h > shortest)
+            h *= 0.5f;
+        h = std::min(h, remaining);
+
+        dt = h;
+
+        collide(true, step - remaining);
+        applySpringForce();
+
+        bool stable = true;
+        bool finite = true;
+        bool canRollBack = lastStep > 0.0f;
+
+        for(unsigned int c = 0; c < cloths.size(); c++) {
+
+            ClothState *state = cloths[c]->getState();
+
+            monitors[c].measure(cloths[c]->getForces()->getTelemetry(), acceleration, cloths[c]->getKnotSpacing());
+
+            // After a reset the first finite knots are the reference
+            if(monitors[c].needsReference(*state) && monitors[c].isFinite())
+                monitors[c].accept(*state);
+
+            stable = monitors[c].isStable() && stable;
+            finite = monitors[c].isFinite() && finite;
+            canRollBack = monitors[c].canRollBack(*state) && canRollBack;
+        }
+
+        if(!finite || (!stable && canRollBack && 0.5f * lastStep >= shortest)) {
+
+            if(canRollBack) {
+                for(unsigned int c = 0; c < cloths.size(); c++)
+                    monitors[c].rollBack(*cloths[c]->getState());
+
+                rollbacks++;
+                pathTime = 0.0f;
+                remaining += lastStep;
+                t -= lastStep;
+                stepLimit = std::min(stepLimit, 0.5f * lastStep);
+                stableSteps = 0;
+            }
+
+            lastStep = 0.0f;
+
+            if(finite)
+                continue;
+
+            failedSteps++;
+            break;
+        }
+
+        // Keep the substep when there is nothing better to do
+        for(unsigned int c = 0; c < cloths.size(); c++)
+            monitors[c].accept(*cloths[c]->getState());
+
+        if(stable && stepLimit < FLT_MAX && ++stableSteps >= STABILITY_RECOVERY_STEPS) {
+            stepLimit = stepLimit < STABILITY_FRAME_STEP ? 2.0f * stepLimit : FLT_MAX;
+            stableSteps = 0;
+        }
+
+        integrateVelocities();
+
+        for(unsigned int c = 0; c < cloths.size(); c++)
+            monitors[c].commitSnapshot();
+
+        lastStep = h;
+        remaining -= h;
+        t += h;
+    }
+
+    dt = step;
+    t = time;
+}
+
+
+void Simulation::applySpringForce() {
+
+    ScopedTimer timer(PROFILE_SPRING_FORCE);
+
+    for(std::vector<Cloth *>::iterator it = cloths.begin(); it != cloths.end(); ++it) {
+        (*it)->applySpringForce(dt, acceleration);
+    }
+}
+
+
+void Simulation::integrateVelocities() {
+
+    ScopedTimer timer(PROFILE_INTEGRATE);
+
+    for(std::vector<Cloth *>::iterator it = cloths.begin(); it != cloths.end(); ++it) {
+        (*it)->integrateVelocity(acceleration, dt);
+    }
+
+    pathTime = dt;
+}
+
+
+void Simulation::enforceMaximumStretch() {
+    for(std::vector<Cloth *>::iterator it = cloths.begin(); it != cloths.end(); ++it) {
+        (*it)->enforceMaximumStretch();
+    }
+}
+
+
+void Simulation::applyG() {
+
+    for(std::vector<Cloth *>::iterator it = cloths.begin(); it != cloths.end(); ++it) {
+        (*it)->applyG(acceleration, dt);
+    }
+}
+
+
+/*
+ * Longest step all cloths can take right now, and no longer than the steps that were stable
+ * after the last rollback
+ */
+float Simulation::getMaxStep() {
+
+    float step = stepLimit;
+
+    for(std::vector<Cloth *>::iterator it = cloths.begin(); it != cloths.end(); ++it)
+        step = std::min(step, (*it)->getMaxStep());
+
+    return step;
+}
+
+
+void Simulation::setIntegrator(unsigned int type) {
+
+    integrator = type;
+
+    for(std::vector<Cloth *>::iterator it = cloths.begin(); it != cloths.end(); ++it)
+        (*it)->setIntegrator(type);
+}
+
+
+/*
+ * What the simulation keeps itself. The cloths are reported by whoever owns them
+ */
+void Simulation::reportMemory(MemoryReport &report) {
+
+    report.add("simulation", "cloths", cloths);
+    report.add("simulation", "colliders", colliders);
+    report.add("simulation", "monitors", monitors);
+
+    for(unsigned int c = 0; c < monitors.size(); c++)
+        monitors[c].reportMemory(report);
+
+    for(unsigned int c = 0; c < colliders.size(); c++)
+        colliders[c]->reportMemory(report);
+}
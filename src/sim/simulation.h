@@ -0,0 +1,107 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+// Most times a step is halved to get past an unstable one, the shortest substep is the step
+// divided by 2 to this power
+#define STABILITY_MAX_HALVINGS 4
+
+// Stable steps after a rollback before the step limit is doubled again, once it is longer
+// than a frame it is lifted
+#define STABILITY_RECOVERY_STEPS 600
+#define STABILITY_FRAME_STEP (1.0f / 60.0f)
+
+#include <glm/glm.hpp>
+#include <vector>
+#include "cloth.h"
+#include "collider.h"
+#include "integrator.h"
+#include "stabilitymonitor.h"
+#include "memoryreport.h"
+
+/*
+ * Simulation class
+ *  Steps the cloths and lets them collide with the colliders. This is the whole simulation
+ *  without any drawing, the Scene class draws it and the headless driver runs it without a
+ *  window. The cloths and colliders are owned by whoever added them.
+ *
+ *  Every step is watched by a StabilityMonitor per cloth. The energy of the cloth is measured
+ *  while the forces of the next substep are computed, so a substep that blows up is found
+ *  one substep later. It is rolled back and taken again with half the length, and the step
+ *  limit shrinks. A step is split into substeps no longer than the limit, so callers with a
+ *  fixed dt take the shorter steps from then on too, and getMaxStep() tells the scheduler.
+ *  After a while without trouble the limit is relaxed again. A substep that ends with a
+ *  non-finite energy is never kept, the knots from before it are put back when there are
+ *  any, the rest of the step is dropped and the step counts as failed.
+ */
+
+class Simulation {
+
+public:
+    // Constructors
+    Simulation();
+
+    // Member functions
+    void addCloth(Cloth *);
+    void addCollider(Collider *);
+
+    void reset();
+
+    void step();
+    void checkCollisions();
+    void applySpringForce();
+    void enforceMaximumStretch();
+    void integrateVelocities();
+    void applyG();
+    void reportMemory(MemoryReport &);
+
+    // Getters
+    std::vector<Cloth *> & getCloths() { return cloths; };
+    std::vector<Collider *> & getColliders() { return colliders; };
+    glm::vec3 getAcceleration() { return acceleration; };
+    unsigned int getIntegrator() { return integrator; };
+    const ClothTelemetry & getTelemetry(unsigned int c) { return cloths[c]->getForces()->getTelemetry(); };
+    unsigned int getRollbacks() { return rollbacks; };
+    unsigned int getFailedSteps() { return failedSteps; };
+    float getStepLimit() { return stepLimit; };
+    bool getStabilityControl() { return stabilityControl; };
+    float getDt() { return dt; };
+    float getTime() { return t; };
+    float getMaxStep();
+
+    // Setters
+    void setDt(float _dt) { dt = _dt; };
+    void setTime(float _t) { t = _t; };
+    void setAcceleration(glm::vec3 _a) { acceleration = _a; };
+    void setIntegrator(unsigned int);
+    void setStabilityControl(bool s) { stabilityControl = s; };
+
+private:
+    void collide(bool, float);
+    void takeStep();
+    void takeStableSteps();
+
+    std::vector<Cloth *> cloths;
+    std::vector<Collider *> colliders;
+
+    // Time, delta time and acceleration for our simulation
+    float t;
+    float dt;
+    glm::vec3 acceleration;
+
+    // Integrator used by all cloths, INTEGRATOR_EXPLICIT, INTEGRATOR_RK4, ...
+    unsigned int integrator;
+
+    // Rolling back unstable steps
+    std::vector<StabilityMonitor> monitors;     // One per cloth
+    bool stabilityControl;
+    unsigned int rollbacks;                     // Steps rolled back so far
+    unsigned int failedSteps;                   // Steps that ended with a non-finite energy
+    float lastStep;                             // Length of the substep the knots come from, 0 if it cannot be rolled back
+    float stepLimit;                            // Longest step since the last rollback
+    unsigned int stableSteps;                   // Since the step limit last changed
+
+    // How long the knots have moved since their paths started, the colliders follow theirs as long
+    float pathTime;
+};
+
+#endif // SIMULATION_H
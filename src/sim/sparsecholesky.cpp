@@ -0,0 +1,137 @@
+#include "sparsecholesky.h"
+#include <algorithm>
+#include <cmath>
+
+/*
+ * Starts over with an empty n x n matrix
+ */
+void SparseCholesky::clear(unsigned int size) {
+
+    n = size;
+    entryRow.clear();
+    entryCol.clear();
+    entryValue.clear();
+    first.clear();
+    offset.clear();
+    values.clear();
+}
+
+
+/*
+ * Adds v to entry (i, j) and its mirror (j, i)
+ */
+void SparseCholesky::addEntry(unsigned int i, unsigned int j, float v) {
+
+    entryRow.push_back(std::max(i, j));
+    entryCol.push_back(std::min(i, j));
+    entryValue.push_back(v);
+}
+
+
+/*
+ * Factors the matrix in place. Returns false if it is not positive definite.
+ */
+bool SparseCholesky::factor() {
+
+    // Profile
+    first.resize(n);
+    offset.resize(n + 1);
+
+    for(unsigned int i = 0; i < n; i++)
+        first[i] = i;
+
+    for(unsigned int e = 0; e < entryRow.size(); e++)
+        first[entryRow[e]] = std::min(first[entryRow[e]], entryCol[e]);
+
+    offset[0] = 0;
+    for(unsigned int i = 0; i < n; i++)
+        offset[i + 1] = offset[i] + i - first[i] + 1;
+
+    values.assign(offset[n], 0.0);
+
+    for(unsigned int e = 0; e < entryRow.size(); e++)
+        at(entryRow[e], entryCol[e]) += entryValue[e];
+
+    // Row by row, L(i, j) = (A(i, j) - sum_k L(i, k) L(j, k)) / L(j, j)
+    for(unsigned int i = 0; i < n; i++) {
+        for(unsigned int j = first[i]; j <= i; j++) {
+
+            double sum = at(i, j);
+            unsigned int kBegin = std::max(first[i], first[j]);
+
+            const double *li = values.data() + offset[i] - first[i];
+            const double *lj = values.data() + offset[j] - first[j];
+
+            for(unsigned int k = kBegin; k < j; k++)
+                sum -= li[k] * lj[k];
+
+            if(j < i) {
+                at(i, j) = sum / at(j, j);
+            } else {
+                if(sum <= 0.0)
+                    return false;
+                at(i, i) = std::sqrt(sum);
+            }
+        }
+    }
+
+    work.resize(3 * n);
+
+    return true;
+}
+
+
+/*
+ * x = A^-1 b, with a forward substitution through L and a backward one through L^T
+ */
+void SparseCholesky::solve(const glm::vec3 *b, glm::vec3 *x) {
+
+    double *y = &work[0];
+
+    for(unsigned int i = 0; i < n; i++) {
+
+        double sx = b[i].x;
+        double sy = b[i].y;
+        double sz = b[i].z;
+
+        const double *li = values.data() + offset[i] - first[i];
+
+        for(unsigned int k = first[i]; k < i; k++) {
+            sx -= li[k] * y[3*k];
+            sy -= li[k] * y[3*k + 1];
+            sz -= li[k] * y[3*k + 2];
+        }
+
+        y[3*i] = sx / li[i];
+        y[3*i + 1] = sy / li[i];
+        y[3*i + 2] = sz / li[i];
+    }
+
+    for(unsigned int i = n; i-- > 0; ) {
+
+        const double *li = values.data() + offset[i] - first[i];
+
+        y[3*i] /= li[i];
+        y[3*i + 1] /= li[i];
+        y[3*i + 2] /= li[i];
+
+        for(unsigned int k = first[i]; k < i; k++) {
+            y[3*k] -= li[k] * y[3*i];
+            y[3*k + 1] -= li[k] * y[3*i + 1];
+            y[3*k + 2] -= li[k] * y[3*i + 2];
+        }
+
+        x[i] = glm::vec3(y[3*i], y[3*i + 1], y[3*i + 2]);
+    }
+}
+
+
+void SparseCholesky::reportMemory(MemoryReport &report) {
+    report.add("cholesky factor", "entryRow", entryRow);
+    report.add("cholesky factor", "entryCol", entryCol);
+    report.add("cholesky factor", "entryValue", entryValue);
+    report.add("cholesky factor", "first", first);
+    report.add("cholesky factor", "offset", offset);
+    report.add("cholesky factor", "values", values);
+    report.add("cholesky factor", "work", work);
+}
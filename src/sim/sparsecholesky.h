@@ -0,0 +1,54 @@
+#ifndef SPARSECHOLESKY_H
+#define SPARSECHOLESKY_H
+
+#include <glm/glm.hpp>
+#include <vector>
+#include "memoryreport.h"
+
+/*
+ * SparseCholesky class
+ *  Cholesky factorization L L^T of a sparse symmetric positive definite matrix, stored as a
+ *  profile (skyline): row i keeps the columns from its first nonzero up to the diagonal.
+ *  Fill-in only happens inside the profile, so for a cloth grid numbered row by row the
+ *  factor takes about two grid rows per knot.
+ *
+ *  The matrix is given as entries of the lower triangle, duplicates are summed. Solves take
+ *  three right hand sides at once as a glm::vec3 per row.
+ */
+
+class SparseCholesky {
+
+public:
+    // Constructors
+    SparseCholesky() : n(0) {};
+
+    // Member functions
+    void clear(unsigned int);
+    void addEntry(unsigned int, unsigned int, float);
+    bool factor();
+    void solve(const glm::vec3 *b, glm::vec3 *x);
+    void reportMemory(MemoryReport &);
+
+    // Getters
+    unsigned int size() { return n; };
+    unsigned int getNumNonZeros() { return values.size(); };
+
+private:
+    double & at(unsigned int i, unsigned int j) { return values[offset[i] + j - first[i]]; };
+
+    unsigned int n;
+
+    // Entries given before the factorization
+    std::vector<unsigned int> entryRow;
+    std::vector<unsigned int> entryCol;
+    std::vector<float> entryValue;
+
+    // Profile of the factor, row i holds columns [first[i], i] from values[offset[i]]
+    std::vector<unsigned int> first;
+    std::vector<unsigned int> offset;
+    std::vector<double> values;
+
+    std::vector<double> work;
+};
+
+#endif // SPARSECHOLESKY_H
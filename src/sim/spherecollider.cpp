@@ -0,0 +1,195 @@
+#include "spherecollider.h"
+#include <algorithm>
+#include <cmath>
+
+SphereCollider::SphereCollider(float r, glm::vec3 p, glm::vec3 v)
+    : radius(r), position(p), initialPosition(p), previousPosition(p), olderPosition(p), stepLength(0.0f),
+      previousStepLength(0.0f), pathStart(p), center(p), pathVelocity(0.0f, 0.0f, 0.0f), velocity(v), continuous(true) {
+
+}
+
+
+void SphereCollider::reset() {
+    setPosition(initialPosition);
+    velocity = glm::vec3(0.0f, 0.0f, 0.0f);
+}
+
+
+/*
+ * Puts the sphere at p at once, it has no path to get there
+ */
+void SphereCollider::setPosition(glm::vec3 p) {
+    position = p;
+    previousPosition = p;
+    olderPosition = p;
+    pathStart = p;
+    center = p;
+    pathVelocity = glm::vec3(0.0f, 0.0f, 0.0f);
+}
+
+
+/*
+ * The sphere moves from where it is to p over the next step
+ */
+void SphereCollider::moveTo(glm::vec3 p) {
+    position = p;
+}
+
+
+void SphereCollider::beginCollisions(float dt) {
+    stepLength = dt;
+}
+
+
+/*
+ * Where the sphere is the time into the step. Before the step it is on its path of the step
+ * before, and it stays at the ends of the two paths
+ */
+glm::vec3 SphereCollider::getPathPosition(float time) {
+
+    if(time >= 0.0f) {
+        float s = stepLength > 0.0f ? std::min(time / stepLength, 1.0f) : 1.0f;
+        return previousPosition + s * (position - previousPosition);
+    }
+
+    float s = previousStepLength > 0.0f ? std::max(1.0f + time / previousStepLength, 0.0f) : 0.0f;
+    return olderPosition + s * (previousPosition - olderPosition);
+}
+
+
+/*
+ * The knots moved for h until the time into the step, the sphere follows its path over the
+ * same time. Its velocity is what it moved over the substep, not over the whole step
+ */
+void SphereCollider::beginSubstep(float time, float h) {
+
+    center = getPathPosition(time);
+
+    if(h > 0.0f) {
+        pathStart = getPathPosition(time - h);
+        pathVelocity = (center - pathStart) / h;
+    } else {
+        pathStart = center;
+        pathVelocity = glm::vec3(0.0f, 0.0f, 0.0f);
+    }
+}
+
+
+void SphereCollider::endCollisions() {
+    olderPosition = previousPosition;
+    previousPosition = position;
+    previousStepLength = stepLength;
+}
+
+
+void SphereCollider::resolveCollision(ClothState &s, unsigned int i) {
+    resolveCollisions(s, i, i + 1);
+}
+
+
+/*
+ * Resolves knots [begin, end). Without continuous collisions the loop has selects instead
+ * of a branch so it can be vectorized, a knot outside is moved by zero and its velocity
+ * scaled by one
+ */
+void SphereCollider::resolveCollisions(ClothState &s, unsigned int begin, unsigned int end) {
+
+    if(continuous) {
+        resolveContinuous(s, begin, end);
+        return;
+    }
+
+    glm::vec3 *x = &s.position[0];
+    glm::vec3 *v = &s.velocity[0];
+    const glm::vec3 middle = center;
+    const float r = radius;
+
+    for(unsigned int i = begin; i < end; i++) {
+
+        glm::vec3 d = x[i] - middle;
+        float dist = glm::length(d);
+        bool inside = dist < r;
+
+        float push = inside ? 2.0f * (r - dist) : 0.0f;
+        float slow = inside ? 0.8f : 1.0f;
+
+        // Outside the sphere dist > 0, so the normal is finite
+        x[i] += push * glm::normalize(d);
+        v[i] *= slow;
+    }
+}
+
+
+/*
+ * Sweeps knots [begin, end) against the sphere. Relative to the sphere a knot moves from d0
+ * to d0 + e, and it hits the surface at the first t in [0, 1] where |d0 + t e| = r. A knot
+ * that starts inside, left on the surface by the substep before or pushed in by another
+ * collider, hits it where it starts
+ */
+void SphereCollider::resolveContinuous(ClothState &s, unsigned int begin, unsigned int end) {
+
+    glm::vec3 *x = &s.position[0];
+    glm::vec3 *v = &s.velocity[0];
+    const glm::vec3 *previous = &s.previousPosition[0];
+    const glm::vec3 middle = center;
+    const glm::vec3 start = pathStart;
+    const glm::vec3 u = pathVelocity;
+    const float r = radius;
+
+    for(unsigned int i = begin; i < end; i++) {
+
+        glm::vec3 d = x[i] - middle;
+        glm::vec3 d0 = previous[i] - start;
+        glm::vec3 e = d - d0;
+
+        float b = glm::dot(d0, e);
+        float c = glm::dot(d0, d0) - r * r;
+
+        glm::vec3 normal;
+        bool hit = false;
+
+        // Moved towards the middle, from outside or from inside but not from the middle itself
+        if(b < 0.0f && c > 0.0f) {
+
+            float a = glm::dot(e, e);
+            float discriminant = b * b - a * c;
+
+            if(discriminant >= 0.0f && -b - std::sqrt(discriminant) <= a) {
+                float t = (-b - std::sqrt(discriminant)) / a;
+                normal = (d0 + t * e) / r;
+                hit = true;
+            }
+        } else if(b < 0.0f && c > -r * r) {
+            normal = d0 / std::sqrt(c + r * r);
+            hit = true;
+        }
+
+        // Through the sphere, or past the middle of it
+        if(hit && ((c > 0.0f && glm::dot(d, d) >= r * r) || glm::dot(d, normal) < 0.0f)) {
+
+            x[i] = middle + r * normal;
+
+            // A knot hit by the sphere is pushed along with it
+            glm::vec3 relative = v[i] - u;
+            float approach = std::min(glm::dot(relative, normal), 0.0f);
+            v[i] = 0.8f * (relative - approach * normal) + u;
+            continue;
+        }
+
+        float dist = glm::length(d);
+
+        if(dist < r) {
+            x[i] += (2.0f * (r - dist)) * glm::normalize(d);
+            v[i] *= 0.8f;
+        }
+    }
+}
+
+
+/*
+ * Around its path over the substep, so the knots that meet it on the way are not skipped
+ */
+void SphereCollider::getBounds(glm::vec3 &lower, glm::vec3 &upper) {
+    lower = glm::min(center, pathStart) - glm::vec3(radius);
+    upper = glm::max(center, pathStart) + glm::vec3(radius);
+}
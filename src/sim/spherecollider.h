@@ -0,0 +1,69 @@
+#ifndef SPHERECOLLIDER_H
+#define SPHERECOLLIDER_H
+
+#include "collider.h"
+
+/*
+ * SphereCollider class
+ *  A solid sphere, knots inside it are pushed out along the normal and slowed down.
+ *
+ *  moveTo sets where the sphere is at the end of the next step, and it moves there in a
+ *  straight line over the step. Collisions are continuous, every substep the sphere moves
+ *  along its path for as long as the knots moved along theirs, so a knot and a sphere that
+ *  pass through each other within a substep still collide however fast either of them moves.
+ *  A knot that hits the sphere on its way and ends up past the middle of it, or through it,
+ *  is put back on the surface where it hit and loses the velocity it had into the sphere,
+ *  relative to the sphere, so a moving sphere carries the knots it hits along with the
+ *  velocity it had over that substep. A knot that starts inside, pushed in by another
+ *  collider, hits the sphere where it starts. Knots that end up inside less deep are pushed
+ *  out as with the discrete test, along the normal where they are.
+ *
+ *  setPosition puts the sphere somewhere at once, like a key press does. It is not a motion,
+ *  the knots it lands on are pushed out as with the discrete test and get no velocity from it.
+ */
+
+class SphereCollider : public Collider {
+
+public:
+    // Constructors
+    SphereCollider(float, glm::vec3, glm::vec3 v = glm::vec3(0.0f, 0.0f, 0.0f));
+
+    // Member functions
+    void resolveCollision(ClothState &, unsigned int);
+    void resolveCollisions(ClothState &, unsigned int, unsigned int);
+    void reset();
+    void moveTo(glm::vec3);
+    void beginCollisions(float);
+    void beginSubstep(float, float);
+    void endCollisions();
+    void getBounds(glm::vec3 &, glm::vec3 &);
+
+    // Getters
+    float getRadius() { return radius; };
+    glm::vec3 getPosition() { return position; };
+    bool isContinuous() { return continuous; };
+
+    // Setters
+    void setPosition(glm::vec3);
+    void setVelocity(glm::vec3 v) { velocity = v; };
+    void setContinuous(bool c) { continuous = c; };
+
+private:
+    void resolveContinuous(ClothState &, unsigned int, unsigned int);
+    glm::vec3 getPathPosition(float);
+
+    float radius;
+    glm::vec3 position;             // At the end of the step
+    glm::vec3 initialPosition;
+    glm::vec3 previousPosition;     // At the start of the step
+    glm::vec3 olderPosition;        // At the start of the step before
+    float stepLength;
+    float previousStepLength;
+    glm::vec3 pathStart;            // Where the paths of the knots start
+    glm::vec3 center;               // Where they end, at the substep being resolved
+    glm::vec3 pathVelocity;         // From the path start to the center
+    glm::vec3 velocity;
+    bool continuous;                // Follows the paths, or only tests where the knots are
+};
+
+#endif // SPHERECOLLIDER_H
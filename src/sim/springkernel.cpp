@@ -0,0 +1,289 @@
+#include "springkernel.h"
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <iostream>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SPRING_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+
+#ifdef SPRING_KERNEL_X86
+
+/*
+ * Adds the forces computed for a batch of springs to the knots, in spring order so the
+ *  result matches the scalar kernel even when springs in the batch share knots.
+ */
+static inline void scatterSpringForces(const unsigned int *first, const unsigned int *second, unsigned int count,
+                                       const float *fx, const float *fy, const float *fz, glm::vec3 *f) {
+
+    for(unsigned int n = 0; n < count; n++) {
+        glm::vec3 force(fx[n], fy[n], fz[n]);
+        f[first[n]] += force;
+        f[second[n]] -= force;
+    }
+}
+
+
+/*
+ * Adds the four lanes of energy and the largest of the four strains to the stretch
+ */
+__attribute__((target("sse2")))
+static inline void addSpringStretch(__m128 energy, __m128 maxStrain, SpringStretch *stretch) {
+
+    float e[4], strain[4];
+    _mm_storeu_ps(e, energy);
+    _mm_storeu_ps(strain, maxStrain);
+
+    stretch->energy += (e[0] + e[1]) + (e[2] + e[3]);
+    stretch->maxStrain = std::max(stretch->maxStrain, std::max(std::max(strain[0], strain[1]), std::max(strain[2], strain[3])));
+}
+
+
+__attribute__((target("sse2")))
+static void accumulateSpringForcesSSE(const SpringSet &springs, unsigned int begin, unsigned int end,
+                                      const glm::vec3 *x, const glm::vec3 *v, glm::vec3 *f,
+                                      SpringStretch *stretch) {
+
+    const unsigned int *first = springs.first.empty() ? NULL : &springs.first[0];
+    const unsigned int *second = springs.second.empty() ? NULL : &springs.second[0];
+
+    float fx[4], fy[4], fz[4];
+    unsigned int s = begin;
+
+    __m128 energy = _mm_setzero_ps();
+    __m128 maxStrain = _mm_setzero_ps();
+
+    for(; s + 4 <= end; s += 4) {
+
+        const unsigned int *i = first + s;
+        const unsigned int *j = second + s;
+
+        __m128 dpx = _mm_sub_ps(_mm_setr_ps(x[i[0]].x, x[i[1]].x, x[i[2]].x, x[i[3]].x),
+                                _mm_setr_ps(x[j[0]].x, x[j[1]].x, x[j[2]].x, x[j[3]].x));
+        __m128 dpy = _mm_sub_ps(_mm_setr_ps(x[i[0]].y, x[i[1]].y, x[i[2]].y, x[i[3]].y),
+                                _mm_setr_ps(x[j[0]].y, x[j[1]].y, x[j[2]].y, x[j[3]].y));
+        __m128 dpz = _mm_sub_ps(_mm_setr_ps(x[i[0]].z, x[i[1]].z, x[i[2]].z, x[i[3]].z),
+                                _mm_setr_ps(x[j[0]].z, x[j[1]].z, x[j[2]].z, x[j[3]].z));
+        __m128 dvx = _mm_sub_ps(_mm_setr_ps(v[i[0]].x, v[i[1]].x, v[i[2]].x, v[i[3]].x),
+                                _mm_setr_ps(v[j[0]].x, v[j[1]].x, v[j[2]].x, v[j[3]].x));
+        __m128 dvy = _mm_sub_ps(_mm_setr_ps(v[i[0]].y, v[i[1]].y, v[i[2]].y, v[i[3]].y),
+                                _mm_setr_ps(v[j[0]].y, v[j[1]].y, v[j[2]].y, v[j[3]].y));
+        __m128 dvz = _mm_sub_ps(_mm_setr_ps(v[i[0]].z, v[i[1]].z, v[i[2]].z, v[i[3]].z),
+                                _mm_setr_ps(v[j[0]].z, v[j[1]].z, v[j[2]].z, v[j[3]].z));
+
+        __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dpx, dpx), _mm_mul_ps(dpy, dpy)), _mm_mul_ps(dpz, dpz));
+        __m128 len = _mm_sqrt_ps(len2);
+        __m128 inv_len = _mm_div_ps(_mm_set1_ps(1.0f), len);
+
+        __m128 elongation = _mm_sub_ps(len, _mm_loadu_ps(&springs.restLength[s]));
+        __m128 dvdp = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dvx, dpx), _mm_mul_ps(dvy, dpy)), _mm_mul_ps(dvz, dpz));
+
+        __m128 k = _mm_loadu_ps(&springs.stiffness[s]);
+        __m128 b = _mm_loadu_ps(&springs.damping[s]);
+        __m128 neg_k = _mm_sub_ps(_mm_setzero_ps(), k);
+        __m128 magnitude = _mm_sub_ps(_mm_mul_ps(neg_k, elongation), _mm_mul_ps(b, dvdp));
+
+        _mm_storeu_ps(fx, _mm_mul_ps(magnitude, _mm_mul_ps(dpx, inv_len)));
+        _mm_storeu_ps(fy, _mm_mul_ps(magnitude, _mm_mul_ps(dpy, inv_len)));
+        _mm_storeu_ps(fz, _mm_mul_ps(magnitude, _mm_mul_ps(dpz, inv_len)));
+
+        scatterSpringForces(i, j, 4, fx, fy, fz, f);
+
+        energy = _mm_add_ps(energy, _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), k), _mm_mul_ps(elongation, elongation)));
+        maxStrain = _mm_max_ps(maxStrain, _mm_div_ps(elongation, _mm_loadu_ps(&springs.restLength[s])));
+    }
+
+    if(stretch != NULL)
+        addSpringStretch(energy, maxStrain, stretch);
+
+    // Springs that did not fill a whole batch
+    accumulateSpringForces(springs, s, end, x, v, f, stretch);
+}
+
+
+__attribute__((target("avx2")))
+static void accumulateSpringForcesAVX2(const SpringSet &springs, unsigned int begin, unsigned int end,
+                                       const glm::vec3 *x, const glm::vec3 *v, glm::vec3 *f,
+                                       SpringStretch *stretch) {
+
+    // glm::vec3 is three tightly packed floats, so component c of knot i is at [3 * i + c]
+    const float *xf = &x[0].x;
+    const float *vf = &v[0].x;
+    const unsigned int *first = springs.first.empty() ? NULL : &springs.first[0];
+    const unsigned int *second = springs.second.empty() ? NULL : &springs.second[0];
+
+    float fx[8], fy[8], fz[8];
+    unsigned int s = begin;
+
+    __m256 energy = _mm256_setzero_ps();
+    __m256 maxStrain = _mm256_setzero_ps();
+
+    for(; s + 8 <= end; s += 8) {
+
+        __m256i i = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(first + s));
+        __m256i j = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(second + s));
+        __m256i i3 = _mm256_add_epi32(i, _mm256_add_epi32(i, i));
+        __m256i j3 = _mm256_add_epi32(j, _mm256_add_epi32(j, j));
+
+        __m256 dpx = _mm256_sub_ps(_mm256_i32gather_ps(xf, i3, 4), _mm256_i32gather_ps(xf, j3, 4));
+        __m256 dpy = _mm256_sub_ps(_mm256_i32gather_ps(xf + 1, i3, 4), _mm256_i32gather_ps(xf + 1, j3, 4));
+        __m256 dpz = _mm256_sub_ps(_mm256_i32gather_ps(xf + 2, i3, 4), _mm256_i32gather_ps(xf + 2, j3, 4));
+        __m256 dvx = _mm256_sub_ps(_mm256_i32gather_ps(vf, i3, 4), _mm256_i32gather_ps(vf, j3, 4));
+        __m256 dvy = _mm256_sub_ps(_mm256_i32gather_ps(vf + 1, i3, 4), _mm256_i32gather_ps(vf + 1, j3, 4));
+        __m256 dvz = _mm256_sub_ps(_mm256_i32gather_ps(vf + 2, i3, 4), _mm256_i32gather_ps(vf + 2, j3, 4));
+
+        __m256 len2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dpx, dpx), _mm256_mul_ps(dpy, dpy)), _mm256_mul_ps(dpz, dpz));
+        __m256 len = _mm256_sqrt_ps(len2);
+        __m256 inv_len = _mm256_div_ps(_mm256_set1_ps(1.0f), len);
+
+        __m256 elongation = _mm256_sub_ps(len, _mm256_loadu_ps(&springs.restLength[s]));
+        __m256 dvdp = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dvx, dpx), _mm256_mul_ps(dvy, dpy)), _mm256_mul_ps(dvz, dpz));
+
+        __m256 k = _mm256_loadu_ps(&springs.stiffness[s]);
+        __m256 b = _mm256_loadu_ps(&springs.damping[s]);
+        __m256 neg_k = _mm256_sub_ps(_mm256_setzero_ps(), k);
+        __m256 magnitude = _mm256_sub_ps(_mm256_mul_ps(neg_k, elongation), _mm256_mul_ps(b, dvdp));
+
+        _mm256_storeu_ps(fx, _mm256_mul_ps(magnitude, _mm256_mul_ps(dpx, inv_len)));
+        _mm256_storeu_ps(fy, _mm256_mul_ps(magnitude, _mm256_mul_ps(dpy, inv_len)));
+        _mm256_storeu_ps(fz, _mm256_mul_ps(magnitude, _mm256_mul_ps(dpz, inv_len)));
+
+        scatterSpringForces(first + s, second + s, 8, fx, fy, fz, f);
+
+        energy = _mm256_add_ps(energy, _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), k), _mm256_mul_ps(elongation, elongation)));
+        maxStrain = _mm256_max_ps(maxStrain, _mm256_div_ps(elongation, _mm256_loadu_ps(&springs.restLength[s])));
+    }
+
+    if(stretch != NULL)
+        addSpringStretch(_mm_add_ps(_mm256_castps256_ps128(energy), _mm256_extractf128_ps(energy, 1)),
+                         _mm_max_ps(_mm256_castps256_ps128(maxStrain), _mm256_extractf128_ps(maxStrain, 1)), stretch);
+
+    // Springs that did not fill a whole batch
+    accumulateSpringForces(springs, s, end, x, v, f, stretch);
+}
+
+#endif // SPRING_KERNEL_X86
+
+
+bool isSpringKernelSupported(unsigned int kernel) {
+
+    switch(kernel) {
+    case SPRING_KERNEL_SCALAR:
+        return true;
+#ifdef SPRING_KERNEL_X86
+    case SPRING_KERNEL_SSE:
+        return __builtin_cpu_supports("sse2");
+    case SPRING_KERNEL_AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+
+unsigned int detectSpringKernel() {
+
+    for(unsigned int kernel = NUM_SPRING_KERNELS; kernel > 0; kernel--) {
+        if(isSpringKernelSupported(kernel - 1))
+            return kernel - 1;
+    }
+
+    return SPRING_KERNEL_SCALAR;
+}
+
+
+SpringKernel getSpringKernel(unsigned int kernel) {
+
+    switch(kernel) {
+#ifdef SPRING_KERNEL_X86
+    case SPRING_KERNEL_SSE:
+        return accumulateSpringForcesSSE;
+    case SPRING_KERNEL_AVX2:
+        return accumulateSpringForcesAVX2;
+#endif
+    default:
+        return accumulateSpringForces;
+    }
+}
+
+
+const char * getSpringKernelName(unsigned int kernel) {
+
+    switch(kernel) {
+    case SPRING_KERNEL_SSE:
+        return "sse";
+    case SPRING_KERNEL_AVX2:
+        return "avx2";
+    default:
+        return "scalar";
+    }
+}
+
+
+float compareSpringKernel(unsigned int kernel, const SpringSet &springs, const glm::vec3 *x, const glm::vec3 *v, unsigned int n) {
+
+    if(n == 0 || springs.size() == 0)
+        return 0.0f;
+
+    // Disturb the cloth a bit so both the spring and the damping terms are non-zero
+    std::vector<glm::vec3> x_test(x, x + n);
+    std::vector<glm::vec3> v_test(v, v + n);
+    unsigned int seed = 12345;
+
+    for(unsigned int i = 0; i < n; i++) {
+        for(unsigned int c = 0; c < 3; c++) {
+            seed = seed * 1664525u + 1013904223u;
+            float r = static_cast<float>(seed >> 8) / static_cast<float>(1 << 24) - 0.5f;
+            x_test[i][c] += 0.05f * r;
+            v_test[i][c] += r;
+        }
+    }
+
+    std::vector<glm::vec3> f_reference(n, glm::vec3(0.0f));
+    std::vector<glm::vec3> f_kernel(n, glm::vec3(0.0f));
+
+    accumulateSpringForces(springs, 0, springs.size(), &x_test[0], &v_test[0], &f_reference[0]);
+    getSpringKernel(kernel)(springs, 0, springs.size(), &x_test[0], &v_test[0], &f_kernel[0], NULL);
+
+    float max_force = 0.0f;
+    float max_difference = 0.0f;
+
+    for(unsigned int i = 0; i < n; i++) {
+        for(unsigned int c = 0; c < 3; c++) {
+            max_force = std::max(max_force, std::fabs(f_reference[i][c]));
+            float difference = std::fabs(f_reference[i][c] - f_kernel[i][c]);
+
+            // A NaN in only one of the results is always a mismatch
+            if(difference != difference && f_reference[i][c] == f_reference[i][c])
+                return INFINITY;
+
+            max_difference = std::max(max_difference, difference);
+        }
+    }
+
+    return (max_force > 0.0f) ? max_difference / max_force : max_difference;
+}
+
+
+unsigned int selectSpringKernel(const SpringSet &springs, const glm::vec3 *x, const glm::vec3 *v, unsigned int n) {
+
+    for(unsigned int kernel = detectSpringKernel(); kernel > SPRING_KERNEL_SCALAR; kernel--) {
+
+        if(!isSpringKernelSupported(kernel))
+            continue;
+
+        float error = compareSpringKernel(kernel, springs, x, v, n);
+
+        if(error <= SPRING_KERNEL_TOLERANCE)
+            return kernel;
+
+        std::cout << "Spring kernel " << getSpringKernelName(kernel) << " differs from scalar kernel by "
+                  << error << ", not using it" << std::endl;
+    }
+
+    return SPRING_KERNEL_SCALAR;
+}
@@ -0,0 +1,37 @@
+#ifndef SPRINGKERNEL_H
+#define SPRINGKERNEL_H
+
+#define SPRING_KERNEL_SCALAR 0
+#define SPRING_KERNEL_SSE 1
+#define SPRING_KERNEL_AVX2 2
+#define NUM_SPRING_KERNELS 3
+
+// Allowed difference to the scalar kernel, relative to the largest force
+#define SPRING_KERNEL_TOLERANCE 1e-5f
+
+#include <glm/glm.hpp>
+#include "springs.h"
+
+/*
+ * Vectorized variants of accumulateSpringForces.
+ *  The SSE kernel handles 4 springs and the AVX2 kernel 8 springs per iteration, both
+ *  read the SoA spring data and gather knot positions and velocities by index. Forces are
+ *  scattered back in the same order as the scalar kernel, and the stretch is summed per lane
+ *  and added once at the end. The variant is picked at runtime from what the CPU supports.
+ */
+
+typedef void (*SpringKernel)(const SpringSet &, unsigned int, unsigned int,
+                             const glm::vec3 *, const glm::vec3 *, glm::vec3 *, SpringStretch *);
+
+bool isSpringKernelSupported(unsigned int);
+unsigned int detectSpringKernel();
+SpringKernel getSpringKernel(unsigned int);
+const char * getSpringKernelName(unsigned int);
+
+// Largest difference between a kernel and the scalar kernel, relative to the largest force
+float compareSpringKernel(unsigned int, const SpringSet &, const glm::vec3 *x, const glm::vec3 *v, unsigned int n);
+
+// Best supported kernel that agrees with the scalar kernel on the given springs
+unsigned int selectSpringKernel(const SpringSet &, const glm::vec3 *x, const glm::vec3 *v, unsigned int n);
+
+#endif // SPRINGKERNEL_H
@@ -0,0 +1,146 @@
+#include "springs.h"
+#include <algorithm>
+
+unsigned int SpringSet::addSpring(unsigned int i, unsigned int j, float l, float k, float b, unsigned char t) {
+
+    first.push_back(i);
+    second.push_back(j);
+    restLength.push_back(l);
+    stiffness.push_back(k);
+    damping.push_back(b);
+    type.push_back(t);
+
+    return first.size() - 1;
+}
+
+
+void SpringSet::reserve(unsigned int n) {
+    first.reserve(n);
+    second.reserve(n);
+    restLength.reserve(n);
+    stiffness.reserve(n);
+    damping.reserve(n);
+    type.reserve(n);
+}
+
+
+void SpringSet::clear() {
+    first.clear();
+    second.clear();
+    restLength.clear();
+    stiffness.clear();
+    damping.clear();
+    type.clear();
+    colorOffsets.clear();
+}
+
+
+/*
+ * Greedy edge colouring. Every spring gets the lowest colour that no other spring on either
+ *  of its knots has, and the springs are then reordered by colour. Springs keep their
+ *  relative order within a colour, so memory is still walked mostly front to back.
+ */
+void SpringSet::colorSprings(unsigned int numKnots) {
+
+    const unsigned int n = size();
+
+    // Colours already used on each knot, a cloth knot has at most 12 springs so 64 is plenty
+    std::vector<unsigned long long> used(numKnots, 0ull);
+    std::vector<unsigned int> color(n, 0);
+    unsigned int numColors = 0;
+
+    for(unsigned int s = 0; s < n; s++) {
+
+        unsigned long long taken = used[first[s]] | used[second[s]];
+        unsigned int c = 0;
+
+        while(c < 63 && (taken & (1ull << c)))
+            c++;
+
+        color[s] = c;
+        used[first[s]] |= 1ull << c;
+        used[second[s]] |= 1ull << c;
+        numColors = std::max(numColors, c + 1);
+    }
+
+    // Counting sort by colour
+    colorOffsets.assign(numColors + 1, 0);
+
+    for(unsigned int s = 0; s < n; s++)
+        colorOffsets[color[s] + 1]++;
+
+    for(unsigned int c = 0; c < numColors; c++)
+        colorOffsets[c + 1] += colorOffsets[c];
+
+    std::vector<unsigned int> order(n);
+    std::vector<unsigned int> fill(colorOffsets.begin(), colorOffsets.end() - 1);
+
+    for(unsigned int s = 0; s < n; s++)
+        order[fill[color[s]]++] = s;
+
+    SpringSet sorted;
+    sorted.reserve(n);
+
+    for(unsigned int s = 0; s < n; s++) {
+        unsigned int o = order[s];
+        sorted.addSpring(first[o], second[o], restLength[o], stiffness[o], damping[o], type[o]);
+    }
+
+    first.swap(sorted.first);
+    second.swap(sorted.second);
+    restLength.swap(sorted.restLength);
+    stiffness.swap(sorted.stiffness);
+    damping.swap(sorted.damping);
+    type.swap(sorted.type);
+}
+
+
+void accumulateSpringForces(const SpringSet &springs, unsigned int begin, unsigned int end,
+                            const glm::vec3 *x, const glm::vec3 *v, glm::vec3 *f,
+                            SpringStretch *stretch) {
+
+    glm::vec3 delta_p;
+    glm::vec3 delta_p_hat;
+    glm::vec3 delta_v;
+    glm::vec3 force;
+    float spring_elongation;
+
+    float energy = 0.0f;
+    float maxStrain = 0.0f;
+
+    for(unsigned int s = begin; s < end; s++) {
+
+        unsigned int i = springs.first[s];
+        unsigned int j = springs.second[s];
+
+        delta_v = v[i] - v[j];
+        delta_p = x[i] - x[j];
+        delta_p_hat = glm::normalize(delta_p);
+
+        spring_elongation = glm::length(delta_p) - springs.restLength[s];
+
+        force = (-springs.stiffness[s] * spring_elongation - springs.damping[s] * glm::dot(delta_v, delta_p)) * delta_p_hat;
+
+        f[i] += force;
+        f[j] -= force;
+
+        energy += 0.5f * springs.stiffness[s] * spring_elongation * spring_elongation;
+        maxStrain = std::max(maxStrain, spring_elongation / springs.restLength[s]);
+    }
+
+    if(stretch != NULL) {
+        stretch->energy += energy;
+        stretch->maxStrain = std::max(stretch->maxStrain, maxStrain);
+    }
+}
+
+
+void SpringSet::reportMemory(MemoryReport &report) {
+    report.add("springs", "first", first);
+    report.add("springs", "second", second);
+    report.add("springs", "restLength", restLength);
+    report.add("springs", "stiffness", stiffness);
+    report.add("springs", "damping", damping);
+    report.add("springs", "type", type);
+    report.add("springs", "colorOffsets", colorOffsets);
+}
@@ -0,0 +1,67 @@
+#ifndef SPRINGS_H
+#define SPRINGS_H
+
+#define SPRING_STRUCTURAL 0
+#define SPRING_SHEAR 1
+#define SPRING_BEND 2
+
+#include <glm/glm.hpp>
+#include <vector>
+#include "memoryreport.h"
+
+/*
+ * SpringSet class
+ *  A flat, deduplicated list of springs between knots. Every spring is stored exactly once
+ *  with its two knot indices, rest length, stiffness and damping, one array per attribute.
+ *
+ *  After colorSprings() the springs are grouped into colours where no two springs in the
+ *  same colour share a knot. Colour c is the range [colorOffsets[c], colorOffsets[c + 1]),
+ *  so each colour can be evaluated in parallel without any locking.
+ */
+
+class SpringSet {
+
+public:
+    // Member functions
+    unsigned int addSpring(unsigned int, unsigned int, float, float, float, unsigned char);
+    void reserve(unsigned int);
+    void clear();
+    void colorSprings(unsigned int);
+    void reportMemory(MemoryReport &);
+
+    // Getters
+    unsigned int size() const { return first.size(); };
+    unsigned int getNumColors() const { return colorOffsets.empty() ? 0 : colorOffsets.size() - 1; };
+
+    // Per spring data, all arrays have the same length
+    std::vector<unsigned int> first;
+    std::vector<unsigned int> second;
+    std::vector<float> restLength;
+    std::vector<float> stiffness;
+    std::vector<float> damping;
+    std::vector<unsigned char> type;
+
+    // Start of every colour, plus one past the last spring
+    std::vector<unsigned int> colorOffsets;
+};
+
+
+/*
+ * How far a range of springs is stretched, measured by a spring kernel on the way
+ */
+struct SpringStretch {
+    float energy;       // Sum of k e^2 / 2 over the springs, stretched by e
+    float maxStrain;    // Largest e / rest length
+};
+
+
+/*
+ * Evaluates the damped spring forces of springs [begin, end) once each and adds the force
+ *  to the first knot and the opposite force to the second knot. Unless stretch is NULL the
+ *  energy and largest strain of the springs are added to it.
+ */
+void accumulateSpringForces(const SpringSet &, unsigned int begin, unsigned int end,
+                            const glm::vec3 *x, const glm::vec3 *v, glm::vec3 *f,
+                            SpringStretch *stretch = NULL);
+
+#endif // SPRINGS_H
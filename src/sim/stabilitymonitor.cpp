@@ -0,0 +1,176 @@
+#include "stabilitymonitor.h"
+#include <algorithm>
+#include <cmath>
+
+StabilityMonitor::StabilityMonitor()
+    : hasGood(false), goodVersion(0), gravityEnergy(0.0), current(0) {
+
+    reset();
+}
+
+
+/*
+ * If there is no stable step to compare the next one with, the cloth is new or was reset
+ */
+bool StabilityMonitor::needsReference(const ClothState &state) {
+    return !hasGood || state.getResetVersion() != goodVersion;
+}
+
+
+/*
+ * The telemetry of the cloth at the acceleration G. The spacing is how far apart the knots are
+ */
+void StabilityMonitor::measure(const ClothTelemetry &t, const glm::vec3 G, float spacing) {
+    telemetry = t;
+    gravityEnergy = t.freeMass * glm::length(G) * spacing;
+}
+
+
+bool StabilityMonitor::isStable() {
+
+    if(!isFinite())
+        return false;
+
+    if(!hasGood)
+        return true;
+
+    if(telemetry.maxStrain > STABILITY_MAX_STRAIN && telemetry.maxStrain > good.maxStrain)
+        return false;
+
+    // Constraint solvers are judged by the strain alone
+    if(!telemetry.springEnergy || !good.springEnergy)
+        return true;
+
+    double energy = telemetry.kineticEnergy + telemetry.elasticEnergy;
+    return energy <= STABILITY_ENERGY_GROWTH * (good.kineticEnergy + good.elasticEnergy) + gravityEnergy;
+}
+
+
+bool StabilityMonitor::isFinite() {
+
+    // NaN fails every comparison, so this is written to fail for it
+    return telemetry.kineticEnergy + telemetry.elasticEnergy < HUGE_VAL;
+}
+
+
+/*
+ * The last measured knots are the new reference for the next step
+ */
+void StabilityMonitor::accept(const ClothState &state) {
+    good = telemetry;
+    goodVersion = state.getResetVersion();
+    hasGood = true;
+}
+
+
+/*
+ * Forget the reference and the snapshots, after a reset or a new setup the energy may jump
+ */
+void StabilityMonitor::reset() {
+
+    telemetry.kineticEnergy = 0.0;
+    telemetry.elasticEnergy = 0.0;
+    telemetry.maxStrain = 0.0f;
+    telemetry.freeMass = 0.0;
+    telemetry.springEnergy = true;
+    good = telemetry;
+    hasGood = false;
+
+    snapshots[0].complete = false;
+    snapshots[1].complete = false;
+}
+
+
+/*
+ * Starts the snapshot of the next step in place of the one before the last
+ */
+void StabilityMonitor::beginSnapshot(const ClothState &state) {
+
+    current = 1 - current;
+
+    Snapshot &s = snapshots[current];
+    s.position.resize(state.size());
+    s.previousPosition.resize(state.size());
+    s.velocity.resize(state.size());
+    s.resetVersion = state.getResetVersion();
+    s.complete = false;
+}
+
+
+/*
+ * Saves knots [begin, end), different ranges may be saved from different threads
+ */
+void StabilityMonitor::saveSnapshot(const ClothState &state, unsigned int begin, unsigned int end) {
+
+    Snapshot &s = snapshots[current];
+
+    std::copy(state.position.begin() + begin, state.position.begin() + end, s.position.begin() + begin);
+    std::copy(state.previousPosition.begin() + begin, state.previousPosition.begin() + end,
+              s.previousPosition.begin() + begin);
+    std::copy(state.velocity.begin() + begin, state.velocity.begin() + end, s.velocity.begin() + begin);
+}
+
+
+void StabilityMonitor::commitSnapshot() {
+    snapshots[current].complete = true;
+}
+
+
+/*
+ * If the step before the current one can be taken again
+ */
+bool StabilityMonitor::canRollBack(const ClothState &state) {
+
+    const Snapshot &s = snapshots[1 - current];
+    return s.complete && s.resetVersion == state.getResetVersion() && s.position.size() == state.size();
+}
+
+
+/*
+ * Puts back the knots from before the last step. They are only good for one rollback, the
+ * step before them is gone
+ */
+void StabilityMonitor::rollBack(ClothState &state) {
+
+    Snapshot &s = snapshots[1 - current];
+
+    put(s, state);
+    s.complete = false;
+}
+
+
+/*
+ * Saves all knots of the cloth as the snapshot of the next step
+ */
+void StabilityMonitor::save(const ClothState &state) {
+    beginSnapshot(state);
+    saveSnapshot(state, 0, state.size());
+    commitSnapshot();
+}
+
+
+/*
+ * Puts back the knots of the last snapshot
+ */
+void StabilityMonitor::restore(ClothState &state) {
+
+    if(snapshots[current].position.size() == state.size())
+        put(snapshots[current], state);
+}
+
+
+void StabilityMonitor::put(const Snapshot &s, ClothState &state) {
+    std::copy(s.position.begin(), s.position.end(), state.position.begin());
+    std::copy(s.previousPosition.begin(), s.previousPosition.end(), state.previousPosition.begin());
+    std::copy(s.velocity.begin(), s.velocity.end(), state.velocity.begin());
+}
+
+
+void StabilityMonitor::reportMemory(MemoryReport &report) {
+
+    for(unsigned int k = 0; k < 2; k++) {
+        report.add("stability monitor", "snapshot position", snapshots[k].position);
+        report.add("stability monitor", "snapshot previousPosition", snapshots[k].previousPosition);
+        report.add("stability monitor", "snapshot velocity", snapshots[k].velocity);
+    }
+}
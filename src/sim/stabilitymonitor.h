@@ -0,0 +1,80 @@
+#ifndef STABILITYMONITOR_H
+#define STABILITYMONITOR_H
+
+// A step is unstable when the kinetic and elastic energy grows more than this factor, on top
+// of what gravity can add by moving every knot one knot spacing. Not for the integrators that
+// solve the springs as constraints
+#define STABILITY_ENERGY_GROWTH 2.0
+
+// A step is unstable when it stretches a spring further than before and more than this,
+// relative to its rest length
+#define STABILITY_MAX_STRAIN 1.0f
+
+#include <glm/glm.hpp>
+#include <vector>
+#include "clothstate.h"
+#include "clothforces.h"
+#include "memoryreport.h"
+
+/*
+ * StabilityMonitor class
+ *  Watches one cloth for steps that blow up. The cloth forces measure the energy and strain
+ *  of the cloth at the start of every step, which is what the step before it left behind.
+ *  When the energy explodes or a spring is torn far beyond its rest length, the step before
+ *  is rolled back so it can be taken again with a shorter dt.
+ *
+ *  For that the knots are saved at the start of every step, by the threads that resolve the
+ *  collisions while their knots are in cache. Two snapshots are kept, the one of the step
+ *  being taken and the one of the step before, which is what a rollback puts back. After the
+ *  cloth is reset the energy may jump, so the first measurement is the new reference.
+ */
+
+class StabilityMonitor {
+
+public:
+    // Constructors
+    StabilityMonitor();
+
+    // Member functions
+    bool needsReference(const ClothState &);
+    void measure(const ClothTelemetry &, const glm::vec3, float);
+    bool isStable();
+    bool isFinite();
+    void accept(const ClothState &);
+    void reset();
+
+    void beginSnapshot(const ClothState &);
+    void saveSnapshot(const ClothState &, unsigned int, unsigned int);
+    void commitSnapshot();
+    bool canRollBack(const ClothState &);
+    void rollBack(ClothState &);
+
+    void save(const ClothState &);
+    void restore(ClothState &);
+    void reportMemory(MemoryReport &);
+
+    // Getters
+    const ClothTelemetry & getTelemetry() { return telemetry; };
+
+private:
+    struct Snapshot {
+        std::vector<glm::vec3> position;
+        std::vector<glm::vec3> previousPosition;
+        std::vector<glm::vec3> velocity;
+        unsigned int resetVersion;
+        bool complete;      // The step that started from it was taken to the end
+    };
+
+    void put(const Snapshot &, ClothState &);
+
+    ClothTelemetry telemetry;   // Measured at the start of the step
+    ClothTelemetry good;        // At the start of the last step that was stable
+    bool hasGood;
+    unsigned int goodVersion;   // Reset version of the cloth when it was accepted
+    double gravityEnergy;       // Most energy gravity can add in one stable step
+
+    Snapshot snapshots[2];
+    unsigned int current;       // Snapshot of the step being taken
+};
+
+#endif // STABILITYMONITOR_H
@@ -0,0 +1,59 @@
+#include "stepscheduler.h"
+#include <algorithm>
+#include <cmath>
+
+StepScheduler::StepScheduler()
+    : lastTime(0.0), accumulator(0.0), started(false), level(0), substeps(0) {
+
+}
+
+
+/*
+ * Call once per frame with the current time and the longest stable step of the scene
+ */
+void StepScheduler::advance(double time, float maxStep) {
+
+    if(!started) {
+        lastTime = time;
+        started = true;
+    }
+
+    accumulator += std::min(std::max(time - lastTime, 0.0), SCHEDULER_MAX_FRAME_TIME);
+    lastTime = time;
+
+    chooseLevel(maxStep);
+
+    double dt = getDt();
+    substeps = static_cast<unsigned int>(std::floor(accumulator / dt));
+
+    if(substeps > SCHEDULER_MAX_SUBSTEPS) {
+        // Can not keep up, let the simulation fall behind instead of piling up more work
+        substeps = SCHEDULER_MAX_SUBSTEPS;
+        accumulator = 0.0;
+    } else {
+        accumulator -= substeps * dt;
+    }
+}
+
+
+/*
+ * Call instead of advance while the simulation is paused, so the paused time is not made up
+ */
+void StepScheduler::skip(double time) {
+
+    lastTime = time;
+    started = true;
+    substeps = 0;
+}
+
+
+void StepScheduler::chooseLevel(float maxStep) {
+
+    // Shorter steps as soon as the scene needs them
+    while(level < SCHEDULER_MAX_LEVEL && getStep(level) > maxStep)
+        level++;
+
+    // Longer steps only with some margin, so the level does not flip back and forth
+    while(level > 0 && getStep(level - 1) * SCHEDULER_HYSTERESIS <= maxStep)
+        level--;
+}
@@ -0,0 +1,54 @@
+#ifndef STEPSCHEDULER_H
+#define STEPSCHEDULER_H
+
+// The steps are SCHEDULER_FRAME_STEP / 2^level, between level 0 and SCHEDULER_MAX_LEVEL
+#define SCHEDULER_FRAME_STEP (1.0f / 60.0f)
+#define SCHEDULER_MAX_LEVEL 6
+
+// Never more steps than this in one frame, the simulation slows down instead
+#define SCHEDULER_MAX_SUBSTEPS 64
+
+// Longest time taken from the clock in one frame, so a hiccup does not cause a burst of steps
+#define SCHEDULER_MAX_FRAME_TIME 0.25
+
+// How much longer than the next coarser step the stable step must be before switching to it
+#define SCHEDULER_HYSTERESIS 1.5f
+
+/*
+ * StepScheduler class
+ *  Decides how many simulation steps to take every frame and how long they are. The wall
+ *  clock time since the last frame goes into an accumulator, and whole steps are taken out of
+ *  it so the simulation keeps up with real time however fast or slow the frames are.
+ *
+ *  The step length is picked every frame from the longest stable step of the scene. The steps
+ *  are halvings of a frame, so the integrators that factor the step into their systems only
+ *  see it change when the scene gets calmer or more violent.
+ */
+
+class StepScheduler {
+
+public:
+    // Constructors
+    StepScheduler();
+
+    // Member functions
+    void advance(double, float);
+    void skip(double);
+
+    // Getters
+    unsigned int getSubsteps() { return substeps; };
+    unsigned int getLevel() { return level; };
+    float getDt() { return getStep(level); };
+
+private:
+    float getStep(unsigned int l) { return SCHEDULER_FRAME_STEP / static_cast<float>(1u << l); };
+    void chooseLevel(float);
+
+    double lastTime;
+    double accumulator;     // Wall clock time not simulated yet
+    bool started;
+    unsigned int level;
+    unsigned int substeps;  // Steps to take this frame
+};
+
+#endif // STEPSCHEDULER_H
@@ -0,0 +1,172 @@
+#include "threadpool.h"
+#include "tracer.h"
+#include <algorithm>
+
+// How long idle threads spin before they go to sleep, the substeps of a frame come in
+// quick succession and waking a sleeping thread costs more than a short spin
+#define THREADPOOL_SPIN_COUNT 20000
+
+// Index of the calling thread within the pool, 0 for the thread that owns the pool
+static thread_local unsigned int threadIndex = 0;
+
+
+// Let other threads on the same core run now and then, the pool may share cores with them
+static inline void cpuRelax(unsigned int spins) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    if(spins % 64 != 63) {
+        __builtin_ia32_pause();
+        return;
+    }
+#endif
+    std::this_thread::yield();
+}
+
+
+ThreadPool::ThreadPool(unsigned int n)
+    : task(NULL), taskData(NULL), taskEnd(0), taskGrain(1), next(0), busy(0), generation(0), quit(false) {
+
+    startWorkers(std::max(n, 1u) - 1);
+}
+
+
+ThreadPool::~ThreadPool() {
+    stopWorkers();
+}
+
+
+ThreadPool * ThreadPool::instance() {
+
+    static ThreadPool pool(std::max(std::thread::hardware_concurrency(), 1u));
+
+    return &pool;
+}
+
+
+unsigned int ThreadPool::getThreadIndex() {
+    return threadIndex;
+}
+
+
+void ThreadPool::setNumThreads(unsigned int n) {
+
+    n = std::max(n, 1u);
+
+    if(n == getNumThreads())
+        return;
+
+    stopWorkers();
+    startWorkers(n - 1);
+}
+
+
+void ThreadPool::run(unsigned int begin, unsigned int end, unsigned int grain, TaskFunction f, const void *data) {
+
+    if(begin >= end)
+        return;
+
+    grain = std::max(grain, 1u);
+
+    // Not worth waking anyone up for
+    if(workers.empty() || end - begin <= grain) {
+        f(data, begin, end);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = f;
+        taskData = data;
+        taskEnd = end;
+        taskGrain = grain;
+        next = begin;
+        busy = workers.size();
+        generation++;
+    }
+    wake.notify_all();
+
+    work();
+
+    // Wait for the workers to finish their last chunks
+    for(unsigned int spins = 0; busy.load() != 0; spins++) {
+        if(spins < THREADPOOL_SPIN_COUNT) {
+            cpuRelax(spins);
+        } else {
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [this] { return busy.load() == 0; });
+        }
+    }
+}
+
+
+void ThreadPool::work() {
+
+    while(true) {
+        unsigned int begin = next.fetch_add(taskGrain);
+
+        if(begin >= taskEnd)
+            break;
+
+        task(taskData, begin, std::min(begin + taskGrain, taskEnd));
+    }
+}
+
+
+/*
+ * The generation the worker was started at is passed in, a worker that only reads it once it
+ * runs could miss a task given right after it was started and the pool would wait for it forever
+ */
+void ThreadPool::workerLoop(unsigned int index, unsigned int seen) {
+
+    threadIndex = index;
+
+    while(true) {
+
+        for(unsigned int spins = 0; generation.load() == seen && spins < THREADPOOL_SPIN_COUNT; spins++)
+            cpuRelax(spins);
+
+        if(generation.load() == seen) {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this, seen] { return generation.load() != seen; });
+        }
+
+        seen = generation.load();
+
+        if(quit)
+            return;
+
+        {
+            TraceScope trace("parallelFor");
+            work();
+        }
+
+        if(busy.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> lock(mutex);
+            done.notify_one();
+        }
+    }
+}
+
+
+void ThreadPool::startWorkers(unsigned int n) {
+
+    quit = false;
+
+    for(unsigned int i = 0; i < n; i++)
+        workers.push_back(std::thread(&ThreadPool::workerLoop, this, i + 1, generation.load()));
+}
+
+
+void ThreadPool::stopWorkers() {
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+        generation++;
+    }
+    wake.notify_all();
+
+    for(unsigned int i = 0; i < workers.size(); i++)
+        workers[i].join();
+
+    workers.clear();
+}
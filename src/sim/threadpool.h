@@ -0,0 +1,72 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+/*
+ * ThreadPool class
+ *  A fixed set of worker threads that split index ranges between them. The calling thread
+ *  takes part in the work, so a pool of size n has n - 1 workers. Ranges are handed out in
+ *  chunks of "grain" indices until the whole range is done, and parallelFor returns once
+ *  every chunk has finished. Tasks are passed by reference without any allocation.
+ */
+
+class ThreadPool {
+
+public:
+    // Constructors
+    ThreadPool(unsigned int);
+
+    // Destructor
+    ~ThreadPool();
+
+    static ThreadPool * instance();
+
+    // Member functions
+    template<class F>
+    void parallelFor(unsigned int begin, unsigned int end, unsigned int grain, const F &f) {
+        run(begin, end, grain, &invoke<F>, &f);
+    }
+
+    // Getters
+    unsigned int getNumThreads() { return workers.size() + 1; };
+    unsigned int getThreadIndex();
+
+    // Setters
+    void setNumThreads(unsigned int);
+
+private:
+    typedef void (*TaskFunction)(const void *, unsigned int, unsigned int);
+
+    template<class F>
+    static void invoke(const void *f, unsigned int begin, unsigned int end) {
+        (*static_cast<const F *>(f))(begin, end);
+    }
+
+    void run(unsigned int, unsigned int, unsigned int, TaskFunction, const void *);
+    void work();
+    void workerLoop(unsigned int, unsigned int);
+    void startWorkers(unsigned int);
+    void stopWorkers();
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    // The task currently being run
+    TaskFunction task;
+    const void *taskData;
+    unsigned int taskEnd;
+    unsigned int taskGrain;
+    std::atomic<unsigned int> next;
+    std::atomic<unsigned int> busy;
+    std::atomic<unsigned int> generation;
+    bool quit;
+};
+
+#endif // THREADPOOL_H
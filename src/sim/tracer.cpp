@@ -0,0 +1,159 @@
+#include "tracer.h"
+#include "threadpool.h"
+#include <fstream>
+#include <iostream>
+
+// The buffer of the calling thread, NULL until it records its first event
+static thread_local void *threadBuffer = NULL;
+
+
+Tracer::Tracer()
+    : enabled(false), epoch(Clock::now()) {
+
+}
+
+
+Tracer::~Tracer() {
+
+    for(unsigned int i = 0; i < buffers.size(); i++)
+        delete buffers[i];
+}
+
+
+Tracer * Tracer::instance() {
+
+    static Tracer tracer;
+
+    return &tracer;
+}
+
+
+Tracer::ThreadBuffer * Tracer::getThreadBuffer() {
+
+    if(threadBuffer != NULL)
+        return static_cast<ThreadBuffer *>(threadBuffer);
+
+    ThreadBuffer *buffer = new ThreadBuffer();
+    buffer->poolIndex = ThreadPool::instance()->getThreadIndex();
+    buffer->events.resize(TRACE_MAX_EVENTS);
+    buffer->size.store(0);
+    buffer->dropped.store(0);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        buffer->tid = buffers.size() + 1;
+        buffers.push_back(buffer);
+    }
+
+    threadBuffer = buffer;
+
+    return buffer;
+}
+
+
+void Tracer::record(const char *name, Clock::time_point start, Clock::time_point stop) {
+
+    ThreadBuffer *buffer = getThreadBuffer();
+    unsigned int n = buffer->size.load(std::memory_order_relaxed);
+
+    if(n >= TRACE_MAX_EVENTS) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Event &e = buffer->events[n];
+    e.name = name;
+    e.start = std::chrono::duration_cast<std::chrono::nanoseconds>(start - epoch).count();
+    e.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+
+    // Publish the event
+    buffer->size.store(n + 1, std::memory_order_release);
+}
+
+
+/*
+ * Forgets all events. Only call this while no other thread is recording
+ */
+void Tracer::clear() {
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for(unsigned int i = 0; i < buffers.size(); i++) {
+        buffers[i]->size.store(0, std::memory_order_relaxed);
+        buffers[i]->dropped.store(0, std::memory_order_relaxed);
+    }
+}
+
+
+/*
+ * Writes the events in the Trace Event Format, as complete ("X") events in microseconds
+ */
+bool Tracer::write(const std::string &fileName) {
+
+    std::ofstream file(fileName.c_str());
+
+    if(!file) {
+        std::cerr << "Could not open " << fileName << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    unsigned int total = 0;
+    unsigned int dropped = 0;
+    bool first = true;
+
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << std::endl;
+
+    for(unsigned int b = 0; b < buffers.size(); b++) {
+
+        ThreadBuffer *buffer = buffers[b];
+        unsigned int n = buffer->size.load(std::memory_order_acquire);
+
+        // Name the thread in the viewer
+        file << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->tid
+             << ", \"args\": {\"name\": \"";
+        if(buffer->poolIndex == 0)
+            file << "main";
+        else
+            file << "worker " << buffer->poolIndex;
+        file << "\"}}";
+        first = false;
+
+        for(unsigned int i = 0; i < n; i++) {
+
+            const Event &e = buffer->events[i];
+
+            file << ",\n{\"name\": \"" << e.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << buffer->tid
+                 << ", \"ts\": " << e.start / 1000 << "." << (e.start % 1000) / 100 << (e.start % 100) / 10 << e.start % 10
+                 << ", \"dur\": " << e.duration / 1000 << "." << (e.duration % 1000) / 100 << (e.duration % 100) / 10 << e.duration % 10
+                 << "}";
+        }
+
+        total += n;
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+
+    file << "\n]}" << std::endl;
+
+    std::cout << "Wrote " << total << " trace events to " << fileName;
+    if(dropped > 0)
+        std::cout << ", " << dropped << " did not fit and were dropped";
+    std::cout << std::endl;
+
+    return true;
+}
+
+
+/*
+ * Every thread that recorded an event has a full buffer, even when the tracer is off again
+ */
+void Tracer::reportMemory(MemoryReport &report) {
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    report.add("tracer", "buffers", buffers);
+
+    for(unsigned int i = 0; i < buffers.size(); i++)
+        report.add("tracer", "events", sizeof(ThreadBuffer) + buffers[i]->events.capacity() * sizeof(Event));
+}
@@ -0,0 +1,105 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+// Events kept per thread, later ones are dropped. About 8 MB per thread
+#define TRACE_MAX_EVENTS (1u << 18)
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "memoryreport.h"
+
+/*
+ * Tracer class
+ *  Records when every traced scope started and how long it took, on every thread, and
+ *  writes them as a Chrome trace (chrome://tracing or ui.perfetto.dev) where they show up as
+ *  a flame graph per thread.
+ *
+ *  Every thread writes its own buffer, so recording an event never waits on another thread.
+ *  A buffer is allocated the first time a thread records something while tracing is on.
+ */
+
+class Tracer {
+
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Event {
+        const char *name;       // Must outlive the tracer, string literals or phase names
+        uint64_t start;         // Nanoseconds since the tracer was created
+        uint64_t duration;
+    };
+
+    // Constructors
+    Tracer();
+
+    // Destructor
+    ~Tracer();
+
+    static Tracer * instance();
+
+    // Member functions
+    void record(const char *, Clock::time_point, Clock::time_point);
+    void clear();
+    void reportMemory(MemoryReport &);
+    bool write(const std::string &);
+
+    // Getters
+    bool isEnabled() { return enabled.load(std::memory_order_relaxed); };
+
+    // Setters
+    void setEnabled(bool e) { enabled.store(e, std::memory_order_relaxed); };
+
+private:
+    struct ThreadBuffer {
+        unsigned int tid;
+        unsigned int poolIndex;                 // ThreadPool index, 0 for the main thread
+        std::vector<Event> events;
+        std::atomic<unsigned int> size;         // Events written so far
+        std::atomic<unsigned int> dropped;      // Events that did not fit
+    };
+
+    Tracer(const Tracer &);
+    Tracer & operator=(const Tracer &);
+
+    ThreadBuffer * getThreadBuffer();
+
+    std::atomic<bool> enabled;
+    Clock::time_point epoch;
+
+    std::mutex mutex;                       // Guards buffers when a thread registers
+    std::vector<ThreadBuffer *> buffers;
+};
+
+
+/*
+ * TraceScope class
+ *  Records one event from its construction to its destruction when tracing is on
+ */
+
+class TraceScope {
+
+public:
+    TraceScope(const char *n) : name(n), running(Tracer::instance()->isEnabled()) {
+        if(running)
+            start = Tracer::Clock::now();
+    };
+
+    ~TraceScope() {
+        if(running)
+            Tracer::instance()->record(name, start, Tracer::Clock::now());
+    };
+
+private:
+    TraceScope(const TraceScope &);
+    TraceScope & operator=(const TraceScope &);
+
+    const char *name;
+    bool running;
+    Tracer::Clock::time_point start;
+};
+
+#endif // TRACER_H
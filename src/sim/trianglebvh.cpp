@@ -0,0 +1,437 @@
+#include "trianglebvh.h"
+#include <algorithm>
+#include <cfloat>
+#include "threadpool.h"
+
+static float getAxis(const glm::vec3 &v, unsigned int axis) {
+    return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+
+static float getSurfaceArea(const glm::vec3 &lower, const glm::vec3 &upper) {
+    glm::vec3 d = upper - lower;
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+
+TriangleBVH::TriangleBVH()
+    : topUsed(0), builds(0), refits(0), area(0.0f), builtArea(0.0f) {
+
+}
+
+
+void TriangleBVH::clear() {
+    triangles.clear();
+    order.clear();
+    nodes.clear();
+    subtrees.clear();
+    topUsed = 0;
+    area = builtArea = 0.0f;
+}
+
+
+unsigned int TriangleBVH::getNumNodes() const {
+
+    unsigned int n = topUsed;
+
+    for(unsigned int s = 0; s < subtrees.size(); s++)
+        n += subtrees[s].used;
+
+    return n;
+}
+
+
+/*
+ * Builds the tree over new triangles, three knot indices each
+ */
+void TriangleBVH::build(const ClothState &state, const std::vector<unsigned int> &t) {
+    triangles = t;
+    build(state);
+}
+
+
+/*
+ * Builds the tree again over the same triangles where the knots are now
+ */
+void TriangleBVH::build(const ClothState &state) {
+
+    const unsigned int n = static_cast<unsigned int>(triangles.size() / 3);
+
+    builds++;
+    nodes.clear();
+    subtrees.clear();
+    topUsed = 0;
+
+    if(n == 0)
+        return;
+
+    const unsigned int target = BVH_SUBTREES_PER_THREAD * ThreadPool::instance()->getNumThreads();
+
+    // The top has a node per subtree and less than as many above them, every subtree has
+    // two nodes per triangle. Reserved so a rebuild of the same cloth does not allocate
+    nodes.reserve(4 * target + 1 + 2 * n);
+    subtrees.reserve(2 * target);
+
+    order.resize(n);
+    centroid.resize(n);
+
+    const glm::vec3 *x = &state.position[0];
+    const unsigned int *knots = &triangles[0];
+    glm::vec3 *c = &centroid[0];
+
+    ThreadPool::instance()->parallelFor(0, n, KNOT_GRAIN_SIZE,
+        [x, knots, c](unsigned int begin, unsigned int end) {
+            for(unsigned int t = begin; t < end; t++)
+                c[t] = (x[knots[3 * t]] + x[knots[3 * t + 1]] + x[knots[3 * t + 2]]) * (1.0f / 3.0f);
+        });
+
+    for(unsigned int t = 0; t < n; t++)
+        order[t] = t;
+
+    // The top, split a level at a time until there are enough subtrees for the threads
+    Node root;
+    root.first = 0;
+    root.count = 0;
+    nodes.push_back(root);
+
+    Subtree whole;
+    whole.root = 0;
+    whole.begin = 0;
+    whole.end = n;
+    whole.used = 0;
+    whole.area = 0.0f;
+    subtrees.push_back(whole);
+
+    bool splitAny = true;
+
+    while(splitAny && subtrees.size() < target) {
+
+        splitAny = false;
+        const unsigned int level = static_cast<unsigned int>(subtrees.size());
+
+        for(unsigned int s = 0; s < level; s++) {
+
+            if(subtrees[s].end - subtrees[s].begin <= BVH_MIN_SUBTREE)
+                continue;
+
+            unsigned int mid = split(subtrees[s].begin, subtrees[s].end);
+            unsigned int left = static_cast<unsigned int>(nodes.size());
+
+            nodes[subtrees[s].root].first = left;
+            nodes.push_back(root);
+            nodes.push_back(root);
+
+            Subtree right = subtrees[s];
+            right.root = left + 1;
+            right.begin = mid;
+            subtrees.push_back(right);
+
+            subtrees[s].root = left;
+            subtrees[s].end = mid;
+
+            splitAny = true;
+        }
+    }
+
+    topUsed = static_cast<unsigned int>(nodes.size());
+    nodes.resize(topUsed + 2 * n);
+
+    for(unsigned int s = 0; s < subtrees.size(); s++)
+        subtrees[s].block = topUsed + 2 * subtrees[s].begin;
+
+    ThreadPool::instance()->parallelFor(0, static_cast<unsigned int>(subtrees.size()), 1,
+        [this](unsigned int begin, unsigned int end) {
+            for(unsigned int s = begin; s < end; s++)
+                buildSubtree(subtrees[s]);
+        });
+
+    area = builtArea = refitAll(state);
+}
+
+
+/*
+ * Sorts triangles [begin, end) of order so the ones whose centres are below the median
+ * along the longest axis of the centres come first, returns where the second half starts
+ */
+unsigned int TriangleBVH::split(unsigned int begin, unsigned int end) {
+
+    glm::vec3 lower(FLT_MAX);
+    glm::vec3 upper(-FLT_MAX);
+
+    for(unsigned int i = begin; i < end; i++) {
+        lower = glm::min(lower, centroid[order[i]]);
+        upper = glm::max(upper, centroid[order[i]]);
+    }
+
+    glm::vec3 extent = upper - lower;
+    unsigned int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+    unsigned int mid = begin + (end - begin) / 2;
+
+    const std::vector<glm::vec3> &c = centroid;
+    std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end,
+        [&c, axis](unsigned int a, unsigned int b) {
+            return getAxis(c[a], axis) < getAxis(c[b], axis);
+        });
+
+    return mid;
+}
+
+
+/*
+ * Builds the nodes below the root of a subtree in its own block, depth first. A node is
+ * split until it has BVH_LEAF_SIZE triangles or less
+ */
+void TriangleBVH::buildSubtree(Subtree &s) {
+
+    struct Range {
+        unsigned int node;
+        unsigned int begin;
+        unsigned int end;
+    };
+
+    // Every split takes one range and adds two, so this holds a path from the root
+    Range stack[BVH_MAX_DEPTH + 1];
+    unsigned int size = 0;
+
+    Range root = { s.root, s.begin, s.end };
+    stack[size++] = root;
+    s.used = 0;
+
+    while(size > 0) {
+
+        Range r = stack[--size];
+        Node &node = nodes[r.node];
+
+        if(r.end - r.begin <= BVH_LEAF_SIZE || size + 2 > BVH_MAX_DEPTH) {
+            node.first = r.begin;
+            node.count = r.end - r.begin;
+            continue;
+        }
+
+        unsigned int mid = split(r.begin, r.end);
+        unsigned int left = s.block + s.used;
+        s.used += 2;
+
+        node.first = left;
+        node.count = 0;
+
+        Range right = { left + 1, mid, r.end };
+        Range first = { left, r.begin, mid };
+        stack[size++] = right;
+        stack[size++] = first;
+    }
+}
+
+
+/*
+ * Moves the boxes to where the knots are now. Builds the tree the first time, and again when
+ * the boxes grew too much since the last build
+ */
+void TriangleBVH::refit(const ClothState &state) {
+
+    if(nodes.empty() || order.size() != triangles.size() / 3) {
+        build(state);
+        return;
+    }
+
+    refits++;
+    area = refitAll(state);
+
+    if(area > BVH_REBUILD_RATIO * builtArea)
+        build(state);
+}
+
+
+/*
+ * Every box from the leaves up, returns the sum of their surface areas. The children of a
+ * node come after it, so going backwards through a block or the top meets them first
+ */
+float TriangleBVH::refitAll(const ClothState &state) {
+
+    ThreadPool::instance()->parallelFor(0, static_cast<unsigned int>(subtrees.size()), 1,
+        [this, &state](unsigned int begin, unsigned int end) {
+            for(unsigned int s = begin; s < end; s++) {
+
+                Subtree &subtree = subtrees[s];
+                subtree.area = 0.0f;
+
+                for(unsigned int i = subtree.block + subtree.used; i-- > subtree.block; )
+                    subtree.area += refitNode(state, i);
+            }
+        });
+
+    float sum = 0.0f;
+
+    for(unsigned int s = 0; s < subtrees.size(); s++)
+        sum += subtrees[s].area;
+
+    for(unsigned int i = topUsed; i-- > 0; )
+        sum += refitNode(state, i);
+
+    return sum;
+}
+
+
+float TriangleBVH::refitNode(const ClothState &state, unsigned int i) {
+
+    Node &node = nodes[i];
+
+    if(node.count > 0) {
+
+        getTriangleBounds(state, order[node.first], node.lower, node.upper);
+
+        for(unsigned int t = 1; t < node.count; t++) {
+            glm::vec3 lower, upper;
+            getTriangleBounds(state, order[node.first + t], lower, upper);
+            node.lower = glm::min(node.lower, lower);
+            node.upper = glm::max(node.upper, upper);
+        }
+    } else {
+        node.lower = glm::min(nodes[node.first].lower, nodes[node.first + 1].lower);
+        node.upper = glm::max(nodes[node.first].upper, nodes[node.first + 1].upper);
+    }
+
+    return getSurfaceArea(node.lower, node.upper);
+}
+
+
+void TriangleBVH::getTriangleBounds(const ClothState &state, unsigned int t, glm::vec3 &lower, glm::vec3 &upper) const {
+
+    const glm::vec3 &a = state.position[triangles[3 * t]];
+    const glm::vec3 &b = state.position[triangles[3 * t + 1]];
+    const glm::vec3 &c = state.position[triangles[3 * t + 2]];
+
+    lower = glm::min(a, glm::min(b, c));
+    upper = glm::max(a, glm::max(b, c));
+}
+
+
+/*
+ * Adds the triangles whose boxes overlap the box to the list
+ */
+void TriangleBVH::queryBox(const ClothState &state, const glm::vec3 &lower, const glm::vec3 &upper,
+                           std::vector<unsigned int> &result) const {
+
+    if(nodes.empty())
+        return;
+
+    unsigned int stack[BVH_MAX_DEPTH + 1];
+    unsigned int size = 0;
+    stack[size++] = 0;
+
+    while(size > 0) {
+
+        const Node &node = nodes[stack[--size]];
+
+        if(node.lower.x > upper.x || lower.x > node.upper.x ||
+           node.lower.y > upper.y || lower.y > node.upper.y ||
+           node.lower.z > upper.z || lower.z > node.upper.z)
+            continue;
+
+        if(node.count == 0) {
+            stack[size++] = node.first + 1;
+            stack[size++] = node.first;
+            continue;
+        }
+
+        for(unsigned int t = node.first; t < node.first + node.count; t++) {
+
+            glm::vec3 triangleLower, triangleUpper;
+            getTriangleBounds(state, order[t], triangleLower, triangleUpper);
+
+            if(triangleLower.x <= upper.x && lower.x <= triangleUpper.x &&
+               triangleLower.y <= upper.y && lower.y <= triangleUpper.y &&
+               triangleLower.z <= upper.z && lower.z <= triangleUpper.z)
+                result.push_back(order[t]);
+        }
+    }
+}
+
+
+/*
+ * The closest triangle along the ray from origin in the direction, not further than t. On a
+ * hit t is where along the direction it was hit and triangle which one it was
+ */
+bool TriangleBVH::intersectRay(const ClothState &state, const glm::vec3 &origin, const glm::vec3 &direction,
+                               float &t, unsigned int &triangle) const {
+
+    if(nodes.empty())
+        return false;
+
+    // Infinite along an axis the ray does not move along, which the slab test handles
+    const glm::vec3 inverse(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+    unsigned int stack[BVH_MAX_DEPTH + 1];
+    unsigned int size = 0;
+    stack[size++] = 0;
+    bool hit = false;
+
+    while(size > 0) {
+
+        const Node &node = nodes[stack[--size]];
+
+        glm::vec3 t0 = (node.lower - origin) * inverse;
+        glm::vec3 t1 = (node.upper - origin) * inverse;
+        glm::vec3 first = glm::min(t0, t1);
+        glm::vec3 last = glm::max(t0, t1);
+
+        float enter = std::max(std::max(first.x, first.y), std::max(first.z, 0.0f));
+        float exit = std::min(std::min(std::min(last.x, last.y), last.z) * BVH_RAY_SLACK, t);
+
+        if(enter > exit)
+            continue;
+
+        if(node.count == 0) {
+            stack[size++] = node.first + 1;
+            stack[size++] = node.first;
+            continue;
+        }
+
+        // Möller-Trumbore
+        for(unsigned int i = node.first; i < node.first + node.count; i++) {
+
+            const unsigned int k = order[i];
+            const glm::vec3 &a = state.position[triangles[3 * k]];
+            const glm::vec3 e1 = state.position[triangles[3 * k + 1]] - a;
+            const glm::vec3 e2 = state.position[triangles[3 * k + 2]] - a;
+
+            glm::vec3 p = glm::cross(direction, e2);
+            float determinant = glm::dot(e1, p);
+
+            if(determinant == 0.0f)
+                continue;
+
+            float inverseDeterminant = 1.0f / determinant;
+            glm::vec3 s = origin - a;
+            float u = glm::dot(s, p) * inverseDeterminant;
+
+            if(u < 0.0f || u > 1.0f)
+                continue;
+
+            glm::vec3 q = glm::cross(s, e1);
+            float v = glm::dot(direction, q) * inverseDeterminant;
+
+            if(v < 0.0f || u + v > 1.0f)
+                continue;
+
+            float distance = glm::dot(e2, q) * inverseDeterminant;
+
+            if(distance >= 0.0f && distance <= t) {
+                t = distance;
+                triangle = k;
+                hit = true;
+            }
+        }
+    }
+
+    return hit;
+}
+
+
+void TriangleBVH::reportMemory(MemoryReport &report) {
+    report.add("triangle bvh", "triangles", triangles);
+    report.add("triangle bvh", "order", order);
+    report.add("triangle bvh", "centroid", centroid);
+    report.add("triangle bvh", "nodes", nodes);
+    report.add("triangle bvh", "subtrees", subtrees);
+}
@@ -0,0 +1,108 @@
+#ifndef TRIANGLEBVH_H
+#define TRIANGLEBVH_H
+
+// Most triangles in a leaf
+#define BVH_LEAF_SIZE 4
+
+// A rebuild splits the top of the tree on one thread until there are this many subtrees per
+// thread, or they are smaller than BVH_MIN_SUBTREE triangles, and builds the subtrees in parallel
+#define BVH_SUBTREES_PER_THREAD 4
+#define BVH_MIN_SUBTREE 256
+
+// The tree is rebuilt when refitting made the boxes this much larger than after the last build,
+// measured by the sum of their surface areas
+#define BVH_REBUILD_RATIO 1.5f
+
+// A ray leaves every box this much later than computed, rounding would otherwise miss a ray
+// that hits a triangle right on the face of its box, such as one aimed at a knot
+#define BVH_RAY_SLACK 1.000001f
+
+// Deepest a query can go, a median split of 2^32 triangles is 32 levels
+#define BVH_MAX_DEPTH 64
+
+#include <glm/glm.hpp>
+#include <vector>
+#include "clothstate.h"
+#include "memoryreport.h"
+
+/*
+ * TriangleBVH class
+ *  A bounding volume hierarchy of axis aligned boxes over triangles whose corners are knots,
+ *  three knot indices per triangle. A cloth keeps one over the triangles of ClothGeometry,
+ *  for queries of triangles near a box or along a ray.
+ *
+ *  build() splits the triangles at the median of their centres along the longest axis of
+ *  their box, down to leaves of BVH_LEAF_SIZE. The top of the tree is split on one thread
+ *  and the subtrees below it are built in parallel. Every subtree has its own block of nodes,
+ *  two per triangle, so the threads never share a node, and the two children of a node are
+ *  always next to each other after it.
+ *
+ *  refit() only moves the boxes to where the knots are, from the leaves up, the subtrees in
+ *  parallel and then the top. It is much cheaper than a build, but the boxes of a tree built
+ *  for a flat cloth grow as the cloth folds, so refit() rebuilds the tree instead once the
+ *  sum of the surface areas of the boxes is BVH_REBUILD_RATIO times what it was after the
+ *  last build. Neither allocates once the tree was built for a cloth of this size.
+ */
+
+class TriangleBVH {
+
+public:
+    // Constructors
+    TriangleBVH();
+
+    // Member functions
+    void build(const ClothState &, const std::vector<unsigned int> &);
+    void build(const ClothState &);
+    void refit(const ClothState &);
+    void queryBox(const ClothState &, const glm::vec3 &, const glm::vec3 &, std::vector<unsigned int> &) const;
+    bool intersectRay(const ClothState &, const glm::vec3 &, const glm::vec3 &, float &, unsigned int &) const;
+    void clear();
+    void reportMemory(MemoryReport &);
+
+    // Getters
+    bool isEmpty() const { return nodes.empty(); };
+    unsigned int getNumTriangles() const { return static_cast<unsigned int>(order.size()); };
+    unsigned int getNumNodes() const;
+    unsigned int getNumBuilds() const { return builds; };
+    unsigned int getNumRefits() const { return refits; };
+    float getQuality() const { return builtArea > 0.0f ? area / builtArea : 1.0f; };
+    const std::vector<unsigned int> & getTriangles() const { return triangles; };
+
+private:
+    struct Node {
+        glm::vec3 lower;
+        unsigned int first;     // Left child, the right one is next to it, or first in order
+        glm::vec3 upper;
+        unsigned int count;     // Triangles of a leaf, 0 for the other nodes
+    };
+
+    // Nodes a thread builds below one node of the top
+    struct Subtree {
+        unsigned int root;
+        unsigned int begin;     // Triangles [begin, end) of order
+        unsigned int end;
+        unsigned int block;     // Nodes [block, block + used)
+        unsigned int used;
+        float area;             // Sum over the nodes below the root
+    };
+
+    unsigned int split(unsigned int, unsigned int);
+    void buildSubtree(Subtree &);
+    float refitAll(const ClothState &);
+    float refitNode(const ClothState &, unsigned int);
+    void getTriangleBounds(const ClothState &, unsigned int, glm::vec3 &, glm::vec3 &) const;
+
+    std::vector<unsigned int> triangles;    // Three knots per triangle
+    std::vector<unsigned int> order;        // Triangles in the order of the leaves
+    std::vector<glm::vec3> centroid;        // Of every triangle when the tree was built
+    std::vector<Node> nodes;                // The top, then the blocks of the subtrees
+    std::vector<Subtree> subtrees;
+
+    unsigned int topUsed;       // Nodes [0, topUsed) are the top of the tree
+    unsigned int builds;
+    unsigned int refits;
+    float area;                 // Sum of the surface areas of the boxes, after the last refit
+    float builtArea;            // and after the last build
+};
+
+#endif // TRIANGLEBVH_H
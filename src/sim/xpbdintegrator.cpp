@@ -0,0 +1,106 @@
+#include "xpbdintegrator.h"
+#include <algorithm>
+
+// Compliance and damping by spring type
+static const float compliance[] = { XPBD_STRUCTURAL_COMPLIANCE, XPBD_SHEAR_COMPLIANCE, XPBD_BEND_COMPLIANCE };
+static const float damping[] = { XPBD_STRUCTURAL_DAMPING, XPBD_SHEAR_DAMPING, XPBD_BEND_DAMPING };
+
+
+void XPBDIntegrator::resize(unsigned int numKnots, unsigned int numSprings) {
+
+    previous.resize(numKnots);
+    weight.resize(numKnots);
+    lambda.resize(numSprings);
+}
+
+
+/*
+ * Applies the external forces and moves the knots to their predicted positions
+ */
+void XPBDIntegrator::applyForces(ClothState &state, ClothForces &forces, const glm::vec3 G, float h) {
+
+    resize(state.size(), forces.getNumSprings());
+
+    // The springs are never evaluated at the knots the step starts from
+    forces.measure(state);
+    forces.computeExternalForces(state, &state.force[0]);
+
+    for(unsigned int i = 0; i < state.size(); i++) {
+
+        previous[i] = state.position[i];
+
+        if(state.isPinned(i)) {
+            weight[i] = 0.0f;
+            continue;
+        }
+
+        weight[i] = state.invMass[i];
+        state.velocity[i] += (state.force[i] * state.invMass[i] + G) * h;
+        state.position[i] += state.velocity[i] * h;
+    }
+}
+
+
+/*
+ * Projects the predicted positions onto the constraints and updates the velocities
+ */
+void XPBDIntegrator::integrate(ClothState &state, ClothForces &forces, const glm::vec3 /* G */, float h) {
+
+    resize(state.size(), forces.getNumSprings());
+
+    const SpringSet *springs = forces.getSprings();
+    const unsigned int grain = forces.getSpringGrainSize();
+
+    std::fill(lambda.begin(), lambda.end(), 0.0f);
+
+    glm::vec3 *x = &state.position[0];
+    const glm::vec3 *x0 = &previous[0];
+    const float *w = &weight[0];
+    float *l = &lambda[0];
+
+    for(unsigned int iteration = 0; iteration < XPBD_ITERATIONS; iteration++) {
+        for(unsigned int c = 0; c < springs->getNumColors(); c++) {
+            ThreadPool::instance()->parallelFor(springs->colorOffsets[c], springs->colorOffsets[c + 1], grain,
+                [springs, x, x0, w, l, h](unsigned int begin, unsigned int end) {
+                    for(unsigned int s = begin; s < end; s++) {
+
+                        unsigned int i = springs->first[s];
+                        unsigned int j = springs->second[s];
+
+                        float wSum = w[i] + w[j];
+                        if(wSum == 0.0f) continue;
+
+                        glm::vec3 d = x[i] - x[j];
+                        float length = glm::length(d);
+                        if(length == 0.0f) continue;
+
+                        glm::vec3 n = d / length;
+                        float C = length - springs->restLength[s];
+
+                        // alpha~ = compliance / h^2, gamma = alpha~ * (h^2 * damping) / h
+                        float alpha = compliance[springs->type[s]] / (h * h);
+                        float gamma = compliance[springs->type[s]] * damping[springs->type[s]] / h;
+                        float dCdt = glm::dot(n, (x[i] - x0[i]) - (x[j] - x0[j]));
+
+                        float dLambda = (-C - alpha * l[s] - gamma * dCdt) / ((1.0f + gamma) * wSum + alpha);
+                        l[s] += dLambda;
+
+                        x[i] += (w[i] * dLambda) * n;
+                        x[j] -= (w[j] * dLambda) * n;
+                    }
+                });
+        }
+    }
+
+    for(unsigned int i = 0; i < state.size(); i++) {
+        if(state.isPinned(i)) continue;
+        state.velocity[i] = (state.position[i] - previous[i]) / h;
+    }
+}
+
+
+void XPBDIntegrator::reportMemory(MemoryReport &report) {
+    report.add("integrator", "XPBD previous", previous);
+    report.add("integrator", "XPBD weight", weight);
+    report.add("integrator", "XPBD lambda", lambda);
+}
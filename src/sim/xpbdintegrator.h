@@ -0,0 +1,51 @@
+#ifndef XPBDINTEGRATOR_H
+#define XPBDINTEGRATOR_H
+
+// Constraint material, compliance is the inverse of the stiffness and the damping is in
+// seconds. Bending is much softer than the structure so the cloth folds.
+#define XPBD_STRUCTURAL_COMPLIANCE 1e-6f
+#define XPBD_STRUCTURAL_DAMPING 1e-4f
+#define XPBD_SHEAR_COMPLIANCE 1e-5f
+#define XPBD_SHEAR_DAMPING 1e-4f
+#define XPBD_BEND_COMPLIANCE 1e-3f
+#define XPBD_BEND_DAMPING 1e-4f
+
+// Gauss-Seidel sweeps over all constraints per step
+#define XPBD_ITERATIONS 10
+
+// Stable for any step, but the constraints get softer with longer steps
+#define XPBD_MAX_STEP (1.0f / 240.0f)
+
+#include <vector>
+#include "integrator.h"
+
+/*
+ * XPBDIntegrator class
+ *  Extended position based dynamics. The springs are treated as distance constraints with a
+ *  compliance instead of a stiffness: the knots are moved to predicted positions by the
+ *  external forces and then projected onto the constraints, and the velocities are taken
+ *  from how far the knots moved. Unconditionally stable, so a few steps per frame are enough.
+ *
+ *  The constraints are solved Gauss-Seidel style one spring colour at a time, no two
+ *  constraints in a colour share a knot so each colour is split between the threads.
+ */
+
+class XPBDIntegrator : public Integrator {
+
+public:
+    void applyForces(ClothState &, ClothForces &, const glm::vec3, float);
+    void integrate(ClothState &, ClothForces &, const glm::vec3, float);
+
+    float getMaxStep(const ClothState &, ClothForces &) { return XPBD_MAX_STEP; };
+    unsigned int getType() { return INTEGRATOR_XPBD; };
+    void reportMemory(MemoryReport &);
+
+private:
+    void resize(unsigned int, unsigned int);
+
+    std::vector<glm::vec3> previous;    // Positions at the start of the step
+    std::vector<float> weight;          // Inverse masses, 0 for pinned knots
+    std::vector<float> lambda;          // Accumulated multiplier of every constraint
+};
+
+#endif // XPBDINTEGRATOR_H
@@ -1,10 +1,10 @@
 #include "sphere.h"
 
 Sphere::Sphere(float r, glm::vec3 p, glm::vec3 v)
-    : radius(r), position(p), initial_position(p), velocity(v) {
+    : collider(r, p, v) {
 
     _isStatic = false;
-    obj_mesh = new sgct_utils::SGCTSphere(r * 0.96f, 20);
+    obj_mesh = new sgct_utils::SGCTSphere(r * 0.96f, SPHERE_SEGMENTS);
 
     ambient = glm::vec4(0.3f, 0.3f, 0.3f, 1.0f);
     diffuse = glm::vec4(0.8f, 0.8f, 0.8f, 1.0f);
@@ -17,7 +17,7 @@ void Sphere::draw(glm::mat4& MVP, glm::mat4& MV, glm::mat4& MV_light, glm::mat3&
 
     glm::mat4 _MVP = MVP;
 
-    glm::mat4 scene_mat = glm::translate(glm::mat4(1.0f), position);
+    glm::mat4 scene_mat = glm::translate(glm::mat4(1.0f), collider.getPosition());
     _MVP = MVP * scene_mat;
 
     sgct::ShaderManager::instance()->bindShaderProgram("sphere");
@@ -68,29 +68,7 @@ void Sphere::init(glm::vec3 lightPos) {
 }
 
 
-void Sphere::reset() {
-    position = initial_position;
-    velocity = glm::vec3(0.0f, 0.0f, 0.0f);
+void Sphere::reportMemory(MemoryReport &report) {
+    report.add("shapes", "Sphere", sizeof(Sphere) + sizeof(sgct_utils::SGCTSphere));
+    report.add("GL buffers", "spheres", getSGCTSphereBytes(SPHERE_SEGMENTS));
 }
-
-
-void Sphere::resolveCollision(Knot *k) {
-
-    float dist = glm::length(k->getPosition() - position);
-
-    // Do we have a collision between a sphere and a mesh knot?
-    if(dist < radius) {
-
-        glm::vec3 intersection_normal = glm::normalize(k->getPosition() - position);
-        float penetration = radius - dist;
-
-        glm::vec3 pos = k->getPosition();
-
-        // Separate objects and set velocity to zero
-        pos += (2.0f * penetration) * intersection_normal;
-        k->setPosition(pos);
-        glm::vec3 v = k->getVelocity();
-        k->setVelocity(v * 0.8f);
-    }
-}
-
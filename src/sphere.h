@@ -2,15 +2,17 @@
 #define SPHERE_H
 
 #define SPHERE_SHAPE 2
+#define SPHERE_SEGMENTS 20
 
 #include <iostream>
 #include <vector>
 #include "sgct.h"
 #include "shape.h"
+#include "spherecollider.h"
 
 /*
  * Sphere class
- *  This class handles the collisions of a collision sphere and knots
+ *  This class draws a collision sphere, the collisions with the knots are in SphereCollider
  */
 
 class Sphere : public Shape {
@@ -24,24 +26,21 @@ public:
     // Member functions
     void draw(glm::mat4&, glm::mat4&, glm::mat4&, glm::mat3&, unsigned int);
     void init(glm::vec3);
-    void reset();
-
-    void resolveCollision(Knot *);
+    void reset() { collider.reset(); };
+    void reportMemory(MemoryReport &);
 
     // Setters
-    void setPosition(glm::vec3 p) { this->position = p; };
-    void setVelocity(glm::vec3 v) { this->velocity = v; };
+    void setPosition(glm::vec3 p) { collider.setPosition(p); };
+    void setVelocity(glm::vec3 v) { collider.setVelocity(v); };
     void setBodyStatic(int indx) { this->_isStatic = true; };
 
     // Getters
     unsigned int getType() { return SPHERE_SHAPE; };
-    glm::vec3 getPosition() { return this->position; };
+    glm::vec3 getPosition() { return collider.getPosition(); };
+    Collider * getCollider() { return &collider; };
 
 private:
-    float radius;
-    glm::vec3 position;
-    glm::vec3 initial_position;
-    glm::vec3 velocity;
+    SphereCollider collider;
     bool _isStatic;
 
     sgct_utils::SGCTSphere *obj_mesh;